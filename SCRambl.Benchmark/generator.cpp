@@ -0,0 +1,134 @@
+/****************************************************/
+// SCRambl - generator.cpp
+// Synthetic scripts for benchmarking whole builds
+/****************************************************/
+
+#include "stdafx.h"
+#include "generator.h"
+
+namespace {
+	// same numbers every time, so runs can be compared
+	class Random {
+	public:
+		Random(uint32_t seed) : m_Seed(seed)
+		{ }
+
+		inline size_t Next(size_t n) {
+			m_Seed = m_Seed * 1103515245 + 12345;
+			return n ? (m_Seed >> 16) % n : 0;
+		}
+
+	private:
+		uint32_t m_Seed;
+	};
+
+	size_t CountLines(const std::string& str) {
+		return std::count(str.begin(), str.end(), '\n');
+	}
+
+	bool WriteFile(const std::string& path, const std::string& str) {
+		std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+		file.write(str.data(), str.size());
+		return !!file;
+	}
+
+	std::string MacroName(size_t inc, size_t macro) {
+		return "BENCH_INC" + std::to_string(inc) + "_M" + std::to_string(macro);
+	}
+
+	// An include file - guarded, full of macros for the scripts to use
+	std::string GenerateInclude(const ScriptShape& shape, size_t index) {
+		std::ostringstream ss;
+		ss << "// generated by SCRambl.Benchmark\n"
+			<< "#ifndef BENCH_INC" << index << "\n"
+			<< "#define BENCH_INC" << index << "\n";
+		for (size_t i = 0; i < shape.Macros; ++i)
+			ss << "#define " << MacroName(index, i) << " " << (i * 37 + index) % 1000 << "\n";
+		ss << "#endif\n";
+		return ss.str();
+	}
+
+	// A script - variable declarations, then labelled blocks of commands, expressions and conditional code
+	std::string GenerateScript(const ScriptShape& shape, size_t index, const std::vector<std::string>& includes) {
+		Random rand(0x5CAB + static_cast<uint32_t>(index));
+		auto prefix = "f" + std::to_string(index) + "_";
+		auto var = [&](size_t i){ return prefix + "v" + std::to_string(i); };
+		auto label = [&](size_t i){ return prefix + "b" + std::to_string(i); };
+		// a macro if there are any, otherwise just a number
+		auto value = [&](size_t n){
+			return shape.Includes && shape.Macros ? MacroName(rand.Next(shape.Includes), rand.Next(shape.Macros)) : std::to_string(rand.Next(n));
+		};
+
+		std::ostringstream ss;
+		ss << "// generated by SCRambl.Benchmark\n";
+		for (auto& inc : includes)
+			ss << "#include \"" << inc << "\"\n";
+
+		size_t num_vars = shape.Variables ? shape.Variables : 1;
+		for (size_t i = 0; i < num_vars; ++i)
+			ss << (i % 8 ? " " : i ? "\nVAR_INT " : "VAR_INT ") << var(i);
+		ss << "\n\n";
+
+		for (size_t b = 0; b < shape.Blocks; ++b) {
+			auto v = var(rand.Next(num_vars));
+			ss << label(b) << ":\n"
+				<< "\tWAIT " << value(1000) << "\n"
+				<< "\t" << v << " = " << rand.Next(1000) << "\n"
+				<< "\t" << v << " += " << value(100) << "\n";
+
+			// conditional code, nested as deep as asked
+			std::string indent = "\t";
+			for (size_t d = 0; d < shape.Depth; ++d) {
+				if (d % 2) ss << "#ifdef BENCH_INC" << rand.Next(shape.Includes ? shape.Includes : 1) << "\n";
+				else ss << "#if " << value(1000) << " > " << rand.Next(1000) << "\n";
+				indent += "\t";
+			}
+			switch (rand.Next(5)) {
+			case 0: ss << indent << "SET_TIME_OF_DAY " << rand.Next(24) << " " << rand.Next(60) << "\n"; break;
+			case 1: ss << indent << "DO_FADE 1 " << value(2000) << "\n"; break;
+			case 2: ss << indent << "GENERATE_RANDOM_INT_IN_RANGE 0 " << rand.Next(1000) + 1 << " " << v << "\n"; break;
+			case 3: ss << indent << "ADD_SCORE " << v << " " << rand.Next(100) << "\n"; break;
+			case 4: ss << indent << "SHAKE_CAM " << value(500) << "\n"; break;
+			}
+			for (size_t d = shape.Depth; d--;) {
+				indent.pop_back();
+				ss << "#else\n"
+					<< indent << v << " -= 1\n"
+					<< "#endif\n";
+			}
+
+			if (b && !rand.Next(4))
+				ss << "\tGOTO " << label(rand.Next(b)) << "\n";
+			ss << "\n";
+		}
+		ss << "\tGOTO " << label(0) << "\n";
+		return ss.str();
+	}
+}
+
+GeneratedScripts GenerateScripts(const ScriptShape& shape, const std::string& prefix) {
+	GeneratedScripts scripts;
+
+	std::vector<std::string> includes;
+	size_t include_lines = 0;
+	for (size_t i = 0; i < shape.Includes; ++i) {
+		auto path = prefix + "inc" + std::to_string(i) + ".sch";
+		auto str = GenerateInclude(shape, i);
+		if (!WriteFile(path, str))
+			throw std::runtime_error("failed to write '" + path + "'");
+		includes.emplace_back(path);
+		include_lines += CountLines(str);
+		scripts.Bytes += str.size();
+	}
+
+	for (size_t i = 0; i < shape.Files; ++i) {
+		auto path = prefix + std::to_string(i) + ".sc";
+		auto str = GenerateScript(shape, i, includes);
+		if (!WriteFile(path, str))
+			throw std::runtime_error("failed to write '" + path + "'");
+		scripts.Files.emplace_back(path);
+		scripts.Lines += CountLines(str) + include_lines;
+		scripts.Bytes += str.size();
+	}
+	return scripts;
+}
@@ -0,0 +1,25 @@
+/****************************************************/
+// SCRambl - generator.h
+// Synthetic scripts for benchmarking whole builds
+/****************************************************/
+#pragma once
+
+// How big and busy the generated scripts are
+struct ScriptShape {
+	size_t Files = 4;			// script files, built together
+	size_t Blocks = 2000;		// labelled blocks in each file (about a dozen lines each)
+	size_t Variables = 64;		// variables declared in each file
+	size_t Includes = 2;		// include files, each included by every script
+	size_t Macros = 32;			// macros defined by each include file
+	size_t Depth = 2;			// how deep the #if's in each block go
+};
+
+// What was generated
+struct GeneratedScripts {
+	std::vector<std::string> Files;		// the scripts to build (the includes aren't listed)
+	size_t Lines = 0;					// lines of source the preprocessor goes through, includes and all
+	size_t Bytes = 0;
+};
+
+// Write out scripts of the given shape for the GTA:SA definitions, prefixing all the file names
+GeneratedScripts GenerateScripts(const ScriptShape& shape, const std::string& prefix);
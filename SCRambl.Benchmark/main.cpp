@@ -0,0 +1,353 @@
+/****************************************************/
+// SCRambl - main.cpp
+// Benchmarks for the hottest loops of a build, and for each task of a whole build
+// Build it with SCRambl.Benchmark.vcxproj (part of SCRambl.sln), the library is MSVC-only
+/****************************************************/
+
+#include "stdafx.h"
+#include "SCRambl.h"
+#include "SCRambl\Symbols.h"
+#include "SCRambl\Compiler.h"
+#include "SCRambl\ObjectFile.h"
+#include "SCRambl\utils\charscan.h"
+#include "generator.h"
+
+using namespace SCRambl;
+using Clock = std::chrono::high_resolution_clock;
+
+// keeps the optimiser from throwing our work away
+volatile size_t g_Sink = 0;
+
+// Run the function a few times and report the best throughput
+void Measure(const std::string& name, size_t bytes, int runs, std::function<size_t()> func) {
+	double best = 0.0;
+	for (int i = 0; i < runs; ++i) {
+		auto start = Clock::now();
+		g_Sink += func();
+		std::chrono::duration<double> secs = Clock::now() - start;
+		if (!i || secs.count() < best) best = secs.count();
+	}
+	std::cout << "  " << std::left << std::setw(28) << name
+		<< std::right << std::fixed << std::setprecision(2) << std::setw(10) << best * 1000.0 << " ms"
+		<< std::setw(10) << (bytes / (1024.0 * 1024.0)) / best << " MB/s\n";
+}
+
+// Something that looks enough like a script to keep the scanners honest
+std::string GenerateSource(size_t size) {
+	static const char* lines[] = {
+		"\tWAIT 0\n",
+		"\tIF IS_PLAYER_PLAYING $player\n",
+		"\t\tCREATE_CAR CHEETAH 2488.5625 -1666.4375 13.34375 car\n",
+		"\t// check whether the mission has been passed yet\n",
+		"\tPRINT_NOW \"M_PASS\" 5000 1\n",
+		"\tGOTO main_loop\n",
+		"/* block comment\n   over a few lines */\n",
+		"\t$counter += 1\n",
+		"\tENDIF\n",
+		"main_loop:\n",
+		"\n",
+		"\tIF $counter >= 10 ?\?/\n\tAND $counter <= 20\n",
+	};
+	std::string str;
+	str.reserve(size + 64);
+	uint32_t seed = 0x5CAB;
+	while (str.size() < size) {
+		seed = seed * 1103515245 + 12345;
+		str += lines[(seed >> 16) % (sizeof(lines) / sizeof(*lines))];
+	}
+	return str;
+}
+
+// Scanning and classifying a big lump of script
+bool RunScannerBenchmarks(size_t megs, int runs) {
+	auto source = GenerateSource(megs << 20);
+	auto data = source.data();
+	auto size = source.size();
+	std::vector<Symbol::Type> types(size);
+
+#if defined(SCRAMBL_SIMD_AVX2)
+	const char* simd = "AVX2";
+#elif defined(SCRAMBL_SIMD_SSE2)
+	const char* simd = "SSE2";
+#else
+	const char* simd = "none";
+#endif
+	std::cout << "SCRambl benchmark - " << megs << " MB of generated script, best of " << runs << " (SIMD: " << simd << ")\n";
+
+	using Newlines = CharScan::Match<'\n'>;
+	using Specials = CharScan::Match<'\n', '?', '\\', '"', '/'>;
+
+	std::cout << "Line splitting\n";
+	Measure("per char", size, runs, [&]{
+		size_t n = 0;
+		for (size_t i = 0; i < size; ++i) if (data[i] == '\n') ++n;
+		return n;
+	});
+	Measure("memchr", size, runs, [&]{
+		size_t n = 0;
+		for (auto p = data, end = data + size; (p = static_cast<const char*>(memchr(p, '\n', end - p))); ++p) ++n;
+		return n;
+	});
+	Measure("CharScan (scalar)", size, runs, [&]{
+		size_t n = 0;
+		CharScan::ForEachScalar<Newlines>(data, size, [&n](size_t){ ++n; return true; });
+		return n;
+	});
+	Measure("CharScan", size, runs, [&]{
+		size_t n = 0;
+		CharScan::ForEach<Newlines>(data, size, [&n](size_t){ ++n; return true; });
+		return n;
+	});
+
+	std::cout << "Special characters (newlines, trigraphs, splices, quotes, comments)\n";
+	Measure("CharScan (scalar)", size, runs, [&]{
+		size_t n = 0;
+		CharScan::ForEachScalar<Specials>(data, size, [&n](size_t){ ++n; return true; });
+		return n;
+	});
+	Measure("CharScan", size, runs, [&]{
+		size_t n = 0;
+		CharScan::ForEach<Specials>(data, size, [&n](size_t){ ++n; return true; });
+		return n;
+	});
+
+	std::cout << "Symbol classification\n";
+	Measure("Symbol per char", size, runs, [&]{
+		for (size_t i = 0; i < size; ++i) types[i] = Symbol(data[i]).GetType();
+		return static_cast<size_t>(types[size / 2]);
+	});
+	Measure("Symbol::ClassifyScalar", size, runs, [&]{
+		Symbol::ClassifyScalar(data, size, types.data());
+		return static_cast<size_t>(types[size / 2]);
+	});
+	Measure("Symbol::Classify", size, runs, [&]{
+		Symbol::Classify(data, size, types.data());
+		return static_cast<size_t>(types[size / 2]);
+	});
+
+	// make sure the fast paths agree with the table
+	std::vector<Symbol::Type> check(size);
+	Symbol::ClassifyScalar(data, size, check.data());
+	if (check != types) {
+		std::cerr << "Symbol::Classify disagrees with Symbol::ClassifyScalar!\n";
+		return false;
+	}
+	return true;
+}
+
+// Times of each task of one build
+struct BuildTimes {
+	double Setup = 0.0;				// loading definitions and input files
+	double Tasks[Engine::finished];
+	size_t Tokens = 0;				// tokens left by the preprocessor
+
+	BuildTimes() : Tasks()
+	{ }
+};
+
+// Build the files from scratch, timing each task as it goes
+bool TimeBuild(const std::string& build_file, const std::string& config, const std::vector<std::string>& files, BuildTimes& times) {
+	Engine engine;
+	if (!engine.LoadBuildFile(build_file, config)) {
+		std::cerr << "failed to load build configuration '" << config << "' from '" << build_file << "'\n";
+		return false;
+	}
+
+	// the build reports every event, which would be timing the console
+	auto cout_buf = std::cout.rdbuf(nullptr);
+	auto cerr_buf = std::cerr.rdbuf(nullptr);
+	bool ok = true;
+	Build* build = nullptr;
+	try {
+		auto start = Clock::now();
+		build = engine.InitBuild(files);
+		auto last = Clock::now();
+		times.Setup = std::chrono::duration<double>(last - start).count();
+
+		// each step is put down to the task that was run by it (Run only moves on to the next task the step after)
+		bool preprocessed = false;
+		while (engine.BuildScript(build)) {
+			auto now = Clock::now();
+			auto task = build->GetCurrentTaskID();
+			if (task >= 0 && task < Engine::finished)
+				times.Tasks[task] += std::chrono::duration<double>(now - last).count();
+			if (!preprocessed && task > Engine::preprocessor) {
+				times.Tokens = build->GetScript().GetTokens().Size();
+				preprocessed = true;
+			}
+			last = now;
+		}
+		if (!preprocessed) times.Tokens = build->GetScript().GetTokens().Size();
+	}
+	catch (const std::exception& ex) {
+		std::cerr.rdbuf(cerr_buf);
+		std::cerr << "build failed: " << ex.what() << "\n";
+		cerr_buf = std::cerr.rdbuf(nullptr);
+		ok = false;
+	}
+	if (build) engine.FreeBuild(build);
+
+	std::cout.rdbuf(cout_buf);
+	std::cerr.rdbuf(cerr_buf);
+	std::cout.clear();
+	std::cerr.clear();
+	return ok;
+}
+
+// Make sure a label offset left in a half-packed value isn't patched into whatever's output after it
+bool CheckPackedRelocations() {
+	using Compiling::DataVal;
+	using Compiling::ValuePacker;
+	std::string code;
+	ObjectFile object;
+	{
+		OutputWriter out(0x100);
+		out.Open(std::make_unique<MemoryOutputSink>(code));
+		ValuePacker pack(out, &object);
+		std::string label = "label";
+		DataVal value;
+		value.uint64 = 0;
+
+		// two 16-bit values packed into a 32-bit one, the label offset first
+		pack.Value(value, 16, 32, &label);
+		value.uint64 = 0xBEEF;
+		pack.Value(value, 16, 32);
+
+		// the label offset again, but the data ends with it half-packed
+		pack.Reset();
+		value.uint64 = 0;
+		pack.Value(value, 16, 32, &label);
+
+		// ...so the next value goes where it would've
+		pack.Reset();
+		value.uint64 = 0xFFFFFFFF;
+		pack.Value(value, 32, 32);
+
+		object.AddLabel(label, 0x123, false);
+		auto code_size = out.Size();
+		object.WriteTables(out, code_size);
+		out.Close();
+	}
+
+	// link it, as the linker would
+	ObjectFile linked;
+	if (!linked.Read(code.data(), code.size()) || linked.GetRelocations().size() != 1) {
+		std::cerr << "ValuePacker left a relocation for a value that was never output!\n";
+		return false;
+	}
+	std::string image;
+	std::vector<uint32_t> out_of_range;
+	{
+		OutputWriter out(0x100);
+		out.Open(std::make_unique<MemoryOutputSink>(image));
+		std::vector<uint64_t> targets(linked.GetRefs().size(), linked.FindLabel("label")->Offset);
+		linked.Relocate(out, code.data(), targets, out_of_range);
+		out.Close();
+	}
+	uint32_t values[2] = { 0, 0 };
+	if (image.size() == sizeof(values)) memcpy(values, image.data(), sizeof(values));
+	if (!out_of_range.empty() || values[0] != 0xBEEF0123 || values[1] != 0xFFFFFFFF) {
+		std::cerr << "Linking packed label offsets went wrong!\n";
+		return false;
+	}
+	return true;
+}
+
+// Building generated scripts, timing the preprocessor, parser, compiler and linker separately
+bool RunPipelineBenchmarks(const ScriptShape& shape, const std::string& build_file, const std::string& config, int runs) {
+	if (!CheckPackedRelocations())
+		return false;
+
+	auto scripts = GenerateScripts(shape, "bench_");
+	std::cout << "Build '" << config << "' - " << scripts.Files.size() << " generated scripts, "
+		<< scripts.Lines << " lines, " << std::fixed << std::setprecision(2) << scripts.Bytes / (1024.0 * 1024.0) << " MB, best of " << runs << "\n";
+
+	// best of each, as with the rest
+	BuildTimes best;
+	for (int i = 0; i < runs; ++i) {
+		BuildTimes times;
+		if (!TimeBuild(build_file, config, scripts.Files, times))
+			return false;
+		if (!i) best = times;
+		else {
+			if (times.Setup < best.Setup) best.Setup = times.Setup;
+			for (int t = 0; t < Engine::finished; ++t)
+				if (times.Tasks[t] < best.Tasks[t]) best.Tasks[t] = times.Tasks[t];
+		}
+	}
+
+	static const char* names[] = { "Preprocessing", "Parsing", "Compiling", "Linking" };
+	std::cout << "  " << std::left << std::setw(28) << "Setup"
+		<< std::right << std::setw(10) << best.Setup * 1000.0 << " ms\n";
+	for (int t = 0; t < Engine::finished; ++t) {
+		auto secs = best.Tasks[t];
+		std::cout << "  " << std::left << std::setw(28) << names[t]
+			<< std::right << std::setw(10) << secs * 1000.0 << " ms";
+		if (secs > 0.0) {
+			std::cout << std::setprecision(0) << std::setw(14) << scripts.Lines / secs << " lines/s"
+				<< std::setw(14) << best.Tokens / secs << " tokens/s" << std::setprecision(2);
+		}
+		std::cout << "\n";
+	}
+	std::cout << "  " << best.Tokens << " tokens\n";
+	return true;
+}
+
+void PrintUsage() {
+	std::cout << "Syntax: SCRambl.Benchmark [-scanners | -pipeline] [options]\n"
+		<< "  -mb <n>        MB of generated source for the scanners (16)\n"
+		<< "  -runs <n>      runs of each benchmark, the best one is shown (5)\n"
+		<< "  -build <path>  build file for the pipeline (build/build.xml - run it from the env directory)\n"
+		<< "  -config <id>   build configuration to use (cleo_sa)\n"
+		<< "  -files <n>     generated script files (4)\n"
+		<< "  -blocks <n>    labelled blocks in each file (2000)\n"
+		<< "  -vars <n>      variables declared in each file (64)\n"
+		<< "  -includes <n>  include files, each included by every script (2)\n"
+		<< "  -macros <n>    macros defined in each include file (32)\n"
+		<< "  -depth <n>     nesting of #if in each block (2)\n";
+}
+
+int main(int argc, char* argv[]) {
+	size_t megs = 16;
+	int runs = 5;
+	bool scanners = true, pipeline = true;
+	std::string build_file = "build/build.xml", config = "cleo_sa";
+	ScriptShape shape;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		auto number = [&](size_t def){
+			return i + 1 < argc ? std::strtoul(argv[++i], nullptr, 10) : def;
+		};
+		if (arg == "-scanners") pipeline = false;
+		else if (arg == "-pipeline") scanners = false;
+		else if (arg == "-mb") megs = number(megs);
+		else if (arg == "-runs") runs = static_cast<int>(number(runs));
+		else if (arg == "-build" && i + 1 < argc) build_file = argv[++i];
+		else if (arg == "-config" && i + 1 < argc) config = argv[++i];
+		else if (arg == "-files") shape.Files = number(shape.Files);
+		else if (arg == "-blocks") shape.Blocks = number(shape.Blocks);
+		else if (arg == "-vars") shape.Variables = number(shape.Variables);
+		else if (arg == "-includes") shape.Includes = number(shape.Includes);
+		else if (arg == "-macros") shape.Macros = number(shape.Macros);
+		else if (arg == "-depth") shape.Depth = number(shape.Depth);
+		else {
+			PrintUsage();
+			return arg == "-h" || arg == "-help" ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+	if (!megs) megs = 16;
+	if (runs <= 0) runs = 5;
+
+	try {
+		if (scanners && !RunScannerBenchmarks(megs, runs))
+			return EXIT_FAILURE;
+		if (pipeline && !RunPipelineBenchmarks(shape, build_file, config, runs))
+			return EXIT_FAILURE;
+	}
+	catch (const std::exception& ex) {
+		std::cerr << "benchmark failed: " << ex.what() << "\n";
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <assert.h>
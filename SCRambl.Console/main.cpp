@@ -44,12 +44,37 @@ void CheckCommandLine(const CCLP& cmdParser) {
 				else if (help == "l")
 					std::cout << "Sets the project file path. Without -p this loads a project, otherwise it sets the save path.\n"
 					<< "Syntax: -l <filename>";
+				else if (help == "s")
+					std::cout << "Prints the time taken and work done by each task of the build once it's finished.\n"
+					<< "Syntax: -s or --stats";
+				else if (help == "t")
+					std::cout << "Writes a trace of the build, which can be opened with chrome://tracing or ui.perfetto.dev.\n"
+					<< "Syntax: -t <filename>";
+				else if (help == "c")
+					std::cout << "Precompiles a header for every input file that includes it, optionally keeping it in a file for the next build.\n"
+					<< "Syntax: -c <header> <filename (optional)>";
 			}
 			throw return_exception(EXIT_SUCCESS);
 		}
 	}
 }
 
+void PrintStats(SCRamblInst* inst) {
+	static const char* names[SCRAMBLTASK_MAX] = { "Preprocessor", "Parser", "Compiler", "Linker", "Setup", "Total" };
+
+	std::cout << "\n" << std::left << std::setw(14) << "Task" << std::right
+		<< std::setw(12) << "ms" << std::setw(12) << "tokens" << std::setw(10) << "macros" << std::setw(10) << "includes"
+		<< std::setw(10) << "commands" << std::setw(12) << "bytes" << std::setw(12) << "allocs" << std::setw(10) << "skipped" << "\n";
+	for (int i = 0; i < SCRAMBLTASK_MAX; ++i) {
+		SCRamblStats stats;
+		if (!SCRambl_GetStats(inst, static_cast<SCRamblTask>(i), &stats)) continue;
+		std::cout << std::left << std::setw(14) << names[i] << std::right
+			<< std::setw(12) << std::fixed << std::setprecision(2) << stats.Seconds * 1000.0
+			<< std::setw(12) << stats.Tokens << std::setw(10) << stats.MacrosExpanded << std::setw(10) << stats.IncludesOpened
+			<< std::setw(10) << stats.CommandsResolved << std::setw(12) << stats.BytesEmitted << std::setw(12) << stats.Allocations << std::setw(10) << stats.IncludesSkipped << "\n";
+	}
+}
+
 class SCRamblProc
 {
 	SCRamblInst* m_inst = nullptr;
@@ -85,11 +110,14 @@ int main(int argc, char* argv[])
 		CCLP CmdParser({ argv + 1, &argv[argc] });
 
 		CmdParser.AddFlag("build", 'b');
+		CmdParser.AddFlag("precompile", 'c');
 		CmdParser.AddFlag("format", 'f');
 		CmdParser.AddFlag("help", 'h');
 		CmdParser.AddFlag("load", 'l');
 		CmdParser.AddFlag("output", 'o');
 		CmdParser.AddFlag("project", 'p');
+		CmdParser.AddFlag("stats", 's');
+		CmdParser.AddFlag("trace", 't');
 		CmdParser.Parse();
 
 		std::cout << "SCRambl Advanced SCR Compiler/Assembler\n";
@@ -112,6 +140,13 @@ int main(int argc, char* argv[])
 		}
 		else
 		{
+			auto& trace = CmdParser.GetFlagOpts("trace");
+			if (!trace.empty())
+				SCRambl_SetTraceFile(scrambl, trace.front().c_str());
+			auto& precompile = CmdParser.GetFlagOpts("precompile");
+			if (!precompile.empty())
+				SCRambl_SetPrecompiledHeader(scrambl, precompile.front().c_str(), precompile.size() > 1 ? std::next(precompile.begin())->c_str() : nullptr);
+
 			bool init = true;
 			while (SCRambl_Build(scrambl)) {
 				if (init) {
@@ -119,6 +154,9 @@ int main(int argc, char* argv[])
 					init = false;
 				}
 			}
+
+			if (CmdParser.IsFlagSet("stats"))
+				PrintStats(scrambl);
 		}
 	}
 	catch (return_exception& ex) {
@@ -289,11 +327,12 @@ int main(int argc, char* argv[])
 				auto script_file = pos.GetLine().GetFile();
 				auto error_id = id.Get<SCRambl::Preprocessor::Error>();
 				bool fatal = error_id >= Error::fatal_begin && error_id <= Error::fatal_end;
+				bool warning = error_id >= Error::warning_begin && error_id < Error::warning_end;
 
 				// "  %s(%d,%d)> {fatal} error(%d) : "
 				// e.g. "  file.sc(6,9)> fatal error(4001) : "
 				std::cerr	<< "  " << script_file->GetPath() << "(" << pos.GetLine() << "," << pos.GetColumn()
-							<< ")> " << (fatal ? "fatal error" : "error") << "(" << error_id << ") : ";
+							<< ")> " << (fatal ? "fatal error" : (warning ? "warning" : "error")) << "(" << error_id << ") : ";
 
 				// 
 				switch (id.Get<SCRambl::Preprocessor::Error>()) {
@@ -339,6 +378,14 @@ int main(int argc, char* argv[])
 					break;
 				case Error::dir_expected_file_name: std::cerr << "'" << params[0] << "' expected a file name";
 					break;
+				case Error::macro_unterminated_args: std::cerr << "unterminated argument list invoking macro '" << params[0] << "'";
+					break;
+				case Error::macro_wrong_number_of_args: std::cerr << "wrong number of arguments for macro '" << params[0] << "'";
+					break;
+
+					// warnings
+				case Error::cache_not_isolated: std::cerr << "not using cache '" << params[0] << "' as the input files aren't preprocessed separately (set more than 1 thread)";
+					break;
 				}
 
 				std::cerr << "\n";
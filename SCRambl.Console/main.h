@@ -39,9 +39,14 @@ public:
 					// --fullflag
 					++arg;
 					cmd = arg;
-					cmd.erase(cmd.find_first_of(":="));
+					{
+						auto f = cmd.find_first_of(":=");
+						if (f != cmd.npos) cmd.erase(f);
+					}
 					arg += cmd.length();
-					++arg;
+					m_Options[cmd];
+
+					if (*arg == ':' || *arg == '=') ++arg;
 					break;
 				default:
 					// A char flag -f
@@ -8,6 +8,7 @@
 //#include <tchar.h>
 #include <stdlib.h>
 #include <iostream>
+#include <iomanip>
 #include <sstream>
 #include <fstream>
 #include <list>
@@ -55,6 +55,46 @@ SCRAMBLAPI bool SCRambl_LoadBuildConfig(SCRamblInst* inst, const char* file, con
 	inst->Status = MakeStatus(SCRAMBLRC_OK);
 	return true;
 }
+SCRAMBLAPI bool SCRambl_SetTraceFile(SCRamblInst* inst, const char* path) {
+	auto config = inst->Inst->Engine.GetBuildConfig();
+	if (!config) return false;
+	config->SetTracePath(path ? path : "");
+	return true;
+}
+SCRAMBLAPI bool SCRambl_SetPrecompiledHeader(SCRamblInst* inst, const char* header, const char* path) {
+	auto config = inst->Inst->Engine.GetBuildConfig();
+	if (!config) return false;
+	config->Preprocessing().SetPrecompiledHeader(header ? header : "", path ? path : "");
+	return true;
+}
+SCRAMBLAPI bool SCRambl_SetEvents(SCRamblInst* inst, unsigned int events) {
+	static_assert(SCRAMBLEVENT_TOKENS == SCRambl::EventConfig::TOKENS, "SCRamblEvent out of step with EventConfig::Mask");
+	auto config = inst->Inst->Engine.GetBuildConfig();
+	if (!config) return false;
+	auto mask = static_cast<SCRambl::EventConfig::Mask>(events & SCRambl::EventConfig::ALL);
+	config->Events().SetEventMask(mask);
+	// a build that's already going can change its mind too
+	if (auto build = inst->Inst->Build)
+		build->SetEventMask(mask);
+	return true;
+}
+SCRAMBLAPI bool SCRambl_SetOutputToMemory(SCRamblInst* inst, bool v) {
+	auto config = inst->Inst->Engine.GetBuildConfig();
+	if (!config) return false;
+	config->SetOutputToMemory(v);
+	return true;
+}
+SCRAMBLAPI bool SCRambl_GetOutput(SCRamblInst* inst, const char* path, const char** data, size_t* size) {
+	auto build = inst->Inst->Build;
+	if (!build || !data || !size) return false;
+	const std::string* output = nullptr;
+	if (path) output = build->GetOutput(path);
+	else if (!build->GetOutputs().empty()) output = &build->GetOutputs().begin()->second;
+	if (!output) return false;
+	*data = output->data();
+	*size = output->size();
+	return true;
+}
 SCRAMBLAPI bool SCRambl_Build(SCRamblInst* inst) {
 	auto& engine = inst->Inst->Engine;
 	SCRambl::Build* build;
@@ -64,4 +104,36 @@ SCRAMBLAPI bool SCRambl_Build(SCRamblInst* inst) {
 	}
 	build = inst->Inst->Build;
 	return engine.BuildScript(build);
+}
+SCRAMBLAPI bool SCRambl_GetStats(SCRamblInst* inst, SCRamblTask task, SCRamblStats* out) {
+	static_assert(SCRAMBLTASK_LINKER == SCRambl::Engine::linker, "SCRamblTask out of step with Engine::BuildTask");
+	using SCRambl::Stat;
+	auto build = inst->Inst->Build;
+	if (!build || !out) return false;
+
+	auto& stats = build->GetStats();
+	SCRambl::TaskStats task_stats;
+	switch (task) {
+	case SCRAMBLTASK_SETUP:
+		task_stats = stats.Setup();
+		break;
+	case SCRAMBLTASK_TOTAL:
+		task_stats = stats.Total();
+		break;
+	default:
+		if (task < 0 || task >= SCRAMBLTASK_SETUP) return false;
+		if (auto found = stats.Find(task)) task_stats = *found;
+		break;
+	}
+
+	out->Seconds = task_stats.Seconds;
+	out->Steps = task_stats.Steps;
+	out->Tokens = task_stats[Stat::tokens];
+	out->MacrosExpanded = task_stats[Stat::macros_expanded];
+	out->IncludesOpened = task_stats[Stat::includes_opened];
+	out->CommandsResolved = task_stats[Stat::commands_resolved];
+	out->BytesEmitted = task_stats[Stat::bytes_emitted];
+	out->Allocations = task_stats[Stat::allocations];
+	out->IncludesSkipped = task_stats[Stat::includes_skipped];
+	return true;
 }
\ No newline at end of file
@@ -14,6 +14,8 @@
 	typedef void SCRamblInstance;
 #endif
 
+#include <stddef.h>
+
 // Result codes for SCRambl
 enum SCRamblResultCode {
 	SCRAMBLRC_OK,
@@ -23,6 +25,39 @@ enum SCRamblResultCode {
 	SCRAMBLRC_BUILD_FILE_NOT_FOUND,
 };
 
+// Parts of a build that stats are kept for
+enum SCRamblTask {
+	SCRAMBLTASK_PREPROCESSOR,
+	SCRAMBLTASK_PARSER,
+	SCRAMBLTASK_COMPILER,
+	SCRAMBLTASK_LINKER,
+	SCRAMBLTASK_SETUP,				// loading definitions and such, before the tasks
+	SCRAMBLTASK_TOTAL,				// all of the above together
+	SCRAMBLTASK_MAX
+};
+
+// Fine-grained events a build can send, as flags
+enum SCRamblEvent {
+	SCRAMBLEVENT_NONE = 0,
+	SCRAMBLEVENT_ADDED_TOKEN = 1 << 0,
+	SCRAMBLEVENT_PARSED_TOKEN = 1 << 1,
+	SCRAMBLEVENT_FOUND_TOKEN = 1 << 2,
+	SCRAMBLEVENT_TOKENS = SCRAMBLEVENT_ADDED_TOKEN | SCRAMBLEVENT_PARSED_TOKEN | SCRAMBLEVENT_FOUND_TOKEN
+};
+
+// Time taken and work done by part of a build
+struct SCRamblStats {
+	double Seconds;
+	unsigned long long Steps;
+	unsigned long long Tokens;
+	unsigned long long MacrosExpanded;
+	unsigned long long IncludesOpened;
+	unsigned long long CommandsResolved;
+	unsigned long long BytesEmitted;
+	unsigned long long Allocations;
+	unsigned long long IncludesSkipped;
+};
+
 struct SCRamblStatus {
 	SCRamblResultCode RC;
 };
@@ -51,6 +86,32 @@ SCRAMBLAPI void SCRambl_ClearInputFiles(SCRamblInst*);
 */
 SCRAMBLAPI bool SCRambl_LoadBuildConfig(SCRamblInst*, const char* path, const char* config);
 
+/*/ SCRambl_SetTraceFile - writes a Chrome trace of the next build to the file (after SCRambl_LoadBuildConfig, null or "" for none)
+*/
+SCRAMBLAPI bool SCRambl_SetTraceFile(SCRamblInst*, const char* path);
+
+/*/ SCRambl_SetPrecompiledHeader - precompiles the header once for every input file that includes it, keeping it in the file at path between builds
+	(after SCRambl_LoadBuildConfig, null or "" header for none, null or "" path to keep it for the one build)
+*/
+SCRAMBLAPI bool SCRambl_SetPrecompiledHeader(SCRamblInst*, const char* header, const char* path);
+
+/*/ SCRambl_SetEvents - SCRamblEvent flags of the fine-grained events to send (after SCRambl_LoadBuildConfig, none by default)
+*/
+SCRAMBLAPI bool SCRambl_SetEvents(SCRamblInst*, unsigned int events);
+
+/*/ SCRambl_SetOutputToMemory - keeps output files in memory instead of writing them (after SCRambl_LoadBuildConfig)
+*/
+SCRAMBLAPI bool SCRambl_SetOutputToMemory(SCRamblInst*, bool);
+
+/*/ SCRambl_GetOutput - gets an output file kept in memory by the current build, by path (null for the first, by path)
+ - the data stays valid until the next build step
+*/
+SCRAMBLAPI bool SCRambl_GetOutput(SCRamblInst*, const char* path, const char** data, size_t* size);
+
 /*/
 */
-SCRAMBLAPI bool SCRambl_Build(SCRamblInst*);
\ No newline at end of file
+SCRAMBLAPI bool SCRambl_Build(SCRamblInst*);
+
+/*/ SCRambl_GetStats - gets the stats of part of the current build so far
+*/
+SCRAMBLAPI bool SCRambl_GetStats(SCRamblInst*, SCRamblTask, SCRamblStats*);
\ No newline at end of file
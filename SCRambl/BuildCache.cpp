@@ -0,0 +1,133 @@
+#include "stdafx.h"
+#include "BuildCache.h"
+#include "utils.h"
+#include "utils/MurmurHash3.h"
+
+using namespace SCRambl;
+
+namespace {
+	// 'SCRB'
+	const uint32_t cache_magic = 0x42524353;
+	const uint32_t hash_seed = 0x88664422;
+}
+
+/* BuildCache */
+BuildCache::BuildCache(std::string path, const uint64_t (&definitions)[2]) : m_Path(path) {
+	m_Definitions[0] = definitions[0];
+	m_Definitions[1] = definitions[1];
+}
+bool BuildCache::HashFile(const std::string& path, uint64_t (&hash)[2]) {
+	hash[0] = hash[1] = 0;
+	MappedFile file(path);
+	if (!file.IsOpen()) return false;
+	if (file.Size()) MurmurHash3_x64_128(file.Data(), static_cast<int>(file.Size()), hash_seed, hash);
+	return true;
+}
+bool BuildCache::Open() {
+	m_Loaded.clear();
+	MappedFile file(m_Path);
+	if (!file.IsOpen() || !file.Data()) return false;
+
+	Reader reader(file.Data(), file.Size());
+	if (reader.Read<uint32_t>() != cache_magic || reader.Read<uint32_t>() != version)
+		return false;
+
+	// anything could've been preprocessed differently with other definitions
+	uint64_t definitions[2];
+	definitions[0] = reader.Read<uint64_t>();
+	definitions[1] = reader.Read<uint64_t>();
+	if (!reader.OK() || !SameHash(definitions, m_Definitions))
+		return false;
+
+	// the entries are copied out, the mapping doesn't stay around
+	std::map<std::string, Entry> entries;
+	for (auto n = reader.Read<uint32_t>(); n && reader.OK(); --n) {
+		auto path = reader.ReadString();
+		Entry entry;
+		entry.Hash[0] = reader.Read<uint64_t>();
+		entry.Hash[1] = reader.Read<uint64_t>();
+		for (auto i = reader.Read<uint32_t>(); i && reader.OK(); --i) {
+			entry.Includes.emplace_back(reader.ReadString());
+			entry.Includes.back().Hash[0] = reader.Read<uint64_t>();
+			entry.Includes.back().Hash[1] = reader.Read<uint64_t>();
+		}
+		entry.Precompiled.Path = reader.ReadString();
+		for (auto& hash : entry.Precompiled.Hash)
+			hash = reader.Read<uint64_t>();
+		for (auto& hash : entry.Precompiled.Definitions)
+			hash = reader.Read<uint64_t>();
+		entry.Data = reader.ReadString();
+		if (reader.OK()) entries[path] = std::move(entry);
+	}
+	if (!reader.OK() || !reader.AtEnd())
+		return false;
+
+	m_Loaded = std::move(entries);
+	return true;
+}
+const BuildCache::Entry* BuildCache::Lookup(const std::string& path, const uint64_t (&hash)[2]) {
+	auto it = m_Entries.find(path);
+	if (it == m_Entries.end()) {
+		auto loaded = m_Loaded.find(path);
+		if (loaded == m_Loaded.end()) return nullptr;
+		it = m_Entries.emplace(path, std::move(loaded->second)).first;
+		m_Loaded.erase(loaded);
+	}
+
+	auto& entry = it->second;
+	if (SameHash(entry.Hash, hash)) {
+		bool ok = true;
+		for (auto& inc : entry.Includes) {
+			auto& inc_hash = HashInclude(inc.Path);
+			if (!inc_hash.Found || !SameHash(inc_hash.Hash, inc.Hash)) {
+				ok = false;
+				break;
+			}
+		}
+		if (ok) return &entry;
+	}
+
+	// out of date - it'll only be saved again if it gets replaced
+	m_Entries.erase(it);
+	return nullptr;
+}
+const BuildCache::FileHash& BuildCache::HashInclude(const std::string& path) {
+	auto it = m_IncludeHashes.find(path);
+	if (it == m_IncludeHashes.end()) {
+		FileHash hash;
+		hash.Found = HashFile(path, hash.Hash);
+		it = m_IncludeHashes.emplace(path, hash).first;
+	}
+	return it->second;
+}
+void BuildCache::Store(const std::string& path, Entry entry) {
+	m_Entries[path] = std::move(entry);
+}
+bool BuildCache::Save() const {
+	Writer writer;
+	writer.Write<uint32_t>(cache_magic);
+	writer.Write<uint32_t>(version);
+	writer.Write<uint64_t>(m_Definitions[0]);
+	writer.Write<uint64_t>(m_Definitions[1]);
+	writer.Write<uint32_t>(m_Entries.size());
+	for (auto& pr : m_Entries) {
+		auto& entry = pr.second;
+		writer.Write(pr.first);
+		writer.Write<uint64_t>(entry.Hash[0]);
+		writer.Write<uint64_t>(entry.Hash[1]);
+		writer.Write<uint32_t>(entry.Includes.size());
+		for (auto& inc : entry.Includes) {
+			writer.Write(inc.Path);
+			writer.Write<uint64_t>(inc.Hash[0]);
+			writer.Write<uint64_t>(inc.Hash[1]);
+		}
+		writer.Write(entry.Precompiled.Path);
+		for (auto hash : entry.Precompiled.Hash)
+			writer.Write<uint64_t>(hash);
+		for (auto hash : entry.Precompiled.Definitions)
+			writer.Write<uint64_t>(hash);
+		writer.Write(entry.Data);
+	}
+
+	return SaveFile(m_Path, writer.Buffer());
+}
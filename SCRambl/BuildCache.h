@@ -0,0 +1,83 @@
+/**********************************************************/
+// SCRambl Advanced SCR Compiler/Assembler
+// This program is distributed freely under the MIT license
+// (See the LICENSE file provided
+//	 or copy at http://opensource.org/licenses/MIT)
+/**********************************************************/
+#pragma once
+#include <map>
+#include "DefinitionCache.h"
+
+namespace SCRambl
+{
+	// Cache of the preprocessed output of each input file, so files that haven't changed aren't gone through again
+	// Entries are keyed on the contents of the file and everything it included, the whole cache on the definitions
+	class BuildCache
+	{
+	public:
+		// bump whenever the layout (or what's stored in the entries) changes
+		enum { version = 2 };
+
+		using Writer = DefinitionCache::Writer;
+		using Reader = DefinitionCache::Reader;
+
+		// A file that got included, with the hash of what it had in it then
+		struct Include {
+			std::string Path;
+			uint64_t Hash[2];
+
+			Include(std::string path) : Path(path), Hash()
+			{ }
+		};
+		// The precompiled header a file used - it's applied again to put the file back, so it has to be the same one
+		struct Header {
+			std::string Path;				// empty if there wasn't one
+			uint64_t Hash[2];				// of the header, as in its own entry
+			uint64_t Definitions[2];
+
+			Header() : Hash(), Definitions()
+			{ }
+		};
+		struct Entry {
+			uint64_t Hash[2];
+			std::vector<Include> Includes;	// ...including those of the precompiled header
+			Header Precompiled;
+			std::string Data;
+
+			Entry() : Hash()
+			{ }
+		};
+
+	public:
+		BuildCache(std::string path, const uint64_t (&definitions)[2]);
+
+		// Hash the contents of a file - returns false if it couldn't be read
+		static bool HashFile(const std::string& path, uint64_t (&hash)[2]);
+
+		// Load the entries from the cache file - returns false if there isn't one or it was made with other definitions
+		bool Open();
+		// Get the entry for a file, if it's still good (its includes are hashed again to make sure of it, each once per build)
+		const Entry* Lookup(const std::string& path, const uint64_t (&hash)[2]);
+		// Add or replace the entry for a file
+		void Store(const std::string& path, Entry entry);
+
+		// Write the entries that were used or stored to the cache file - the rest are gone for good
+		bool Save() const;
+
+	private:
+		struct FileHash {
+			bool Found;
+			uint64_t Hash[2];
+		};
+
+		// Hash of an included file, only read the first time it's asked for
+		const FileHash& HashInclude(const std::string& path);
+
+	private:
+		std::string m_Path;
+		uint64_t m_Definitions[2];
+		std::map<std::string, FileHash> m_IncludeHashes;
+		std::map<std::string, Entry> m_Loaded;
+		std::map<std::string, Entry> m_Entries;
+	};
+}
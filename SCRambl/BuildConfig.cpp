@@ -26,6 +26,13 @@ BuildDefinitionPath& BuildConfig::AddDefPath(std::string path) {
 	}
 	return m_DefinitionPaths[id];
 }
+std::string BuildConfig::GetDefinitionCachePath() const {
+	if (!m_UseDefinitionCache) return "";
+	if (!m_DefinitionCachePath.empty()) return m_DefinitionCachePath;
+	// default to keeping it with the first lot of definitions
+	if (m_DefinitionPaths.empty()) return "";
+	return m_DefinitionPaths[0].Path + m_ID + ".defcache";
+}
 size_t BuildConfig::GetDefinitionPathID(std::string path) {
 	auto it = m_DefinitionPathMap.find(path);
 	return it != m_DefinitionPathMap.end() ? it->second : -1;
@@ -78,6 +85,27 @@ BuildConfig::BuildConfig(std::string id, std::string name, XMLConfig* config) :
 		}
 	});
 
+	// <DefinitionCache Path="..." Enabled="true|false" />
+	config->AddClass("DefinitionCache", [](const XMLNode base, void*& obj) {
+		auto ptr = static_cast<BuildConfig*>(obj);
+		if (auto attr = base.GetAttribute("Path"))
+			ptr->SetDefinitionCachePath(attr.GetValue().AsString());
+		if (auto attr = base.GetAttribute("Enabled"))
+			ptr->SetUseDefinitionCache(attr.GetValue().AsBool(true));
+	});
+
+	// <Trace Path="..." />
+	config->AddClass("Trace", [](const XMLNode base, void*& obj) {
+		auto ptr = static_cast<BuildConfig*>(obj);
+		ptr->SetTracePath(base.GetAttribute("Path").GetValue().AsString());
+	});
+
+	// <Events>ADDED_TOKEN|PARSED_TOKEN</Events>
+	config->AddClass("Events", [](const XMLNode base, void*& obj) {
+		auto ptr = static_cast<BuildConfig*>(obj);
+		ptr->Events().SetEventMask(base.GetValue().AsString("NONE"));
+	});
+
 	// <Parse>
 	if (auto parse = config->AddClass("Parse")) {
 		// <Command>
@@ -126,6 +154,26 @@ BuildConfig::BuildConfig(std::string id, std::string name, XMLConfig* config) :
 		// </Level>
 	} // </Optimisation>
 
+	// <Preprocessing>
+	if (auto preprocessing = config->AddClass("Preprocessing")) {
+		// <Threads>
+		auto threads = preprocessing->AddClass("Threads", [](const XMLNode base, void*& obj){
+			auto ptr = static_cast<BuildConfig*>(obj);
+			ptr->Preprocessing().SetNumThreads(base.GetValue().AsNumber<unsigned int>(1));
+		});
+		// </Threads>
+		// <Cache Path="..." />
+		preprocessing->AddClass("Cache", [](const XMLNode base, void*& obj){
+			auto ptr = static_cast<BuildConfig*>(obj);
+			ptr->Preprocessing().SetCachePath(base.GetAttribute("Path").GetValue().AsString());
+		});
+		// <PrecompiledHeader File="..." Path="..." />
+		preprocessing->AddClass("PrecompiledHeader", [](const XMLNode base, void*& obj){
+			auto ptr = static_cast<BuildConfig*>(obj);
+			ptr->Preprocessing().SetPrecompiledHeader(base.GetAttribute("File").GetValue().AsString(), base.GetAttribute("Path").GetValue().AsString());
+		});
+	} // </Preprocessing>
+
 	// <Script>
 	if (auto script = config->AddClass("Script", [](const XMLNode base, void*& obj){
 		auto ptr = static_cast<BuildConfig*>(obj);
@@ -63,7 +63,7 @@ namespace SCRambl
 			enum { op_nop, op_and, op_or } op = op_nop;
 			for (size_t i = 0; i < name.size(); ++i) {
 				size_t j = i;
-				while (std::isalpha(name[i]) || name[i] == '_')
+				while (std::isalpha(static_cast<unsigned char>(name[i])) || name[i] == '_')
 					if (++i == name.size())
 						break;
 				if (j == i) {
@@ -100,6 +100,82 @@ namespace SCRambl
 
 		Level m_Level = ALL;
 	};
+	struct PreprocessingConfig {
+		// Number of threads to preprocess input files on - 1 keeps it all on the build thread, 0 uses one per core
+		inline PreprocessingConfig& SetNumThreads(size_t n) {
+			m_NumThreads = n;
+			return *this;
+		}
+		inline size_t GetNumThreads() const { return m_NumThreads; }
+		// Will input files be preprocessed on more than one thread?
+		inline bool IsParallel() const { return m_NumThreads != 1; }
+		// Cache file for the preprocessed output of each input file - none if empty
+		inline PreprocessingConfig& SetCachePath(std::string path) {
+			m_CachePath = path;
+			return *this;
+		}
+		inline const std::string& GetCachePath() const { return m_CachePath; }
+		inline bool IsCached() const { return !m_CachePath.empty(); }
+		// Header to precompile for any file that includes it, and the file to keep it in between builds - none if empty (and only kept for the build if there's no path)
+		inline PreprocessingConfig& SetPrecompiledHeader(std::string header, std::string path = "") {
+			m_PrecompiledHeader = header;
+			m_PrecompiledPath = path;
+			return *this;
+		}
+		inline const std::string& GetPrecompiledHeader() const { return m_PrecompiledHeader; }
+		inline const std::string& GetPrecompiledPath() const { return m_PrecompiledPath; }
+		inline bool IsPrecompiled() const { return !m_PrecompiledHeader.empty(); }
+		// Will input files be preprocessed separately? (each starting with nothing defined)
+		// Only then is the cache used for more than one input file, as it doesn't know what the files before defined
+		inline bool IsIsolated() const { return IsParallel(); }
+
+		size_t m_NumThreads = 1;
+		std::string m_CachePath;
+		std::string m_PrecompiledHeader;
+		std::string m_PrecompiledPath;
+	};
+	struct EventConfig {
+		// Fine-grained events, sent for every token - the rest (task begin/finish, errors...) are always sent
+		enum Mask {
+			NONE = 0,
+			ADDED_TOKEN = 1 << 0,
+			PARSED_TOKEN = 1 << 1,
+			FOUND_TOKEN = 1 << 2,
+			TOKENS = ADDED_TOKEN | PARSED_TOKEN | FOUND_TOKEN,
+			ALL = TOKENS
+		};
+
+		// Names separated by |, e.g. ADDED_TOKEN|PARSED_TOKEN
+		static Mask GetEventMaskByName(const std::string name) {
+			static const std::unordered_map<std::string, Mask> map = {
+				{ "NONE", NONE }, { "ALL", ALL }, { "TOKENS", TOKENS },
+				{ "ADDED_TOKEN", ADDED_TOKEN }, { "PARSED_TOKEN", PARSED_TOKEN }, { "FOUND_TOKEN", FOUND_TOKEN }
+			};
+			uint32_t mask = NONE;
+			for (size_t i = 0; i < name.size(); ++i) {
+				size_t j = i;
+				while (i < name.size() && (std::isalpha(static_cast<unsigned char>(name[i])) || name[i] == '_'))
+					++i;
+				if (j != i) {
+					auto it = map.find(toupper(name.substr(j, i - j)));
+					if (it != map.end()) mask |= it->second;
+				}
+			}
+			return static_cast<Mask>(mask);
+		}
+
+		inline EventConfig& SetEventMask(Mask mask) {
+			m_Mask = mask;
+			return *this;
+		}
+		inline EventConfig& SetEventMask(const std::string name) {
+			return SetEventMask(GetEventMaskByName(name));
+		}
+		inline Mask GetEventMask() const { return m_Mask; }
+
+		// none by default - builds with nobody watching every token needn't pay for telling them
+		Mask m_Mask = NONE;
+	};
 	struct ParseObjectConfig {
 		enum class ActionType {
 			Clear, Set, Inc, Dec, Add, Sub, Mul, Div, Mod, And, Or, Xor, Shl, Shr, Not
@@ -153,7 +229,27 @@ namespace SCRambl
 		inline const std::vector<std::string>& GetDefinitions() const { return m_Definitions; }
 		inline const std::vector<BuildDefinitionPath>& GetDefinitionPaths() const { return m_DefinitionPaths; }
 
+		inline const std::string& GetID() const { return m_ID; }
+
+		// Definition cache - the path is empty if it's not to be used
+		inline void SetDefinitionCachePath(std::string path) { m_DefinitionCachePath = path; m_UseDefinitionCache = !path.empty(); }
+		inline void SetUseDefinitionCache(bool v) { m_UseDefinitionCache = v; }
+		std::string GetDefinitionCachePath() const;
+
+		// Trace of the build, in the Chrome trace event format - the path is empty if there's to be no trace
+		inline void SetTracePath(std::string path) { m_TracePath = path; }
+		inline const std::string& GetTracePath() const { return m_TracePath; }
+		inline bool IsTraced() const { return !m_TracePath.empty(); }
+
+		// Keep output files in memory rather than writing them out (see Build::GetOutput)
+		inline void SetOutputToMemory(bool v) { m_OutputToMemory = v; }
+		inline bool IsOutputToMemory() const { return m_OutputToMemory; }
+
 		inline OptimisationConfig& Optimisation() { return m_OptimisationConfig; }
+		inline PreprocessingConfig& Preprocessing() { return m_PreprocessingConfig; }
+		inline const PreprocessingConfig& Preprocessing() const { return m_PreprocessingConfig; }
+		inline EventConfig& Events() { return m_EventConfig; }
+		inline const EventConfig& Events() const { return m_EventConfig; }
 
 	protected:
 		const ParseNameVec& GetParseCommands() const { return m_ParseCommandNames; }
@@ -176,6 +272,10 @@ namespace SCRambl
 		std::vector<BuildDefinitionPath> m_DefinitionPaths;
 		std::map<const std::string, size_t> m_DefinitionPathMap;
 		std::vector<std::string> m_Definitions;
+		std::string m_DefinitionCachePath;
+		bool m_UseDefinitionCache = true;
+		std::string m_TracePath;
+		bool m_OutputToMemory = false;
 
 		//
 		ScriptConfigMap m_Scripts;
@@ -184,5 +284,7 @@ namespace SCRambl
 		ParseNameVec m_ParseLabelNames;
 		ParseConfigVec m_ObjectConfigs;
 		OptimisationConfig m_OptimisationConfig;
+		PreprocessingConfig m_PreprocessingConfig;
+		EventConfig m_EventConfig;
 	};
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "stdafx.h"
+#include <chrono>
 #include "utils.h"
 #include "Builder.h"
 #include "Engine.h"
@@ -6,11 +7,12 @@
 
 using namespace SCRambl;
 using namespace SCRambl::Building;
+using Clock = std::chrono::high_resolution_clock;
 
 /* Build */
 ScriptVariable* Build::AddScriptVariable(std::string name, VecRef<Types::Type> type, size_t array_size) {
 	if (auto val = array_size ? type->GetArrayValue() : type->GetVarValue()) {
-		auto var = m_Variables.Add(type.Ptr(), name, array_size);
+		auto var = m_Variables.Add(type.Ptr(), m_Interner.Intern(name), name, array_size);
 		if ((var->Get().Index() + array_size) > var->Get().Value()->GetVarType()->GetVarMaxIndex()) {
 			Event<error_var_out_of_range>(&m_Variables, var);
 		}
@@ -22,19 +24,55 @@ ScriptVariable* Build::AddScriptVariable(std::string name, VecRef<Types::Type> t
 	return nullptr;
 }
 ScriptVariable* Build::GetScriptVariable(std::string name) {
-	auto var = m_Variables.Find(name);
-	return var;
+	// no need to intern it if it's never been seen
+	auto id = m_Interner.Find(name);
+	return id != Interner::none ? m_Variables.Find(id) : nullptr;
+}
+ScriptVariable* Build::GetScriptVariable(const char* name, size_t size) {
+	auto id = m_Interner.Find(name, size);
+	return id != Interner::none ? m_Variables.Find(id) : nullptr;
+}
+std::unique_ptr<OutputSink> Build::CreateOutputFile(const std::string& path) {
+	if (m_Config && m_Config->IsOutputToMemory()) {
+		auto& data = m_Outputs[path];
+		data.clear();
+		return std::make_unique<MemoryOutputSink>(data);
+	}
+	return std::make_unique<FileOutputSink>(path);
+}
+const std::string* Build::GetOutput(const std::string& path) const {
+	auto it = m_Outputs.find(path);
+	return it != m_Outputs.end() ? &it->second : nullptr;
+}
+bool Build::ReadOutput(const std::string& path, std::string& data) const {
+	if (auto output = GetOutput(path)) {
+		data = *output;
+		return true;
+	}
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	if (!file) return false;
+	data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+std::string Build::GetScriptExtension() const {
+	auto& scripts = m_Config->GetScripts();
+	return scripts.empty() ? "" : m_Env.Val(scripts.begin()->second.Ext).AsString();
 }
 ScriptLabel* Build::AddScriptLabel(std::string name, size_t offset) {
 	std::vector<Types::Value*> vals;
 	m_Types.GetValues(Types::ValueSet::Label, 0, vals);
 	if (vals.empty() || vals.size() > 1) BREAK();
-	auto label = m_Labels.Add(vals[0]->GetType().Ptr(), name, offset, vals[0]->Extend<Types::LabelValue>().IsGlobal());
+	auto label = m_Labels.Add(vals[0]->GetType().Ptr(), m_Interner.Intern(name), name, offset, vals[0]->Extend<Types::LabelValue>().IsGlobal());
 	//m_LabelPosMap.emplace(label->Get().Pos(), label);
 	return label;
 }
 ScriptLabel* Build::GetScriptLabel(std::string name) {
-	return m_Labels.Find(name);
+	auto id = m_Interner.Find(name);
+	return id != Interner::none ? m_Labels.Find(id) : nullptr;
+}
+ScriptLabel* Build::GetScriptLabel(const char* name, size_t size) {
+	auto id = m_Interner.Find(name, size);
+	return id != Interner::none ? m_Labels.Find(id) : nullptr;
 }
 /*const ScriptLabel* Build::GetScriptLabel(Label* label) {
 	return m_Labels.Find(label);
@@ -73,7 +111,7 @@ void Build::ParseCommands(const std::multimap<const std::string, Tokens::Iterato
 					if (found_type) {
 						std::string val;
 						auto toke = argit->GetToken();
-						switch (toke->GetType<Tokens::Type>()) {
+						switch (argit->GetType()) {
 						case Tokens::Type::Number:
 							val = toke->Get<Tokens::Number::DummyInfo>().GetValue<Tokens::Number::ScriptRange>().Format();
 							break;
@@ -103,30 +141,86 @@ void Build::ParseCommands(const std::multimap<const std::string, Tokens::Iterato
 	}
 }
 void Build::LoadDefinitions() {
+	// work out what's to be loaded first, as that's what the cache is keyed on
+	std::vector<std::string> files;
 	auto loads = m_Config->GetDefinitions();
-	size_t defs_not_loaded = loads.size();
 	for (auto& defpath : m_Config->GetDefinitionPaths()) {
-		for (auto& def : defpath.Definitions) {
-			if (!LoadXML(defpath.Path + def))
-				++defs_not_loaded;
-		}
+		for (auto& def : defpath.Definitions)
+			files.emplace_back(defpath.Path + def);
 
-		for (auto it = loads.begin(); it != loads.end(); ++it) {
-			if (LoadXML(defpath.Path + *it)) {
+		for (auto it = loads.begin(); it != loads.end();) {
+			if (std::ifstream(defpath.Path + *it)) {
+				files.emplace_back(defpath.Path + *it);
 				it = loads.erase(it);
-				--defs_not_loaded;
 			}
+			else ++it;
+		}
+	}
+
+	auto cache_path = m_Config->GetDefinitionCachePath();
+	DefinitionCache cache(cache_path);
+	m_DefinitionHash[0] = m_DefinitionHash[1] = 0;
+	if (!cache_path.empty() || m_Config->Preprocessing().IsCached()) {
+		for (auto& file : files)
+			cache.AddSource(file);
+		cache.HashSources(m_DefinitionHash);
+	}
+
+	if (cache_path.empty()) {
+		for (auto& file : files)
+			LoadXML(file);
+		return;
+	}
+
+	// the commands are the bulk of it - with a fresh cache, files with nothing else in them don't even get opened
+	static const std::string cached_config = "Commands";
+	if (cache.Open()) {
+		for (auto& source : cache.GetSources()) {
+			if (!source.Found || (source.Configs.size() == 1 && source.HasConfig(cached_config)))
+				continue;
+			LoadXML(source.Path, [](const std::string& name){ return name != cached_config; });
+		}
+		Tracer::Span span(GetTracer(), "definitions", "Reading cached commands", cache_path);
+		if (m_Commands.ReadCache(cache.GetReader(), m_Types))
+			return;
+		span.End();
+
+		// that's not right... load them the slow way after all
+		cache.Close();
+		for (auto& source : cache.GetSources()) {
+			if (source.HasConfig(cached_config))
+				LoadXML(source.Path, [](const std::string& name){ return name == cached_config; });
 		}
 	}
-	//defs_not_loaded = 0;
+	else {
+		// load it all, keeping note of what's in each file for next time
+		for (auto& source : cache.GetSources()) {
+			source.Configs.clear();
+			LoadXML(source.Path, [&source](const std::string& name){
+				if (!source.HasConfig(name)) source.Configs.emplace_back(name);
+				return true;
+			});
+		}
+	}
+
+	cache.Close();
+	DefinitionCache::Writer writer;
+	m_Commands.WriteCache(writer);
+	cache.Save(writer);
 }
 bool Build::LoadXML(std::string path) {
+	return LoadXML(path, nullptr);
+}
+bool Build::LoadXML(std::string path, std::function<bool(const std::string&)> filter) {
+	Tracer::Span span(GetTracer(), "definitions", path);
 	XML xml(path);
 	if (xml) {
 		// load configurations
 		if (m_ConfigMap.size()) {
 			for (auto node : xml.Children()) {
 				if (!node.Name().empty()) {
+					if (filter && !filter(node.Name())) continue;
+
 					// find configuration
 					auto it = m_ConfigMap.find(node.Name());
 					if (it != m_ConfigMap.end()) {
@@ -153,14 +247,21 @@ void Build::Setup() {
 	m_Operators.Init(*this);
 }
 void Build::Init() {
+	Tracer::Span span(GetTracer(), "setup", "Setup");
+	auto start = Clock::now();
 	m_CurrentTask = std::begin(m_Tasks);
 
 	LoadDefinitions();
 	m_Commands.ResolveCommandConstructs(m_Constructs);		//
+	m_Commands.BuildLookup();
 
 	for (auto& scr : m_Config->GetScripts()) {
 		m_BuildScripts.emplace_back(scr.first, m_Env.Val(scr.second.Name).AsString() + m_Env.Val(scr.second.Ext).AsString());
 	}
+
+	std::chrono::duration<double> secs = Clock::now() - start;
+	m_Stats.Setup().Seconds += secs.count();
+	++m_Stats.Setup().Steps;
 }
 bool Build::IsCommandArgParsed(Command* command, unsigned long index) const {
 	if (index < command->NumParams()) {
@@ -199,16 +300,48 @@ const TaskSystem::Task& Build::Run() {
 			}
 			task = it->second.get();
 		}
+
+		// time the step, and see how many tokens it made while we're at it
+		auto& stats = m_Stats.Get(it->first);
+		auto& tokens = m_Script.GetTokens();
+		auto& parse_tokens = m_Script.GetParseTokens();
+		auto num_tokens = tokens.Size() + parse_tokens.Size();
+		auto num_objects = tokens.NumAllocations() + parse_tokens.NumAllocations();
+		m_CurrentStats = &stats;
+		auto start = Clock::now();
+		if (m_TaskStart == Clock::time_point()) m_TaskStart = start;
+
 		task->RunTask();
+
+		std::chrono::duration<double> secs = Clock::now() - start;
+		m_CurrentStats = nullptr;
+		stats.Seconds += secs.count();
+		++stats.Steps;
+		auto new_tokens = tokens.Size() + parse_tokens.Size();
+		auto new_objects = tokens.NumAllocations() + parse_tokens.NumAllocations();
+		if (new_tokens > num_tokens) stats[Stat::tokens] += new_tokens - num_tokens;
+		if (new_objects > num_objects) stats[Stat::allocations] += new_objects - num_objects;
+
+		if (task->IsTaskFinished()) {
+			// the span covers the task from its first step to its last, time spent between steps and all
+			if (m_Tracer) m_Tracer->AddSpan("task", Engine::GetBuildTaskName(it->first), m_TaskStart, Clock::now());
+			m_TaskStart = Clock::time_point();
+			Event<event_task_stats>(it->first, stats);
+		}
 	}
 	return *this;
 }
-Build::Build(Engine& engine, BuildConfig* config) : m_Env(engine), m_Engine(engine), m_Config(config)
+Build::Build(Engine& engine, BuildConfig* config) : m_Env(engine), m_Engine(engine), m_Config(config), m_DefinitionHash()
 {
+	if (m_Config) m_EventMask = m_Config->Events().GetEventMask();
+	if (m_Config && m_Config->IsTraced())
+		m_Tracer = std::make_unique<Tracer>(m_Config->GetTracePath());
+	m_Script.SetSourceCache(&engine.GetSourceCache());
 	Setup();
 }
-Build::~Build()
-{ }
+Build::~Build() {
+	if (m_Tracer) m_Tracer->Save();
+}
 
 /* BuildEnvironment */
 void BuildEnvironment::DoAction(const ParseObjectConfig::Action& action, XMLValue v) {
@@ -18,6 +18,13 @@
 #include "Types.h"
 #include "Tokens.h"
 #include "Standard.h"
+#include "DefinitionCache.h"
+#include "Stats.h"
+#include "Tracer.h"
+#include "Interner.h"
+#include "IncludeGuards.h"
+#include "PrecompiledHeader.h"
+#include "Output.h"
 
 namespace SCRambl
 {
@@ -209,6 +216,15 @@ namespace SCRambl
 			LinkEvent<event_parsed_token>("parsed_token");
 		}
 	};
+	struct event_task_stats : public build_event {
+	public:
+		explicit event_task_stats(const Engine& engine, int task, const TaskStats& stats) : build_event(engine), TaskID(task), Stats(stats) {
+			LinkEvent<event_task_stats>("task_stats");
+		}
+
+		int TaskID;
+		const TaskStats& Stats;
+	};
 	/* build error events */
 	namespace Building {
 		template<BuildError::ID TID, typename... TArgs>
@@ -295,6 +311,50 @@ namespace SCRambl
 
 		bool IsCommandArgParsed(Command*, unsigned long arg_index) const;
 
+		// Config
+		inline const BuildConfig* GetConfig() const { return m_Config; }
+		// Hash of all the definition files loaded (only worked out if something needs it)
+		inline const uint64_t (&GetDefinitionHash() const)[2] { return m_DefinitionHash; }
+
+		// Stats - each task is timed as it runs, the tasks count what they get through themselves
+		inline const BuildStats& GetStats() const { return m_Stats; }
+		inline void Count(Stat stat, uint64_t n = 1) { if (m_CurrentStats) (*m_CurrentStats)[stat] += n; }
+		// Add counts that were kept elsewhere (by worker threads, say) to the running task
+		inline void AddStats(const TaskStats& stats) { if (m_CurrentStats) m_CurrentStats->Add(stats); }
+		// Tracer, if the build is being traced (spans can be added from any thread)
+		inline Tracer* GetTracer() const { return m_Tracer.get(); }
+		// Open an output file for writing - it's kept in memory instead if the config says so
+		std::unique_ptr<OutputSink> CreateOutputFile(const std::string& path);
+		// Output kept in memory, by path - nullptr if there's none
+		const std::string* GetOutput(const std::string& path) const;
+		inline const std::map<std::string, std::string>& GetOutputs() const { return m_Outputs; }
+		// Objects compiled for the build, by path, to be linked
+		inline void AddObject(const std::string& path) { m_Objects.push_back(path); }
+		inline const std::vector<std::string>& GetObjects() const { return m_Objects; }
+		// Read an output file, or what was kept of it in memory - returns false if there's neither
+		bool ReadOutput(const std::string& path, std::string& data) const;
+		// Extension of the script being built, from the config (with no '.') - empty if it doesn't say
+		std::string GetScriptExtension() const;
+
+		// Strings interned for the build, so tables can key on their numbers (can be used from any thread)
+		inline Interner& GetInterner() { return m_Interner; }
+		inline const Interner& GetInterner() const { return m_Interner; }
+		// Included files that needn't be read again, by canonical path (can be used from any thread)
+		inline IncludeGuards& GetIncludeGuards() { return m_IncludeGuards; }
+		inline const IncludeGuards& GetIncludeGuards() const { return m_IncludeGuards; }
+		// Header precompiled for the build, once it's been made or loaded - nullptr if there isn't one (read-only while preprocessing, so can be used from any thread)
+		inline const PrecompiledHeader* GetPrecompiledHeader() const { return m_PrecompiledHeader.get(); }
+		inline void SetPrecompiledHeader(std::unique_ptr<PrecompiledHeader> header) { m_PrecompiledHeader = std::move(header); }
+		// Fine-grained events to send, starting with those in the config - defining SCRAMBL_NO_TOKEN_EVENTS compiles the token events out entirely
+		inline void SetEventMask(EventConfig::Mask mask) { m_EventMask = mask; }
+		inline EventConfig::Mask GetEventMask() const { return m_EventMask; }
+		inline bool IsEventEnabled(EventConfig::Mask event) const {
+#ifdef SCRAMBL_NO_TOKEN_EVENTS
+			if (event & EventConfig::TOKENS) return false;
+#endif
+			return (m_EventMask & event) != 0;
+		}
+
 		// Script
 		inline Script& GetScript() { return m_Script; }
 		inline const Script& GetScript() const { return m_Script; }
@@ -324,12 +384,14 @@ namespace SCRambl
 		inline const ScriptLabel::Scope& CloseLabelScope() { return m_Labels.EndLocal(); }
 		ScriptVariable* AddScriptVariable(std::string name, VecRef<Types::Type>, size_t array_size);
 		ScriptVariable* GetScriptVariable(std::string);
+		ScriptVariable* GetScriptVariable(const char*, size_t);
 
 		// Labels
 		inline ScriptObjects<Label>& GetLabels() { return m_Labels; }
 		inline const ScriptObjects<Label>& GetLabels() const { return m_Labels; }
 		ScriptLabel* AddScriptLabel(std::string name, size_t offset = -1);
 		ScriptLabel* GetScriptLabel(std::string);
+		ScriptLabel* GetScriptLabel(const char*, size_t);
 		ScriptLabel* GetScriptLabel(Label*);
 
 		Xlations::const_iterator GetXlationsBegin() const {
@@ -342,13 +404,15 @@ namespace SCRambl
 		template<typename TTokenType, typename... TArgs>
 		VecRef<Tokens::Token> CreateToken(Scripts::Range range, TArgs&&... args) {
 			auto token = m_Script.GetTokens().Add<TTokenType>(range.Begin(), args...);
-			m_CurrentTask->second->CallEvent(event_added_token(m_Engine, range));
+			if (IsEventEnabled(EventConfig::ADDED_TOKEN))
+				m_CurrentTask->second->CallEvent(event_added_token(m_Engine, range));
 			return token;
 		}
 		template<typename TTokenType, typename... TArgs>
 		VecRef<Tokens::Token> ParseToken(Scripts::Range range, TArgs&&... args) {
 			auto token = m_Script.GetParseTokens().Add<TTokenType>(range.Begin(), args...);
-			m_CurrentTask->second->CallEvent(event_parsed_token(m_Engine, range));
+			if (IsEventEnabled(EventConfig::PARSED_TOKEN))
+				m_CurrentTask->second->CallEvent(event_parsed_token(m_Engine, range));
 			return token;
 		}
 		VecRef<Types::Xlation> AddSymbol(Types::Translation::Ref translation) {
@@ -418,6 +482,8 @@ namespace SCRambl
 		void Setup();
 		void Init();
 		void LoadDefinitions();
+		// Load configurations from XML - only those 'filter' returns true for, if there is one
+		bool LoadXML(std::string path, std::function<bool(const std::string&)> filter);
 
 		Engine& m_Engine;
 		Constants m_Constants;
@@ -428,6 +494,17 @@ namespace SCRambl
 		BuildEnvironment m_Env;
 		BuildConfig* m_Config;
 		ConfigMap m_ConfigMap;
+		uint64_t m_DefinitionHash[2];
+		BuildStats m_Stats;
+		TaskStats* m_CurrentStats = nullptr;
+		std::unique_ptr<Tracer> m_Tracer;
+		Tracer::Clock::time_point m_TaskStart;
+		EventConfig::Mask m_EventMask = EventConfig::NONE;
+		Interner m_Interner;
+		IncludeGuards m_IncludeGuards;
+		std::unique_ptr<PrecompiledHeader> m_PrecompiledHeader;
+		std::map<std::string, std::string> m_Outputs;		// output files kept in memory
+		std::vector<std::string> m_Objects;
 
 		Script m_Script;
 		std::vector<BuildScript> m_BuildScripts;
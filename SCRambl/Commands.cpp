@@ -72,6 +72,7 @@ void Commands::Init(Build& build) {
 		usecc = xml.GetAttribute("Convert").GetValue().AsBool();
 		ccdest = GetCasingByName(xml.GetAttribute("To").GetValue().AsString());
 		ccsrc = GetCasingByName(xml.GetAttribute("From").GetValue().AsString());
+		m_LookupBuilt = false;
 	});
 	m_Config->AddClass("CommandType", [this, &type, &types](const XMLNode xml, void*& obj){
 		type = types.GetType(xml["Type"]->AsString()).Ref();
@@ -133,20 +134,147 @@ Command::Ref Commands::AddCommand(std::string name, XMLValue id, VecRef<Types::T
 
 	if (m_SourceCasing != m_DestCasing) {
 		if (m_DestCasing != Casing::none)
-			std::transform(name.begin(), name.end(), name.begin(), m_DestCasing == Casing::lowercase ? std::tolower : std::toupper);
+			CharScan::FoldCase(&name[0], name.size(), m_DestCasing == Casing::uppercase);
 	}
 
 	m_Commands.emplace_back(name, id, type);
-	m_Map.emplace(name, m_Commands.size() - 1);
+	m_LookupBuilt = false;
 	return { m_Commands, m_Commands.size() - 1 };
 }
-long Commands::FindCommands(std::string name, Vector& vec) {
-	return ForCommandsNamed(name, [&vec](Command::Ref ptr){ if (!ptr->IsCallDisabled()) { vec.push_back(ptr); } return true;  });
+void Commands::BuildLookup() {
+	// overloads of the same name go together, in the order they were added (names that only differ by case are the same, if it's ignored)
+	bool ignore_case = IsCaseInsensitive();
+	std::vector<std::string> names(m_Commands.size());
+	m_Overloads.resize(m_Commands.size());
+	for (size_t i = 0; i < m_Commands.size(); ++i) {
+		names[i] = m_Commands[i].Name();
+		if (ignore_case) CharScan::FoldCase(&names[i][0], names[i].size(), true);
+		m_Overloads[i] = static_cast<uint32_t>(i);
+	}
+	std::stable_sort(m_Overloads.begin(), m_Overloads.end(), [&names](uint32_t a, uint32_t b){ return names[a] < names[b]; });
+
+	std::vector<std::string> keys;
+	m_OverloadRanges.clear();
+	for (uint32_t i = 0; i < m_Overloads.size(); ++i) {
+		auto& name = names[m_Overloads[i]];
+		if (keys.empty() || keys.back() != name) {
+			keys.emplace_back(name);
+			m_OverloadRanges.push_back({ i, 0 });
+		}
+		++m_OverloadRanges.back().Count;
+	}
+	m_Lookup.Build(keys, ignore_case);
+	m_LookupBuilt = true;
+}
+long Commands::FindCommands(const char* name, size_t size, Vector& vec) {
+	return ForCommandsNamed(name, size, [&vec](Command::Ref ptr){ if (!ptr->IsCallDisabled()) { vec.push_back(ptr); } return true;  });
 }
 std::string Commands::CaseConvert(std::string str) const {
-	if (m_UseCaseConversion) {
-		if (m_DestCasing != Casing::none)
-			std::transform(str.begin(), str.end(), str.begin(), m_DestCasing == Casing::lowercase ? std::tolower : std::toupper);
-	}
+	if (IsCaseInsensitive() && !str.empty())
+		CharScan::FoldCase(&str[0], str.size(), m_DestCasing == Casing::uppercase);
 	return str;
-}
\ No newline at end of file
+}
+void Commands::WriteCache(DefinitionCache::Writer& writer) const {
+	auto type_name = [](const Types::Type* type){ return type ? type->GetName() : std::string(); };
+
+	writer.Write(m_UseCaseConversion);
+	writer.Write<uint8_t>(static_cast<uint8_t>(m_SourceCasing));
+	writer.Write<uint8_t>(static_cast<uint8_t>(m_DestCasing));
+
+	writer.Write<uint32_t>(m_Commands.size());
+	for (auto& command : m_Commands) {
+		writer.Write(command.Name());
+		writer.Write(command.ID().AsString());
+		writer.Write(type_name(command.Type()));
+		writer.Write(command.IsDisabled());
+		writer.Write(command.IsCallDisabled());
+		writer.Write(command.IsTranslationDisabled());
+
+		writer.Write<uint32_t>(command.NumParams());
+		for (auto it = command.BeginArg(); it != command.EndArg(); ++it) {
+			writer.Write(type_name(it->GetType()));
+			writer.Write(it->IsReturn());
+			writer.Write<uint32_t>(it->GetSize());
+		}
+
+		writer.Write(command.HasVarArgsConfig());
+		if (command.HasVarArgsConfig()) {
+			auto& conf = command.GetVarArgsConfig();
+			writer.Write(conf.GetIndex().AsString());
+			writer.Write(conf.GetType().OK() ? conf.GetType().Get().GetName() : std::string());
+		}
+	}
+
+	// constructs are resolved after loading, so just remember the names
+	writer.Write<uint32_t>(m_CommandConstructs.size());
+	for (auto& pr : m_CommandConstructs) {
+		writer.Write(pr.first);
+		writer.Write<uint32_t>(pr.second.Index());
+	}
+}
+bool Commands::ReadCache(DefinitionCache::Reader reader, Types::Types& types) {
+	auto get_type = [&types](const std::string& name)->VecRef<Types::Type> {
+		if (name.empty()) return nullptr;
+		return types.GetType(name).Ref();
+	};
+
+	auto usecc = reader.ReadBool();
+	auto ccsrc = static_cast<Casing>(reader.Read<uint8_t>());
+	auto ccdest = static_cast<Casing>(reader.Read<uint8_t>());
+
+	// load into a vector of our own, the lot is only taken if it's all good
+	std::vector<Command> commands;
+	auto num_commands = reader.Read<uint32_t>();
+	if (!reader.OK()) return false;
+	commands.reserve(num_commands);
+	for (uint32_t i = 0; i < num_commands; ++i) {
+		auto name = reader.ReadString();
+		auto id = reader.ReadString();
+		auto type = get_type(reader.ReadString());
+		if (!reader.OK() || !type) return false;
+
+		commands.emplace_back(name, XMLValue(id), type);
+		auto& command = commands.back();
+		command.SetDisabled(reader.ReadBool());
+		command.SetDisableCall(reader.ReadBool());
+		command.SetDisableTranslation(reader.ReadBool());
+
+		for (auto num_args = reader.Read<uint32_t>(); num_args && reader.OK(); --num_args) {
+			auto arg_type = get_type(reader.ReadString());
+			auto is_ret = reader.ReadBool();
+			auto size = reader.Read<uint32_t>();
+			if (!arg_type) return false;
+			command.AddArg(arg_type, is_ret, size);
+		}
+
+		if (reader.ReadBool()) {
+			auto& conf = command.GetVarArgsConfig();
+			conf.SetIndex(XMLValue(reader.ReadString()));
+			auto type_name = reader.ReadString();
+			if (!type_name.empty()) {
+				auto vartype = types.GetType(type_name);
+				if (!vartype) return false;
+				conf.SetType(std::move(vartype));
+			}
+		}
+		if (!reader.OK()) return false;
+	}
+
+	std::vector<std::pair<std::string, size_t>> constructs;
+	for (auto num = reader.Read<uint32_t>(); num && reader.OK(); --num) {
+		auto name = reader.ReadString();
+		auto index = reader.Read<uint32_t>();
+		if (index >= commands.size()) return false;
+		constructs.emplace_back(name, index);
+	}
+	if (!reader.OK()) return false;
+
+	m_UseCaseConversion = usecc;
+	m_SourceCasing = ccsrc;
+	m_DestCasing = ccdest;
+	m_Commands.swap(commands);
+	m_LookupBuilt = false;
+	for (auto& pr : constructs)
+		AddCommandConstruct(pr.first, GetCommand(pr.second));
+	return true;
+}
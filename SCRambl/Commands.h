@@ -12,6 +12,8 @@
 #include "Types.h"
 #include "Constructs.h"
 #include "Values.h"
+#include "DefinitionCache.h"
+#include "utils/perfecthash.h"
 
 namespace SCRambl
 {
@@ -120,6 +122,8 @@ namespace SCRambl
 			inline void AddAutoArg(TArgs&&... args) { m_AutoArgs.emplace_back(args); }
 			inline void SetIndex(XMLValue xml) { m_Index = xml; }
 			inline void SetType(Types::TypeRef<Types::Type> type) { m_Type = type; }
+			inline XMLValue GetIndex() const { return m_Index; }
+			inline const Types::TypeRef<Types::Type>& GetType() const { return m_Type; }
 			
 		private:
 			XMLValue m_Index;
@@ -144,8 +148,8 @@ namespace SCRambl
 		Command(std::string name, XMLValue index, VecRef<Types::Type> type);
 		Command(const Command&) = delete;
 		Command(Command&& v) : m_Index(v.m_Index), m_Name(v.m_Name), m_Args(v.m_Args), m_Type(v.m_Type),
-			m_DisableCall(v.m_DisableCall), m_Disable(v.m_Disable), m_NoArgsConfig(v.m_NoArgsConfig),
-			m_VarArgsConfig(std::move(v.m_VarArgsConfig))
+			m_DisableCall(v.m_DisableCall), m_Disable(v.m_Disable), m_DisableTranslation(v.m_DisableTranslation),
+			m_NoArgsConfig(v.m_NoArgsConfig), m_VarArgsConfig(std::move(v.m_VarArgsConfig)), m_Construct(v.m_Construct)
 		{ }
 
 		Attributes GetAttributes() const;
@@ -165,6 +169,8 @@ namespace SCRambl
 		inline Types::Type* Type() const { return m_Type.Ptr(); }
 		inline NoArgsConfig& GetNoArgsConfig() { return m_NoArgsConfig; }
 		inline VarArgsConfig& GetVarArgsConfig() { if (!m_VarArgsConfig) { m_VarArgsConfig = std::make_unique<VarArgsConfig>(); } return *m_VarArgsConfig; }
+		inline const VarArgsConfig& GetVarArgsConfig() const { return *m_VarArgsConfig; }
+		inline bool HasVarArgsConfig() const { return m_VarArgsConfig != nullptr; }
 		inline bool IsDisabled() const { return m_Disable; }
 		inline bool IsCallDisabled() const { return m_DisableCall; }
 		inline bool IsTranslationDisabled() const { return m_DisableTranslation; }
@@ -199,16 +205,23 @@ namespace SCRambl
 			none, uppercase, lowercase
 		};
 
-		using Map = std::unordered_multimap < std::string, size_t > ;
 		using Vector = std::vector < Command::Ref > ;
 
 	private:
 		XMLConfiguration* m_Config;
-		bool m_UseCaseConversion;
+		bool m_UseCaseConversion = false;
 		Casing m_SourceCasing = Casing::none;
 		Casing m_DestCasing = Casing::none;
-		Map	m_Map;
 		std::vector<Command> m_Commands;
+		// command names - each is found at its range of overloads, which sit together in m_Overloads
+		struct OverloadRange {
+			uint32_t First;
+			uint32_t Count;
+		};
+		PerfectHash m_Lookup;
+		std::vector<OverloadRange> m_OverloadRanges;
+		std::vector<uint32_t> m_Overloads;
+		bool m_LookupBuilt = true;
 		std::unordered_map<std::string, Command::Ref> m_CommandConstructs;
 		bool m_CommandConstructsResolved = true;
 
@@ -219,28 +232,40 @@ namespace SCRambl
 		std::string CaseConvert(std::string) const;
 		Command::Ref AddCommand(std::string name, XMLValue id, VecRef<Types::Type>);
 		Command::Ref GetCommand(size_t index);
+		// Build the lookup of command names - done when they're first looked up after being changed, if not before
+		void BuildLookup();
+
+		// Are names matched regardless of case? (when case conversion is on)
+		inline bool IsCaseInsensitive() const { return m_UseCaseConversion && m_DestCasing != Casing::none; }
 
 		// Finds all commands matching the name and stores them in a passed vector of command handles, excluding call-disabled
 		// Returns the number of commands found
-		long FindCommands(std::string name, Vector& out);
+		long FindCommands(const char* name, size_t size, Vector& out);
+		inline long FindCommands(const std::string& name, Vector& out) { return FindCommands(name.data(), name.size(), out); }
 
 		// Passes each command handle matching the name to the supplied function
+		// The name is matched where it is, case-insensitively if need be - it's never copied
 		// Returns the number of calls / found commands
 		template<typename TFunc>
-		inline long ForCommandsNamed(std::string name, TFunc func) {
-			name = CaseConvert(name);
+		inline long ForCommandsNamed(const char* name, size_t size, TFunc func) {
+			if (!m_LookupBuilt) BuildLookup();
 
-			auto rg = m_Map.equal_range(name);
-			if (rg.first == m_Map.end()) return 0;
+			auto key = m_Lookup.Find(name, size);
+			if (key == PerfectHash::npos) return 0;
+			auto& range = m_OverloadRanges[key];
 			long num = 0;
-			for (auto it = rg.first; it != rg.second; ++it) {
-				auto command = GetCommand(it->second);
+			for (auto i = range.First; i < range.First + range.Count; ++i) {
+				auto command = GetCommand(m_Overloads[i]);
 				if (command->IsDisabled()) continue;
-				if (func(GetCommand(command.Index())))
+				if (func(command))
 					++num;
 			}
 			return num;
 		}
+		template<typename TFunc>
+		inline long ForCommandsNamed(const std::string& name, TFunc func) {
+			return ForCommandsNamed(name.data(), name.size(), func);
+		}
 
 		void ResolveCommandConstructs(const Constructing::Constructs& constructs) {
 			if (!m_CommandConstructsResolved) {
@@ -262,6 +287,12 @@ namespace SCRambl
 		// Get casing by name - or rather, the first character - whatever
 		static Casing GetCasingByName(std::string);
 
+		// Write all loaded commands to a definition cache
+		void WriteCache(DefinitionCache::Writer&) const;
+		// Load commands from a definition cache (instead of XML) - types have to be loaded already
+		// Returns false if the cache is unusable, in which case nothing is loaded
+		bool ReadCache(DefinitionCache::Reader, Types::Types&);
+
 	private:
 		void AddCommandConstruct(std::string name, Command::Ref command) {
 			m_CommandConstructs.emplace(name, command);
@@ -10,6 +10,93 @@ namespace SCRambl
 {
 	namespace Compiling
 	{
+		ValuePacker::ValuePacker(OutputWriter& out, ObjectFile* object) : m_Out(out), m_Object(object) {
+			m_Value.uint64 = 0;
+		}
+		void ValuePacker::Reset() {
+			m_DataSize = m_PackedSize = 0;
+			m_Value.uint64 = 0;
+			m_Init = true;
+			m_Labels.clear();
+		}
+		void ValuePacker::Value(DataVal value, size_t size, size_t valsize, const std::string* label) {
+			if (m_Init) {
+				m_DataSize = valsize;
+
+				// fills a value of its own
+				if (m_DataSize == size) {
+					if (label && m_Object)
+						m_Object->AddRelocation(*label, m_Out.Size(), BitsToBytes(m_DataSize), 0, size);
+					OutputValue(m_Out, value, m_DataSize);
+					return;
+				}
+
+				m_Init = false;
+				m_Value.uint64 = 0;
+				m_PackedSize = 0;
+			}
+
+			size_t left_size = m_DataSize - m_PackedSize;
+			if (left_size < size) {
+				bool success = Flush();
+				ASSERT(success);
+				m_PackedSize = size;
+				m_Value = value;
+				AddLabel(label, 0, size);
+			}
+			else {
+				AddLabel(label, m_PackedSize, size);
+
+				if (!m_PackedSize)
+					m_Value = value;
+				else
+					m_Value.uint64 |= value.uint64 << m_PackedSize;
+
+				if (size != left_size)
+					m_PackedSize += size;
+				else {
+					Flush();
+					m_Init = true;
+				}
+			}
+		}
+		void ValuePacker::String(const std::string& str, size_t size) {
+			if (m_Init) {
+				m_DataSize = size;
+				m_Out.Write(str.c_str(), str.size());
+				for (auto i = str.size(); i < size; ++i) {
+					m_Out.Write<uint8_t>(0);
+				}
+				return;
+			}
+
+			// strings aren't packed in with values - but what's been packed is output if there's no room left
+			if (m_DataSize - m_PackedSize < size) {
+				bool success = Flush();
+				ASSERT(success);
+				m_PackedSize = size;
+			}
+		}
+		void ValuePacker::AddLabel(const std::string* label, size_t shift, size_t bits) {
+			// nothing of the packed value is output till it's full, so it'll start where the output's at now
+			if (label && m_Object) {
+				PackedLabel packed;
+				packed.Label = *label;
+				packed.Position = m_Out.Size();
+				packed.ValueSize = BitsToBytes(m_DataSize);
+				packed.Shift = shift;
+				packed.Bits = bits;
+				m_Labels.push_back(packed);
+			}
+		}
+		bool ValuePacker::Flush() {
+			if (!OutputValue(m_Out, m_Value, m_DataSize))
+				return false;
+			for (auto& packed : m_Labels)
+				m_Object->AddRelocation(packed.Label, packed.Position, packed.ValueSize, packed.Shift, packed.Bits);
+			m_Labels.clear();
+			return true;
+		}
 		void Compiler::Init() {
 			m_TokenIt = m_Tokens.Begin();
 			m_XlationIt = m_Build->GetXlationsBegin();
@@ -21,7 +108,9 @@ namespace SCRambl
 				BREAK();
 				name = "main";
 			}
-			m_File.open(name + ".scrmbl", std::ios::out | std::ios::binary);
+			m_ObjectPath = name + ".scrmbl";
+			m_Object.Clear();
+			m_Output.Open(m_Build->CreateOutputFile(m_ObjectPath));
 		}
 		void Compiler::Reset() {
 
@@ -45,137 +134,147 @@ namespace SCRambl
 			CompileTranslation(xlate.GetTranslation(), xlate);
 			++m_XlationIt;
 		}
-		void Compiler::CompileTranslation(Types::Translation::Ref translation, Types::Xlation xlate) {
+		const Compiler::TranslationProgram& Compiler::GetTranslationProgram(Types::Translation::Ref translation) {
+			auto it = m_TranslationPrograms.find(translation.Ptr());
+			if (it == m_TranslationPrograms.end())
+				it = m_TranslationPrograms.emplace(translation.Ptr(), CompileTranslationProgram(translation)).first;
+			return it->second;
+		}
+		Compiler::TranslationProgram Compiler::CompileTranslationProgram(Types::Translation::Ref translation) {
+			TranslationProgram prog;
 			for (size_t y = 0; y < translation->GetDataCount(); ++y) {
 				auto data = translation->GetData(y);
+				auto first = prog.Ops.size();
+				bool constant = true;
 
-				size_t data_size = 0, totes_size = 0;
-				Types::DataType data_type = Types::DataType::INVALID;
-				DataVal dval;
-				dval.uint64 = 0;
-				std::string str;
-				bool init = true, args = false;
+				TranslationProgram::Op op;
+				op.Code = TranslationProgram::op_data;
+				prog.Ops.push_back(op);
 
-				for (size_t x = 0; x < data->GetNumFields(); !args ? ++x : x = x) {
+				for (size_t x = 0; x < data->GetNumFields(); ++x) {
 					auto field = data->GetField(x);
 					bool cval = field->GetDataSource() == Types::DataSourceID::None && field->GetDataAttribute() == Types::DataAttributeID::None;
-					auto value = xlate.GetAttribute(field->GetDataSource(), field->GetDataAttribute());
-					size_t size = field->HasSizeLimit() ? field->GetSizeLimit() : 0;
 
-					bool isstr = false;
-					auto type = field->GetDataType();
+					op.Type = field->GetDataType();
+					op.Source = field->GetDataSource();
+					op.Attribute = field->GetDataAttribute();
+					op.FixedSize = field->HasSizeLimit();
+					op.Relocate = op.Source == Types::DataSourceID::Label && op.Attribute == Types::DataAttributeID::Offset;
+					op.Size = field->HasSizeLimit() ? field->GetSizeLimit() : 0;
+					op.ValSize = 0;
+					op.Value.uint64 = 0;
 
-					switch (type) {
+					switch (op.Type) {
+					case Types::DataType::Char:
+						op.Size = 8;
+						op.FixedSize = true;
 					case Types::DataType::Float:
 					case Types::DataType::Fixed:
 					case Types::DataType::Int:
+						op.Code = TranslationProgram::op_value;
 						if (cval) {
-							value = field->GetValue();
-						}
-						if (!field->HasSizeLimit()) {
-							size = BitsToByteBits(CountBitOccupation(value.AsNumber<size_t>()));
-							if (size > 64) size = 64;
-						}
-						break;
-					case Types::DataType::Char:
-						if (cval) {
-							value = field->GetValue();
+							auto value = field->GetValue();
+							if (!op.FixedSize) {
+								op.Size = BitsToByteBits(CountBitOccupation(value.AsNumber<size_t>()));
+								if (op.Size > 64) op.Size = 64;
+								op.FixedSize = true;
+							}
+							op.Code = TranslationProgram::op_constant;
+							op.ValSize = GetValueSize(op.Size);
+							op.Value = RawifyValue(value, op.ValSize, op.Type);
 						}
-						size = 8;
+						else if (op.FixedSize)
+							op.ValSize = GetValueSize(op.Size);
 						break;
 					case Types::DataType::String:
-						if (cval) {
-							str = field->GetValue();
-						}
-						size = field->HasSizeLimit() ? size : value.AsString().size();
-						isstr = true;
+						// even constant strings come from the xlation
+						op.Code = TranslationProgram::op_string;
 						break;
 					case Types::DataType::Args:
-						args = true;
+						op.Code = TranslationProgram::op_args;
 						break;
-					default: BREAK();
-					}
-
-					if (args) {
-						auto type = m_TokenIt->GetToken()->GetType<Tokens::Type>();
-						auto& vec = Tokens::CommandArgs::GetVector(*m_TokenIt->GetToken());
-						++m_TokenIt;
-						for (auto v : vec) {
-							CompileTranslation(v.second->GetTranslation(), FormArgumentXlate(xlate, v));
-						}
-						args = false;
-						continue;
+					default:
 						BREAK();
+						op.Code = TranslationProgram::op_value;
+						op.FixedSize = true;
+						op.ValSize = GetValueSize(op.Size);
+						break;
 					}
 
-					size_t valsize = 0;
-					if (!isstr) {
-						if (size > 64) BREAK();
-						else if (size > 32)
-							valsize = 64;
-						else if (size > 16)
-							valsize = 32;
-						else if (size > 8)
-							valsize = 16;
-						else
-							valsize = 8;
-					}
-					else valsize = size;
-
-					if (init) {
-						data_size = valsize;
-
-						if (data_size == size) {
-							if (isstr) {
-								str = value.AsString();
-								Output(str.c_str(), str.size());
-								for (auto i = str.size(); i < data_size; ++i) {
-									Output<uint8_t>(0);
-								}
-							}
-							else {
-								OutputValue(RawifyValue(value, data_size, type), data_size);
-							}
-							continue;
-						}
+					if (op.Code != TranslationProgram::op_constant) constant = false;
+					prog.Ops.push_back(op);
+				}
 
-						init = false;
-						dval.uint64 = 0;
-						totes_size = 0;
+				if (constant) {
+					// nothing in it changes, so pack it now and output the bytes each time
+					std::string bytes;
+					OutputWriter out(0x100);
+					out.Open(std::make_unique<MemoryOutputSink>(bytes));
+					ValuePacker pack(out);
+					for (auto i = first + 1; i < prog.Ops.size(); ++i) {
+						auto& field_op = prog.Ops[i];
+						pack.Value(field_op.Value, field_op.Size, field_op.ValSize);
 					}
+					out.Close();
 
-					size_t req_size = totes_size + size,
-						left_size = data_size - totes_size;
-					if (left_size < size) {
-						bool success = OutputValue(dval, data_size);
-						ASSERT(success);
-						ASSERT(!init);
-						totes_size = size;
-						if (!isstr) {
-							dval = RawifyValue(value, valsize, type);
-						}
-						else str = value.AsString().substr(0, size);
-						continue;
-					}
+					prog.Ops.resize(first);
+					if (bytes.empty()) continue;
+					if (!prog.Ops.empty() && prog.Ops.back().Code == TranslationProgram::op_bytes)
+						prog.Ops.back().Size += bytes.size();
 					else {
-						if (!isstr) {
-							if (!totes_size) {
-								dval = RawifyValue(value, valsize, type);
-							}
-							else {
-								dval.uint64 |= RawifyValue(value, valsize, type).uint64 << totes_size;
-							}
+						op.Code = TranslationProgram::op_bytes;
+						op.Size = bytes.size();
+						op.ValSize = prog.Bytes.size();
+						prog.Ops.push_back(op);
+					}
+					prog.Bytes += bytes;
+				}
+			}
+			return prog;
+		}
+		void Compiler::CompileTranslation(Types::Translation::Ref translation, Types::Xlation xlate) {
+			auto& prog = GetTranslationProgram(translation);
+			ValuePacker pack(m_Output, &m_Object);
 
-							if (size != left_size)
-								totes_size += size;
-							else
-							{
-								OutputValue(dval, data_size);
-								init = true;
-							}
-						}
-						else str = value.AsString().substr(0, size);
+			for (auto& op : prog.Ops) {
+				switch (op.Code) {
+				case TranslationProgram::op_data:
+					pack.Reset();
+					break;
+				case TranslationProgram::op_bytes:
+					Output(&prog.Bytes[op.ValSize], op.Size);
+					break;
+				case TranslationProgram::op_constant:
+					pack.Value(op.Value, op.Size, op.ValSize);
+					break;
+				case TranslationProgram::op_value: {
+					auto value = xlate.GetAttribute(op.Source, op.Attribute);
+					size_t size = op.Size, valsize = op.ValSize;
+					if (!op.FixedSize) {
+						size = BitsToByteBits(CountBitOccupation(value.AsNumber<size_t>()));
+						if (size > 64) size = 64;
+						valsize = GetValueSize(size);
+					}
+					if (op.Relocate) {
+						auto label = xlate.GetAttribute(Types::DataSourceID::Label, Types::DataAttributeID::Name).AsString();
+						pack.Value(RawifyValue(value, valsize, op.Type), size, valsize, &label);
 					}
+					else pack.Value(RawifyValue(value, valsize, op.Type), size, valsize);
+					break;
+				}
+				case TranslationProgram::op_string: {
+					auto str = xlate.GetAttribute(op.Source, op.Attribute).AsString();
+					pack.String(str, op.FixedSize ? op.Size : str.size());
+					break;
+				}
+				case TranslationProgram::op_args: {
+					auto& vec = Tokens::CommandArgs::GetVector(*m_TokenIt->GetToken());
+					++m_TokenIt;
+					for (auto v : vec) {
+						CompileTranslation(v.second->GetTranslation(), FormArgumentXlate(xlate, v));
+					}
+					break;
+				}
 				}
 			}
 		}
@@ -185,7 +284,18 @@ namespace SCRambl
 		void Compiler::Finish() {
 			m_Task.Event<event_finish>();
 			m_State = finished;
-			m_File.close();
+			if (m_Output.IsOpen()) {
+				// labels and references to them go after the code, for the linker
+				auto code_size = m_Output.Size();
+				for (auto& label : m_Build->GetLabels()) {
+					m_Object.AddLabel(label->Name(), static_cast<uint32_t>(label->Offset()), label->IsGlobal());
+				}
+				m_Object.WriteTables(m_Output, code_size);
+
+				m_Build->Count(Stat::bytes_emitted, m_Output.Size());
+				if (m_Output.Close())
+					m_Build->AddObject(m_ObjectPath);
+			}
 		}
 
 		Compiler::Compiler(Task& task, Engine& engine, Build* build) :
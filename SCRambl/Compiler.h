@@ -8,6 +8,7 @@
 #include "Tasks.h"
 #include "Scripts.h"
 #include "Parser.h"
+#include "ObjectFile.h"
 
 namespace SCRambl
 {
@@ -34,6 +35,60 @@ namespace SCRambl
 		private:
 			ID			m_ID;
 		};
+
+		union DataVal {
+			uint64_t uint64;
+			uint32_t uint32;
+			uint16_t uint16;
+			uint8_t uint8;
+			float flt;
+		};
+
+		// Packs the values of a data into as few values as they fit in, outputting each once it's full (or the next won't fit)
+		// A label offset gets its relocation when the value holding it is output - a value left half-packed never is
+		class ValuePacker {
+		public:
+			ValuePacker(OutputWriter& out, ObjectFile* object = nullptr);
+
+			// Start on the next data - anything half-packed is dropped
+			void Reset();
+			// Pack a value of 'size' bits into one of 'valsize' bits, the offset of the label if one's named
+			void Value(DataVal, size_t size, size_t valsize, const std::string* label = nullptr);
+			void String(const std::string&, size_t size);
+
+			static bool OutputValue(OutputWriter& out, DataVal value, size_t size) {
+				if (size == 8)
+					out.Write<uint8_t>(value.uint8);
+				else if (size == 16)
+					out.Write<uint16_t>(value.uint16);
+				else if (size == 32)
+					out.Write<uint32_t>(value.uint32);
+				else if (size == 64)
+					out.Write<uint64_t>(value.uint64);
+				else return false;
+				return true;
+			}
+
+		private:
+			// A label offset in the value being packed
+			struct PackedLabel {
+				std::string Label;
+				uint64_t Position;
+				size_t ValueSize, Shift, Bits;
+			};
+
+			void AddLabel(const std::string* label, size_t shift, size_t bits);
+			// Output the packed value and relocate the labels in it
+			bool Flush();
+
+			OutputWriter& m_Out;
+			ObjectFile* m_Object;
+			size_t m_DataSize = 0, m_PackedSize = 0;
+			DataVal m_Value;
+			bool m_Init = true;
+			std::vector<PackedLabel> m_Labels;
+		};
+
 		class Compiler {
 		public:
 			enum State {
@@ -63,30 +118,50 @@ namespace SCRambl
 			}
 			template<typename T, typename U = T>
 			inline void Output(const U& v) {
-				m_File.write((char*)&v, sizeof(T));
+				m_Output.Write(&v, sizeof(T));
 			}
 			template<typename T>
 			inline void Output(const T& v, size_t n) {
-				m_File.write((char*)&v, n);
+				m_Output.Write(&v, n);
 			}
 			template<typename T, typename U = T>
 			inline void Output(const U* v) {
-				m_File.write((char*)v, sizeof(T));
+				m_Output.Write(v, sizeof(T));
 			}
 			template<typename T>
 			inline void Output(const T* v, size_t n) {
-				m_File.write((char*)v, n);
+				m_Output.Write(v, n);
 			}
 
 		private:
-			union DataVal {
-				uint64_t uint64;
-				uint32_t uint32;
-				uint16_t uint16;
-				uint8_t uint8;
-				float flt;
-			};
+			// A translation worked out once, on its first use, so emitting it is a run through its ops
+			// Constant fields are rawified up front, and data made only of them is packed into bytes ready to output
+			struct TranslationProgram {
+				enum OpCode : uint8_t {
+					op_data,				// start of a data - packing starts over
+					op_bytes,				// pre-packed bytes of a constant data
+					op_constant,			// number/char with a value already rawified
+					op_value,				// number/char from the xlation
+					op_string,				// string from the xlation
+					op_args,				// the args of the command token
+				};
+				struct Op {
+					OpCode Code;
+					Types::DataType Type;
+					bool FixedSize;			// size doesn't depend on the value
+					bool Relocate;			// value is a label offset, which the linker has to fix up
+					Types::DataSourceID Source;
+					Types::DataAttributeID Attribute;
+					size_t Size;			// for op_bytes, how many
+					size_t ValSize;			// for op_bytes, where they are in Bytes
+					DataVal Value;
+				};
 
+				std::vector<Op> Ops;
+				std::string Bytes;
+			};
+			const TranslationProgram& GetTranslationProgram(Types::Translation::Ref);
+			TranslationProgram CompileTranslationProgram(Types::Translation::Ref);
 			void CompileTranslation(Types::Translation::Ref, Types::Xlation);
 			Types::Xlation FormArgumentXlate(const Types::Xlation&, const Tokens::CommandArgs::Arg&) const;
 			inline void AddCommandName(std::string name, size_t id) {
@@ -120,17 +195,16 @@ namespace SCRambl
 				}
 				return v;
 			}
-			bool OutputValue(DataVal value, size_t size) {
-				if (size == 8)
-					Output<uint8_t>(value.uint8);
-				else if (size == 16)
-					Output<uint16_t>(value.uint16);
-				else if (size == 32)
-					Output<uint32_t>(value.uint32);
-				else if (size == 64)
-					Output<uint64_t>(value.uint64);
-				else return false;
-				return true;
+			// Size of the smallest value that fits 'size' bits
+			static size_t GetValueSize(size_t size) {
+				if (size > 64) {
+					BREAK();
+					return 0;
+				}
+				if (size > 32) return 64;
+				if (size > 16) return 32;
+				if (size > 8) return 16;
+				return 8;
 			}
 
 		private:
@@ -142,7 +216,10 @@ namespace SCRambl
 			
 			Tokens::Storage& m_Tokens;
 			Tokens::Iterator m_TokenIt;
-			std::ofstream m_File;
+			OutputWriter m_Output;
+			std::string m_ObjectPath;
+			ObjectFile m_Object;
+			std::unordered_map<const Types::Translation*, TranslationProgram> m_TranslationPrograms;
 
 			std::map<std::string, int32_t> m_CommandNames;
 			std::vector<std::pair<std::string, int32_t>> m_CommandNameVec;
@@ -157,7 +234,7 @@ namespace SCRambl
 		};
 		template<typename T>
 		struct event : public build_event {
-			explicit event(std::string name, const Engine& engine) : build_event(engine) {
+			explicit event(const char* name, const Engine& engine) : build_event(engine) {
 				LinkEvent<T>(name);
 			}
 		};
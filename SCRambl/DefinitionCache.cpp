@@ -0,0 +1,113 @@
+#include "stdafx.h"
+#include "DefinitionCache.h"
+#include "utils.h"
+#include "utils/MurmurHash3.h"
+
+using namespace SCRambl;
+
+namespace {
+	// 'SCRD'
+	const uint32_t cache_magic = 0x44524353;
+	const uint32_t hash_seed = 0x88664422;
+}
+
+/* DefinitionCache::Source */
+bool DefinitionCache::Source::HasConfig(const std::string& name) const {
+	return std::find(Configs.begin(), Configs.end(), name) != Configs.end();
+}
+
+/* DefinitionCache */
+DefinitionCache::DefinitionCache(std::string path) : m_Path(path)
+{ }
+DefinitionCache::Source& DefinitionCache::AddSource(std::string path) {
+	m_Sources.emplace_back(path);
+	auto& source = m_Sources.back();
+	MappedFile file(path);
+	if (file.IsOpen()) {
+		source.Found = true;
+		MurmurHash3_x64_128(file.Data(), static_cast<int>(file.Size()), hash_seed, source.Hash);
+	}
+	return source;
+}
+void DefinitionCache::HashSources(uint64_t (&hash)[2]) const {
+	Writer writer;
+	for (auto& source : m_Sources) {
+		writer.Write(source.Path);
+		writer.Write(source.Found);
+		writer.Write<uint64_t>(source.Hash[0]);
+		writer.Write<uint64_t>(source.Hash[1]);
+	}
+	auto& buffer = writer.Buffer();
+	MurmurHash3_x64_128(buffer.data(), static_cast<int>(buffer.size()), hash_seed, hash);
+}
+bool DefinitionCache::Open() {
+	Close();
+	m_File = std::make_unique<MappedFile>(m_Path);
+	if (!m_File->IsOpen() || !m_File->Data()) {
+		Close();
+		return false;
+	}
+
+	Reader reader(m_File->Data(), m_File->Size());
+	if (reader.Read<uint32_t>() != cache_magic || reader.Read<uint32_t>() != version) {
+		Close();
+		return false;
+	}
+
+	// the sources have to be the same ones, in the same order, with the same contents
+	auto num_sources = reader.Read<uint32_t>();
+	if (num_sources != m_Sources.size()) {
+		Close();
+		return false;
+	}
+	std::vector<std::vector<std::string>> configs(num_sources);
+	for (auto& source : m_Sources) {
+		auto path = reader.ReadString();
+		auto found = reader.ReadBool();
+		uint64_t hash[2];
+		hash[0] = reader.Read<uint64_t>();
+		hash[1] = reader.Read<uint64_t>();
+		if (!reader.OK() || path != source.Path || found != source.Found || hash[0] != source.Hash[0] || hash[1] != source.Hash[1]) {
+			Close();
+			return false;
+		}
+		auto& names = configs[&source - &m_Sources[0]];
+		for (auto n = reader.Read<uint32_t>(); n && reader.OK(); --n)
+			names.emplace_back(reader.ReadString());
+	}
+	if (!reader.OK()) {
+		Close();
+		return false;
+	}
+
+	for (size_t i = 0; i < m_Sources.size(); ++i)
+		m_Sources[i].Configs = std::move(configs[i]);
+	m_Data = reader;
+	m_Fresh = true;
+	return true;
+}
+void DefinitionCache::Close() {
+	m_File.reset();
+	m_Data = Reader();
+	m_Fresh = false;
+}
+bool DefinitionCache::Save(const Writer& data) const {
+	Writer key;
+	WriteKey(key);
+
+	return SaveFile(m_Path, { &key.Buffer(), &data.Buffer() });
+}
+void DefinitionCache::WriteKey(Writer& writer) const {
+	writer.Write<uint32_t>(cache_magic);
+	writer.Write<uint32_t>(version);
+	writer.Write<uint32_t>(m_Sources.size());
+	for (auto& source : m_Sources) {
+		writer.Write(source.Path);
+		writer.Write(source.Found);
+		writer.Write<uint64_t>(source.Hash[0]);
+		writer.Write<uint64_t>(source.Hash[1]);
+		writer.Write<uint32_t>(source.Configs.size());
+		for (auto& name : source.Configs)
+			writer.Write(name);
+	}
+}
@@ -0,0 +1,129 @@
+/**********************************************************/
+// SCRambl Advanced SCR Compiler/Assembler
+// This program is distributed freely under the MIT license
+// (See the LICENSE file provided
+//	 or copy at http://opensource.org/licenses/MIT)
+/**********************************************************/
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <memory>
+#include "utils/mmap.h"
+
+namespace SCRambl
+{
+	// Binary cache of loaded definitions, keyed on the contents of every definition file that went into it
+	class DefinitionCache
+	{
+	public:
+		// bump whenever the layout changes, old caches are then just ignored
+		enum { version = 1 };
+
+		// A definition file the cache was made from
+		struct Source {
+			std::string Path;
+			uint64_t Hash[2];
+			bool Found = false;
+			std::vector<std::string> Configs;			// names of the configurations found in it
+
+			Source(std::string path) : Path(path), Hash()
+			{ }
+
+			bool HasConfig(const std::string&) const;
+		};
+
+		// Appends plain data to a buffer
+		class Writer {
+		public:
+			template<typename T>
+			inline void Write(T v) {
+				static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "DefinitionCache::Writer::Write needs plain data");
+				m_Buffer.append(reinterpret_cast<const char*>(&v), sizeof(v));
+			}
+			inline void Write(const std::string& str) {
+				Write<uint32_t>(str.size());
+				m_Buffer.append(str);
+			}
+			inline void Write(bool v) { Write<uint8_t>(v ? 1 : 0); }
+
+			inline const std::string& Buffer() const { return m_Buffer; }
+
+		private:
+			std::string m_Buffer;
+		};
+
+		// Reads plain data straight from the mapping - once anything is out of bounds, it stays failed
+		class Reader {
+		public:
+			Reader() = default;
+			Reader(const char* data, size_t size) : m_Ptr(data), m_End(data + size)
+			{ }
+
+			template<typename T>
+			inline T Read() {
+				static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "DefinitionCache::Reader::Read needs plain data");
+				T v = T();
+				if (Check(sizeof(T))) {
+					memcpy(&v, m_Ptr, sizeof(T));
+					m_Ptr += sizeof(T);
+				}
+				return v;
+			}
+			inline std::string ReadString() {
+				auto size = Read<uint32_t>();
+				if (!Check(size)) return "";
+				std::string str(m_Ptr, size);
+				m_Ptr += size;
+				return str;
+			}
+			inline bool ReadBool() { return Read<uint8_t>() != 0; }
+
+			inline bool OK() const { return m_OK; }
+			inline bool AtEnd() const { return m_Ptr == m_End; }
+
+		private:
+			inline bool Check(size_t size) {
+				if (!m_OK || static_cast<size_t>(m_End - m_Ptr) < size)
+					m_OK = false;
+				return m_OK;
+			}
+
+			const char* m_Ptr = nullptr;
+			const char* m_End = nullptr;
+			bool m_OK = true;
+		};
+
+	public:
+		DefinitionCache(std::string path);
+
+		// Hash a definition file and add it to the key
+		Source& AddSource(std::string path);
+		inline std::vector<Source>& GetSources() { return m_Sources; }
+		inline const std::vector<Source>& GetSources() const { return m_Sources; }
+		// One hash for all of the sources together, for anything else that depends on them
+		void HashSources(uint64_t (&hash)[2]) const;
+
+		// Map the cache file - returns true if it was made from exactly the same sources as were added
+		bool Open();
+		inline bool IsFresh() const { return m_Fresh; }
+		// Reader for the cached data (after the key) - only valid while the cache is open
+		inline Reader GetReader() const { return m_Data; }
+		// Unmap the cache file
+		void Close();
+
+		// Write the key and data to the cache file
+		bool Save(const Writer& data) const;
+
+	private:
+		void WriteKey(Writer&) const;
+
+		std::string m_Path;
+		std::vector<Source> m_Sources;
+		std::unique_ptr<MappedFile> m_File;
+		Reader m_Data;
+		bool m_Fresh = false;
+	};
+}
@@ -8,10 +8,19 @@
 
 using namespace SCRambl;
 
-enum BuildTask {
-	preprocessor, parser, compiler, linker, finished
-};
-
+const char* Engine::GetBuildTaskName(int id) {
+	switch (id) {
+	case preprocessor:
+		return "Preprocessor";
+	case parser:
+		return "Parser";
+	case compiler:
+		return "Compiler";
+	case linker:
+		return "Linker";
+	}
+	return "";
+}
 bool Engine::BuildScript(Build* build) {
 	auto state = build->Run().GetState();
 	return state != TaskSystem::Task::finished;
@@ -40,17 +49,7 @@ Build* Engine::InitBuild(std::vector<std::string> files) {
 	add_task_events(compiler, compiler_task);
 	add_task_events(linker, linker_task);
 	auto get_task_name = [](const Build* build){
-		switch (build->GetCurrentTaskID()) {
-		case preprocessor:
-			return "Preprocessor";
-		case parser:
-			return "Parser";
-		case compiler:
-			return "Compiler";
-		case linker:
-			return "Linker:";
-		}
-		return "";
+		return GetBuildTaskName(build->GetCurrentTaskID());
 	};
 	build->AddEventHandler<task_event>([&get_task_name, build](const task_event& event){
 		std::cout << get_task_name(build) << ": event `" << event.Name() << "`\n";
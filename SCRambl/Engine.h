@@ -19,6 +19,7 @@
 #include "Types.h"
 #include "Constants.h"
 #include "Scripts.h"
+#include "SourceCache.h"
 
 namespace SCRambl
 {
@@ -38,10 +39,20 @@ namespace SCRambl
 		// BuildSystem
 		Builder	m_Builder;
 
+		// Included files, shared by every build
+		SourceCache m_SourceCache;
+
 		// Message formatting
 		FormatMap Formatters;
 		
 	public:
+		// IDs of the tasks each build is given, in the order they run
+		enum BuildTask {
+			preprocessor, parser, compiler, linker, finished
+		};
+		// Name of a build task (empty for anything else)
+		static const char* GetBuildTaskName(int id);
+
 		Engine();
 		virtual ~Engine();
 
@@ -54,6 +65,9 @@ namespace SCRambl
 		// Load XML configuration/definition file
 		bool LoadXML(const std::string& path);
 
+		// Code of included files, kept between builds
+		inline SourceCache& GetSourceCache() { return m_SourceCache; }
+
 		// Obtain current build configuration
 		BuildConfig* GetBuildConfig() const;
 		// Set current build configuration
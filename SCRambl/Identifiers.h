@@ -14,6 +14,7 @@
 //#include "Parser.h"
 //#include "Lexer.h"
 #include "Symbols.h"
+#include "utils/hash.h"
 
 namespace SCRambl
 {
@@ -21,22 +22,20 @@ namespace SCRambl
 
 	class Identifier
 	{
-		static std::hash<std::string>	g_Hasher;
-
 		std::string						m_Name;
 		size_t							m_Hash;
 
 		class Hasher
 		{
 		public:
-			size_t operator()(const Identifier& k) const		{ return g_Hasher(k.Name()); }
+			size_t operator()(const Identifier& k) const		{ return k.Hash(); }
 		};
 
 	public:
 		template<class T>
 		using Map = std::unordered_map<Identifier, T, Hasher>;
 
-		Identifier(std::string name) : m_Name(name), m_Hash(g_Hasher(name))
+		Identifier(std::string name) : m_Name(name), m_Hash(GenerateHash(name.data(), name.size()))
 		{
 		}
 
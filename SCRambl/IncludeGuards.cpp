@@ -0,0 +1,150 @@
+#include "stdafx.h"
+#include "IncludeGuards.h"
+
+using namespace SCRambl;
+
+namespace {
+	// Reads the lines of some code that have something other than comments and whitespace on them
+	class LineReader {
+	public:
+		LineReader(const char* code, size_t size) : m_Ptr(code), m_End(code + size)
+		{ }
+
+		// Next line with anything on it, without the comments or surrounding whitespace - returns false at the end
+		bool Next(std::string& line) {
+			while (m_Ptr < m_End) {
+				line.clear();
+				bool in_string = false;
+				for (; m_Ptr < m_End && !IsEOL(*m_Ptr); ++m_Ptr) {
+					char c = *m_Ptr;
+					char next = m_Ptr + 1 < m_End ? m_Ptr[1] : '\0';
+
+					// /* block /* comments */ nest */
+					if (m_Depth) {
+						if (c == '*' && next == '/') --m_Depth, ++m_Ptr;
+						else if (c == '/' && next == '*') ++m_Depth, ++m_Ptr;
+						continue;
+					}
+					if (!in_string && c == '/') {
+						if (next == '/') {
+							while (m_Ptr < m_End && !IsEOL(*m_Ptr)) ++m_Ptr;
+							break;
+						}
+						if (next == '*') {
+							++m_Depth, ++m_Ptr;
+							line += ' ';
+							continue;
+						}
+					}
+					if (c == '"') in_string = !in_string;
+					else if (c == '\\' && in_string && !IsEOL(next)) {
+						line += c;
+						c = *++m_Ptr;
+					}
+					line += c;
+				}
+				if (m_Ptr < m_End) ++m_Ptr;
+
+				auto begin = line.find_first_not_of(" \t\r\v\f");
+				if (begin != std::string::npos) {
+					line = line.substr(begin, line.find_last_not_of(" \t\r\v\f") + 1 - begin);
+					return true;
+				}
+			}
+			return false;
+		}
+
+	private:
+		static inline bool IsEOL(char c) { return c == '\n' || c == '\0'; }
+
+		const char* m_Ptr;
+		const char* m_End;
+		int m_Depth = 0;
+	};
+
+	// Get the name of the directive on a line and the first word after it - the name's empty if it's not a directive
+	void ReadDirective(const std::string& line, std::string& name, std::string& word) {
+		name.clear();
+		word.clear();
+		if (line.empty() || line[0] != '#') return;
+
+		auto is_word = [](char c){ return isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+		size_t i = line.find_first_not_of(" \t", 1);
+		for (; i < line.size() && is_word(line[i]); ++i) name += line[i];
+		i = line.find_first_not_of(" \t", i);
+		for (; i < line.size() && is_word(line[i]); ++i) word += line[i];
+	}
+}
+
+bool IncludeGuards::Detect(const char* code, size_t size, Guard& guard) {
+	LineReader reader(code, size);
+	std::string line, name, word, macro;
+	bool first = true;
+	bool guarded = false;				// still looks like it's all inside '#ifndef macro'
+	bool closed = false;				// got to the #endif of it
+	bool once = false;
+	int depth = 0;
+
+	while (reader.Next(line)) {
+		ReadDirective(line, name, word);
+		if (name == "pragma" && word == "once") {
+			once = true;
+			continue;
+		}
+
+		if (first) {
+			first = false;
+			if (name == "ifndef" && !word.empty()) {
+				guarded = true;
+				macro = word;
+				depth = 1;
+			}
+			continue;
+		}
+		if (!guarded) continue;
+
+		// anything after the #endif is included every time
+		if (closed) {
+			guarded = false;
+			continue;
+		}
+
+		if (name == "if" || name == "ifdef" || name == "ifndef") ++depth;
+		else if (name == "endif") {
+			if (!--depth) closed = true;
+		}
+		// an #else of the guard would be included the next time
+		else if (depth == 1 && (name == "else" || name == "elif")) guarded = false;
+	}
+
+	if (once) {
+		guard.Once = true;
+		guard.Macro.clear();
+		return true;
+	}
+	if (guarded && closed) {
+		guard.Once = false;
+		guard.Macro = macro;
+		return true;
+	}
+	return false;
+}
+void IncludeGuards::Add(const std::string& path, const Guard& guard) {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Guards[path] = guard;
+}
+bool IncludeGuards::Find(const std::string& path, Guard& guard) const {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto it = m_Guards.find(path);
+	if (it == m_Guards.end()) return false;
+	guard = it->second;
+	return true;
+}
+void IncludeGuards::Clear() {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Guards.clear();
+}
+size_t IncludeGuards::Size() const {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Guards.size();
+}
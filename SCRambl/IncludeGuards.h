@@ -0,0 +1,45 @@
+/**********************************************************/
+// SCRambl Advanced SCR Compiler/Assembler
+// This program is distributed freely under the MIT license
+// (See the LICENSE file provided
+//	 or copy at http://opensource.org/licenses/MIT)
+/**********************************************************/
+#pragma once
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace SCRambl
+{
+	// Remembers which included files would do nothing if they were included again, so they needn't be read
+	// That's those that say '#pragma once', or have all of their code inside '#ifndef X' (once X is defined)
+	// One is kept for the whole build, by canonical path (can be used from any thread) - whether a file
+	// has been included or X is defined is up to whoever's including it
+	class IncludeGuards
+	{
+	public:
+		// What stops a file being included twice
+		struct Guard {
+			bool Once = false;			// #pragma once
+			std::string Macro;			// #ifndef Macro ... #endif (if it's not Once)
+		};
+
+		IncludeGuards() = default;
+		IncludeGuards(const IncludeGuards&) = delete;
+
+		// Look for a guard around the code of a file - returns false if it hasn't got one
+		static bool Detect(const char* code, size_t size, Guard& guard);
+
+		// Remember the guard of a file
+		void Add(const std::string& path, const Guard& guard);
+		// Get the guard of a file - returns false if it's not known to have one
+		bool Find(const std::string& path, Guard& guard) const;
+		void Clear();
+		// Number of files with guards
+		size_t Size() const;
+
+	private:
+		mutable std::mutex m_Mutex;
+		std::unordered_map<std::string, Guard> m_Guards;
+	};
+}
@@ -0,0 +1,87 @@
+#include "stdafx.h"
+#include "Interner.h"
+#include "utils/hash.h"
+
+using namespace SCRambl;
+
+namespace {
+	const std::string empty_string;
+}
+
+Interner::Table::Table(size_t size) : Mask(size - 1), Slots(new std::atomic<const Entry*>[size]) {
+	for (size_t i = 0; i < size; ++i)
+		Slots[i].store(nullptr, std::memory_order_relaxed);
+}
+Interner::Interner() {
+	for (auto& shard : m_Shards) {
+		shard.Tables.emplace_back(new Table(64));
+		shard.Current.store(shard.Tables.back().get(), std::memory_order_release);
+	}
+}
+size_t Interner::Probe(const Table& table, const char* str, size_t size, uint32_t hash) {
+	for (auto i = hash & table.Mask;; i = (i + 1) & table.Mask) {
+		auto entry = table.Slots[i].load(std::memory_order_acquire);
+		if (!entry) return i;
+		if (entry->Hash == hash && entry->String.size() == size && !entry->String.compare(0, size, str, size))
+			return i;
+	}
+}
+const Interner::Entry* Interner::Lookup(const Shard& shard, const char* str, size_t size, uint32_t hash) {
+	auto table = shard.Current.load(std::memory_order_acquire);
+	return table->Slots[Probe(*table, str, size, hash)].load(std::memory_order_acquire);
+}
+void Interner::Grow(Shard& shard) {
+	auto& old = *shard.Tables.back();
+	std::unique_ptr<Table> table(new Table((old.Mask + 1) * 2));
+	for (size_t i = 0; i <= old.Mask; ++i) {
+		auto entry = old.Slots[i].load(std::memory_order_relaxed);
+		if (!entry) continue;
+		auto j = entry->Hash & table->Mask;
+		while (table->Slots[j].load(std::memory_order_relaxed)) j = (j + 1) & table->Mask;
+		table->Slots[j].store(entry, std::memory_order_relaxed);
+	}
+	shard.Current.store(table.get(), std::memory_order_release);
+	shard.Tables.emplace_back(std::move(table));
+}
+SymbolID Interner::Intern(const char* str, size_t size) {
+	if (!size) return none;
+	auto hash = static_cast<uint32_t>(GenerateHash(str, size));
+	auto idx = GetShardIndex(hash);
+	auto& shard = m_Shards[idx];
+	if (auto entry = Lookup(shard, str, size, hash))
+		return entry->ID;
+
+	// it could've been added since we looked, but not again until we're done
+	std::lock_guard<std::mutex> lock(shard.Mutex);
+	auto& table = *shard.Tables.back();
+	auto i = Probe(table, str, size, hash);
+	if (auto entry = table.Slots[i].load(std::memory_order_relaxed))
+		return entry->ID;
+
+	auto id = static_cast<SymbolID>(((shard.Entries.size() << shard_bits) | idx) + 1);
+	shard.Entries.push_back(Entry{ hash, id, std::string(str, size) });
+	table.Slots[i].store(&shard.Entries.back(), std::memory_order_release);
+	if (shard.Entries.size() * 2 >= table.Mask + 1) Grow(shard);
+	return id;
+}
+SymbolID Interner::Find(const char* str, size_t size) const {
+	if (!size) return none;
+	auto hash = static_cast<uint32_t>(GenerateHash(str, size));
+	auto entry = Lookup(m_Shards[GetShardIndex(hash)], str, size, hash);
+	return entry ? entry->ID : none;
+}
+const std::string& Interner::Get(SymbolID id) const {
+	if (id == none) return empty_string;
+	auto& shard = m_Shards[(id - 1) & (num_shards - 1)];
+	auto i = (id - 1) >> shard_bits;
+	std::lock_guard<std::mutex> lock(shard.Mutex);
+	return i < shard.Entries.size() ? shard.Entries[i].String : empty_string;
+}
+size_t Interner::Size() const {
+	size_t size = 0;
+	for (auto& shard : m_Shards) {
+		std::lock_guard<std::mutex> lock(shard.Mutex);
+		size += shard.Entries.size();
+	}
+	return size;
+}
@@ -0,0 +1,77 @@
+/**********************************************************/
+// SCRambl Advanced SCR Compiler/Assembler
+// This program is distributed freely under the MIT license
+// (See the LICENSE file provided
+//	 or copy at http://opensource.org/licenses/MIT)
+/**********************************************************/
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace SCRambl
+{
+	// Number standing in for an interned string - equal strings always get the same number
+	using SymbolID = uint32_t;
+
+	// Hands out a number for each distinct string, so tables can key on numbers rather than copies of strings
+	// One is kept for the whole build, so the numbers can be passed between tasks (and threads)
+	// Strings are split between shards by their hash - only adding a string to a shard locks it, finding one never does
+	class Interner
+	{
+	public:
+		// never handed out - "" is none, too
+		static const SymbolID none = 0;
+
+		Interner();
+		Interner(const Interner&) = delete;
+
+		// Number of the string, interning it if it's new
+		SymbolID Intern(const char* str, size_t size);
+		inline SymbolID Intern(const std::string& str) { return Intern(str.data(), str.size()); }
+		// Number of the string, or none if it's never been interned
+		SymbolID Find(const char* str, size_t size) const;
+		inline SymbolID Find(const std::string& str) const { return Find(str.data(), str.size()); }
+		// String of an interned number - stays put for as long as the interner does
+		const std::string& Get(SymbolID) const;
+		// Number of strings interned
+		size_t Size() const;
+
+	private:
+		static const unsigned shard_bits = 6;
+		static const size_t num_shards = 1 << shard_bits;
+
+		struct Entry {
+			uint32_t Hash;
+			SymbolID ID;
+			std::string String;
+		};
+		// open addressed, always a power of 2 in size - an entry is never moved once it's in a slot
+		struct Table {
+			size_t Mask;
+			std::unique_ptr<std::atomic<const Entry*>[]> Slots;
+
+			Table(size_t size);
+		};
+		struct Shard {
+			std::atomic<const Table*> Current;			// read without the lock
+			mutable std::mutex Mutex;					// held to add strings
+			std::deque<Entry> Entries;					// by ID (a deque, so they don't move as more are added)
+			std::vector<std::unique_ptr<Table>> Tables;	// old ones are kept, something could still be reading them
+		};
+
+		static inline size_t GetShardIndex(uint32_t hash) { return hash >> (32 - shard_bits); }
+		// slot the string is in, or the free slot it'd go in
+		static size_t Probe(const Table&, const char* str, size_t size, uint32_t hash);
+		// interned entry of the string, or nullptr
+		static const Entry* Lookup(const Shard&, const char* str, size_t size, uint32_t hash);
+		// double the slots once they're half full
+		static void Grow(Shard&);
+
+		Shard m_Shards[num_shards];
+	};
+}
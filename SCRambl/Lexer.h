@@ -29,6 +29,8 @@ namespace SCRambl
 			void Disable() { enabled = false; }
 			// use this to turn it on
 			void Enable() { enabled = true; }
+			// is it on?
+			bool IsEnabled() const { return enabled; }
 			// do a scan
 			inline bool DoScan(class State& state, Scripts::Position& pos) {
 				return enabled ? Scan(state, pos) : false;
@@ -6,21 +6,104 @@ using namespace SCRambl;
 using namespace SCRambl::Linking;
 
 void Linker::Link() {
-			
+	if (m_InputIdx < m_Inputs.size())
+		LinkObject(m_InputIdx++);
+	else
+		Finish();
+}
+void Linker::LinkObject(size_t idx) {
+	auto& input = m_Inputs[idx];
+	auto& object = input.Object;
+	auto code = input.Data.data();
+
+	// where each label referred to ends up - the object's own labels come before global ones
+	auto& refs = object.GetRefs();
+	std::vector<uint64_t> targets(refs.size());
+	for (size_t i = 0; i < refs.size(); ++i) {
+		if (auto label = object.FindLabel(refs[i]))
+			targets[i] = input.Base + label->Offset;
+		else {
+			auto it = m_GlobalLabels.find(refs[i]);
+			if (it != m_GlobalLabels.end())
+				targets[i] = it->second;
+			else
+				m_Task.Event<error_unresolved_label>(refs[i]);
+		}
+	}
+
+	// copy the code, patching each value that holds label offsets
+	std::vector<uint32_t> out_of_range;
+	object.Relocate(m_Output, code, targets, out_of_range);
+	for (auto ref : out_of_range)
+		m_Task.Event<error_label_out_of_range>(refs[ref]);
+
+	// the code's been copied
+	input.Data.clear();
+	input.Data.shrink_to_fit();
 }
 void Linker::Init() {
-	//auto scriptName = m_Build->CreateOutputFile();
-			
+	m_Task.Event<event_begin>();
+	m_Inputs.clear();
+	m_InputIdx = 0;
+	m_GlobalLabels.clear();
+
+	for (auto& path : m_Build->GetObjects()) {
+		m_Inputs.emplace_back();
+		auto& input = m_Inputs.back();
+		input.Path = path;
+		if (!m_Build->ReadOutput(path, input.Data)) {
+			m_Task.Event<error_object_not_found>(path);
+			m_Inputs.pop_back();
+		}
+		else if (!input.Object.Read(input.Data.data(), input.Data.size())) {
+			m_Task.Event<error_invalid_object>(path);
+			m_Inputs.pop_back();
+		}
+	}
+
+	// lay out the image - each object's code goes after the last
+	uint64_t size = 0;
+	for (auto& input : m_Inputs) {
+		input.Base = size;
+		size += input.Object.GetCodeSize();
+
+		for (auto& label : input.Object.GetLabels()) {
+			if (!label.Global) continue;
+			if (!m_GlobalLabels.emplace(label.Name, input.Base + label.Offset).second)
+				m_Task.Event<error_duplicate_global_label>(label.Name);
+		}
+	}
+
+	auto name = m_Build->GetEnvVar("ScriptName").AsString();
+	if (name.empty()) name = "main";
+	auto ext = m_Build->GetScriptExtension();
+	m_Output.Open(m_Build->CreateOutputFile(name + "." + (ext.empty() ? "scm" : ext)));
+	m_State = linking;
+}
+void Linker::Finish() {
+	if (m_Output.IsOpen()) {
+		m_Build->Count(Stat::bytes_emitted, m_Output.Size());
+		m_Output.Close();
+	}
+	m_Inputs.clear();
+	m_State = finished;
+	m_Task.Event<event_finish>();
 }
 void Linker::Reset() {
+	m_Output.Close();
+	m_Inputs.clear();
+	m_InputIdx = 0;
+	m_GlobalLabels.clear();
+	m_State = init;
 }
 void Linker::Run() {
 	switch (m_State) {
 	case init:
 		Init();
+		return;
 	case linking:
 		Link();
-		break;
+		return;
 	}
 }
 Linker::Linker(Task& task, Engine& engine, Build* build) : m_Engine(engine), m_Task(task), m_Build(build)
@@ -8,13 +8,40 @@
 #include "Tasks.h"
 #include "Scripts.h"
 #include "Compiler.h"
+#include "ObjectFile.h"
 
 namespace SCRambl
 {
 	namespace Linking
 	{
 		class Task;
+		class Error {
+		public:
+			enum ID {
+				// involuntary errors (errors that should be impossible!!) (500+)
+
+				// normal errors (1000+)
+				unresolved_label = 1000,
+				label_out_of_range = 1001,
+				duplicate_global_label = 1002,
+
+				// fatal errors (4000+)
+				fatal_begin = 4000,
+				object_not_found = 4000,
+				invalid_object = 4001,
+				fatal_end,
+			};
+
+			Error(ID id) : m_ID(id)
+			{ }
+			inline operator ID() const			{ return m_ID; }
 
+		private:
+			ID			m_ID;
+		};
+
+		// Links the objects compiled for the build into one image
+		// Each object's code is placed after the last (their sizes are all known up front), then label references are patched in as it's copied
 		class Linker
 		{
 		public:
@@ -35,31 +62,42 @@ namespace SCRambl
 			void Finish();
 			void Reset();
 			void Link();
+			void LinkObject(size_t);
 
 			template<typename T, typename U = T>
 			inline void Output(const U& v) {
-				m_File.write((char*)&v, sizeof(T));
+				m_Output.Write(&v, sizeof(T));
 			}
 			template<typename T>
 			inline void Output(const T& v, size_t n) {
-				m_File.write((char*)&v, n);
+				m_Output.Write(&v, n);
 			}
 			template<typename T, typename U = T>
 			inline void Output(const U* v) {
-				m_File.write((char*)v, sizeof(T));
+				m_Output.Write(v, sizeof(T));
 			}
 			template<typename T>
 			inline void Output(const T* v, size_t n) {
-				m_File.write((char*)v, n);
+				m_Output.Write(v, n);
 			}
 
 		private:
+			// An object to link
+			struct Input {
+				std::string Path;
+				std::string Data;
+				ObjectFile Object;
+				uint64_t Base = 0;				// where its code goes in the image
+			};
+
 			State m_State = init;
 			Engine& m_Engine;
 			Task& m_Task;
 			Build* m_Build;
-			std::ifstream m_Input;
-			std::ofstream m_File;
+			std::vector<Input> m_Inputs;
+			size_t m_InputIdx = 0;
+			std::unordered_map<std::string, uint64_t> m_GlobalLabels;		// offsets in the image
+			OutputWriter m_Output;
 		};
 
 		/*\ Linker::Event \*/
@@ -68,6 +106,30 @@ namespace SCRambl
 			Warning,
 			Error,
 		};
+		template<typename T>
+		struct event : public build_event {
+			explicit event(const char* name, const Engine& engine) : build_event(engine) {
+				LinkEvent<T>(name);
+			}
+		};
+		struct event_begin : public event<event_begin> {
+			event_begin(const Engine& engine) : event("begin", engine)
+			{ }
+		};
+		struct event_finish : public event<event_finish> {
+			event_finish(const Engine& engine) : event("finish", engine)
+			{ }
+		};
+		template<Error::ID TID, typename... TArgs>
+		struct event_error : public error_event_data<TArgs...> {
+			event_error(const Engine& engine, TArgs... args) : error_event_data(Basic::Error(engine, TID), std::forward<TArgs>(args)...)
+			{ }
+		};
+		using error_unresolved_label			= event_error<Error::unresolved_label, std::string>;
+		using error_label_out_of_range			= event_error<Error::label_out_of_range, std::string>;
+		using error_duplicate_global_label		= event_error<Error::duplicate_global_label, std::string>;
+		using error_object_not_found			= event_error<Error::object_not_found, std::string>;
+		using error_invalid_object				= event_error<Error::invalid_object, std::string>;
 
 		/*\ Linker::Task \*/
 		class Task : public TaskSystem::Task, private Linker
@@ -80,6 +142,11 @@ namespace SCRambl
 			bool IsRunning() const { return Linker::IsRunning(); }
 			bool IsTaskFinished() const final override { return Linker::IsFinished(); }
 
+			template<typename TEvent, typename... TArgs>
+			inline size_t Event(TArgs&&... args) {
+				return CallEvent(TEvent(m_Engine, std::forward<TArgs>(args)...));
+			}
+
 		protected:
 			void RunTask() final override { Linker::Run(); }
 			void ResetTask() final override { Linker::Reset(); }
@@ -12,29 +12,46 @@ namespace SCRambl
 		{ "__SCR",				Macro("__SCR", MacroCode({ "0x201300" })) }
 	};*/
 
+	const size_t Macro::no_param;
+
 	Macro::Macro(const Macro::Name& name) : m_Name(name)
 	{ }
 	Macro::Macro(const Macro::Name& name, const Macro::Code& code) : m_Name(name), m_Code(code)
 	{
 		m_Code->Erase(std::remove(m_Code->Begin(), m_Code->End(), '\n'), m_Code->End());
 	}
+	Macro::Macro(const Macro::Name& name, const Macro::Code& code, const Macro::Body& body) : Macro(name, code)
+	{
+		m_Body = body;
+	}
+	Macro::Macro(const Macro::Name& name, const Macro::Code& code, const Macro::Body& body, const Macro::Params& params) : Macro(name, code, body)
+	{
+		m_Params = params;
+		m_FunctionLike = true;
+	}
 	Macro::~Macro()
 	{ }
 	
 	MacroMap::MacroMap(const Map& predefined) : m_Map(predefined)
 	{ }
-	const Macro* MacroMap::Get(const Macro::Name& name) const {
-		auto it = m_Map.find(*name);
+	const Macro* MacroMap::Get(SymbolID id) const {
+		auto it = m_Map.find(id);
 		return it != m_Map.end() ? &it->second : nullptr;
 	}
-	void MacroMap::Define(const Macro::Name& name) {
-		m_Map.emplace(name, Macro(name));
+	void MacroMap::Define(SymbolID id, const Macro::Name& name) {
+		m_Map.emplace(id, Macro(name));
+	}
+	void MacroMap::Define(SymbolID id, const Macro::Name& name, const Macro::Code& code) {
+		m_Map.emplace(id, Macro(name, code));
+	}
+	void MacroMap::Define(SymbolID id, const Macro::Name& name, const Macro::Code& code, const Macro::Body& body) {
+		m_Map.emplace(id, Macro(name, code, body));
 	}
-	void MacroMap::Define(const Macro::Name& name, const Macro::Code& code) {
-		m_Map.emplace(name, Macro(name, code));
+	void MacroMap::Define(SymbolID id, const Macro::Name& name, const Macro::Code& code, const Macro::Body& body, const Macro::Params& params) {
+		m_Map.emplace(id, Macro(name, code, body, params));
 	}
-	void MacroMap::Undefine(const Macro::Name& name) {
-		m_Map.erase(name);
+	void MacroMap::Undefine(SymbolID id) {
+		m_Map.erase(id);
 	}
 	size_t MacroMap::Size() const {
 		return m_Map.size();
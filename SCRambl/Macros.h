@@ -9,6 +9,8 @@
 #include <vector>
 #include "Identifiers.h"
 #include "Symbols.h"
+#include "Scripts-code.h"
+#include "Interner.h"
 
 namespace SCRambl
 {
@@ -69,32 +71,66 @@ namespace SCRambl
 			inline operator const CodeLine &() const { return Symbols(); }
 		};
 
+		// A bit of the body - either a range of code, or the slot where an argument goes
+		struct Piece {
+			Scripts::Range Range;
+			size_t Param;
+
+			Piece(const Scripts::Range& range) : Range(range), Param(no_param)
+			{ }
+			Piece(size_t param) : Param(param)
+			{ }
+
+			inline bool IsParam() const { return Param != no_param; }
+		};
+		static const size_t no_param = static_cast<size_t>(-1);
+
+		// Where the code of the macro is, in the code it was defined in - expanding it lexes it from there
+		using Body = std::vector<Piece>;
+		// Names of the parameters of a function-like macro
+		using Params = std::vector<std::string>;
+
 		Macro(const Name&);
 		Macro(const Name&, const Code&);
+		Macro(const Name&, const Code&, const Body&);
+		Macro(const Name&, const Code&, const Body&, const Params&);
 		~Macro();
 
 		inline const Name& GetName() const { return m_Name; }
 		inline const Code& GetCode() const { return m_Code; }
 		inline Code& GetCode() { return m_Code; }
+		inline const Body& GetBody() const { return m_Body; }
+		inline const Params& GetParams() const { return m_Params; }
+		// Only expanded when followed by arguments in parentheses
+		inline bool IsFunctionLike() const { return m_FunctionLike; }
 
 	private:
 		// stores the code within the macro, which can be more than one line
 		Name m_Name;
 		Code m_Code;
+		Body m_Body;
+		Params m_Params;
+		bool m_FunctionLike = false;
 	};
 	class MacroMap {
 	public:
-		using Map = std::map<std::string, Macro>;
+		// keyed by the interned name
+		using Map = std::unordered_map<SymbolID, Macro>;
 
 		MacroMap() = default;
 		MacroMap(const Map& predefined);
 
-		const Macro* Get(const Macro::Name&) const;
-		void Define(const Macro::Name&);
-		void Define(const Macro::Name&, const Macro::Code&);
-		void Undefine(const Macro::Name&);
+		const Macro* Get(SymbolID) const;
+		void Define(SymbolID, const Macro::Name&);
+		void Define(SymbolID, const Macro::Name&, const Macro::Code&);
+		void Define(SymbolID, const Macro::Name&, const Macro::Code&, const Macro::Body&);
+		void Define(SymbolID, const Macro::Name&, const Macro::Code&, const Macro::Body&, const Macro::Params&);
+		void Undefine(SymbolID);
 		size_t Size() const;
 
+		inline Map::const_iterator begin() const { return m_Map.begin(); }
+		inline Map::const_iterator end() const { return m_Map.end(); }
+
 	private:
 		// macro macro maaaap... I wanna be, a macro map!
 		Map m_Map;
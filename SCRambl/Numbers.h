@@ -355,78 +355,99 @@ namespace SCRambl
 				return c == 'x' || c == 'X';
 			}
 
+			// check for the first digit and skip any prefix
+			bool ReadPrefix(Scripts::Position& pos) {
+				m_Hex = false;
+				m_Float = false;
+				if (pos->GetType() != Symbol::number) return false;
+				// if 0 is first, check for a prefix
+				if (*pos == '0') {
+					auto pre = pos;
+					if (++pre) {
+						if (IsHexPrefix(*pre)) {
+							m_Hex = true;
+							pos = pre;
+							if (!++pos) return false;
+						}
+					}
+				}
+				return true;
+			}
+			// read the digits and store the value
+			void ReadDigits(Scripts::Position& pos) {
+				// avoid much use of floats
+				unsigned long n = 0;
+				unsigned long d = 1;		// number of decimal places
+				unsigned long f = 0;		// the RHS of the decimal point
+				do {
+					// make numbers, not war?
+					if (!m_Float) {
+						if (pos->GetType() == Symbol::number)
+							n = n * (m_Hex ? 0x10 : 10) + *pos - '0';
+						else if (m_Hex) {
+							if (*pos >= 'A' && *pos <= 'F')
+								n = n * 0x10 + *pos - 'A' + 0xA;
+							else if (*pos >= 'a' && *pos <= 'f')
+								n = n * 0x10 + *pos - 'a' + 0xA;
+							else break;
+						}
+						else if (*pos == '.') {
+							// lets start floating
+							m_Float = true;
+						}
+						else break;
+					} else {
+						if (pos->GetType() == Symbol::number) {
+							f = f * 10 + *pos - '0';
+							d *= 10;
+						}
+						else break;
+					}
+				} while (++pos);
+				if (m_Float) m_FloatVal = n + ((float)f / (float)d);
+				else m_IntVal = n;
+			}
+
 		public:
 			bool Scan(Lexing::State& state, Scripts::Position& pos) override {
 				switch (state) {
 				case Lexing::State::before:
-					m_Hex = false;
-					m_Float = false;
-
 					// obviously we need to make sure this is a number
-					if (pos->GetType() == Symbol::number) {
-						// if 0 is first, check for a prefix
-						if (*pos == '0') {
-							auto pre = pos;
-							if (++pre) {
-								if (IsHexPrefix(*pre)) {
-									m_Hex = true;
-									pos = pre;
-									if (!++pos) return false;
-								}
-							}
-						}
+					if (ReadPrefix(pos)) {
 						state = Lexing::State::inside;
 						return true;
 					}
 					return false;
 
-				case Lexing::State::inside: {
-					// avoid much use of floats
-					unsigned long n = 0;
-					unsigned long d = 1;		// number of decimal places
-					unsigned long f = 0;		// the RHS of the decimal point
-					do {
-						// make numbers, not war?
-						if (!m_Float) {
-							if (pos->GetType() == Symbol::number)
-								n = n * (m_Hex ? 0x10 : 10) + *pos - '0';
-							else if (m_Hex) {
-								if (*pos >= 'A' && *pos <= 'F')
-									n = n * 0x10 + *pos - 'A' + 0xA;
-								else if (*pos >= 'a' && *pos <= 'f')
-									n = n * 0x10 + *pos - 'a' + 0xA;
-								else break;
-							}
-							else if (*pos == '.') {
-								// lets start floating
-								m_Float = true;
-							}
-							else break;
-						} else {
-							if (pos->GetType() == Symbol::number) {
-								f = f * 10 + *pos - '0';
-								d *= 10;
-							}
-							else break;
-						}
-					} while (++pos);
-					if (m_Float) m_FloatVal = n + ((float)f / (float)d);
-					else m_IntVal = n;
+				case Lexing::State::inside:
+					ReadDigits(pos);
 					state = Lexing::State::after;
 					return true;
-				}
 				case Lexing::State::after:
 					return true;
 				}
 				return false;
 			}
 
+			// Scan a whole number in one go, for lexers that don't race the scanners
+			// 'inside' gets the position after any prefix
+			bool Match(Scripts::Position& pos, Scripts::Position& inside) {
+				if (!ReadPrefix(pos)) return false;
+				inside = pos;
+				ReadDigits(pos);
+				return true;
+			}
+
 			template<typename T> inline T Get() const		{ return m_Float ? (T)m_FloatVal : (T)m_IntVal; }
 			template<> inline float Get<float>() const		{ return m_Float ? m_FloatVal : (float)m_IntVal; }
 
 			template<typename T> bool Is() const;
 			template<> inline bool Is<int>() const			{ return !m_Float; }
 			template<> inline bool Is<float>() const		{ return m_Float; }
+
+			// Put back the value of a number scanned before, so it can be got again without scanning it again
+			inline void Set(long long val)					{ m_Float = false; m_IntVal = val; }
+			inline void Set(float val)						{ m_Float = true; m_FloatVal = val; }
 		};
 	};
 }
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "stdafx.h"
+#include "ObjectFile.h"
+#include "utils.h"
+
+using namespace SCRambl;
+
+namespace {
+	// code size, number of labels, refs and relocations, version, magic
+	const size_t trailer_size = sizeof(uint64_t) + sizeof(uint32_t) * 5;
+
+	void WriteString(OutputWriter& out, const std::string& str) {
+		out.Write<uint32_t>(static_cast<uint32_t>(str.size()));
+		out.Write(str.data(), str.size());
+	}
+
+	// Reads values out of a range of bytes, failing once it runs past the end
+	class Reader {
+	public:
+		Reader(const char* data, size_t size) : m_Ptr(data), m_End(data + size)
+		{ }
+
+		template<typename T>
+		bool Read(T& v) {
+			if (static_cast<size_t>(m_End - m_Ptr) < sizeof(T)) return false;
+			memcpy(&v, m_Ptr, sizeof(T));
+			m_Ptr += sizeof(T);
+			return true;
+		}
+		bool Read(std::string& str) {
+			uint32_t size;
+			if (!Read(size) || static_cast<size_t>(m_End - m_Ptr) < size) return false;
+			str.assign(m_Ptr, size);
+			m_Ptr += size;
+			return true;
+		}
+
+	private:
+		const char* m_Ptr;
+		const char* m_End;
+	};
+}
+
+const uint32_t ObjectFile::magic;
+const uint32_t ObjectFile::version;
+
+void ObjectFile::AddLabel(const std::string& name, uint32_t offset, bool global) {
+	m_LabelMap.emplace(name, m_Labels.size());
+	m_Labels.push_back({name, offset, global});
+}
+void ObjectFile::AddRelocation(const std::string& name, uint64_t position, size_t value_size, size_t shift, size_t bits) {
+	Relocation reloc;
+	reloc.Ref = AddRef(name);
+	reloc.Position = static_cast<uint32_t>(position);
+	reloc.ValueSize = static_cast<uint8_t>(value_size);
+	reloc.Shift = static_cast<uint8_t>(shift);
+	reloc.Bits = static_cast<uint8_t>(bits);
+	m_Relocations.push_back(reloc);
+}
+uint32_t ObjectFile::AddRef(const std::string& name) {
+	auto it = m_RefMap.find(name);
+	if (it != m_RefMap.end()) return it->second;
+	auto idx = static_cast<uint32_t>(m_Refs.size());
+	m_Refs.push_back(name);
+	m_RefMap.emplace(name, idx);
+	return idx;
+}
+const ObjectFile::LabelDef* ObjectFile::FindLabel(const std::string& name) const {
+	auto it = m_LabelMap.find(name);
+	return it != m_LabelMap.end() ? &m_Labels[it->second] : nullptr;
+}
+void ObjectFile::WriteTables(OutputWriter& out, uint64_t code_size) const {
+	for (auto& label : m_Labels) {
+		WriteString(out, label.Name);
+		out.Write<uint32_t>(label.Offset);
+		out.Write<uint8_t>(label.Global ? 1 : 0);
+	}
+	for (auto& ref : m_Refs) {
+		WriteString(out, ref);
+	}
+	for (auto& reloc : m_Relocations) {
+		out.Write<uint32_t>(reloc.Ref);
+		out.Write<uint32_t>(reloc.Position);
+		out.Write<uint8_t>(reloc.ValueSize);
+		out.Write<uint8_t>(reloc.Shift);
+		out.Write<uint8_t>(reloc.Bits);
+	}
+	out.Write<uint64_t>(code_size);
+	out.Write<uint32_t>(static_cast<uint32_t>(m_Labels.size()));
+	out.Write<uint32_t>(static_cast<uint32_t>(m_Refs.size()));
+	out.Write<uint32_t>(static_cast<uint32_t>(m_Relocations.size()));
+	out.Write<uint32_t>(version);
+	out.Write<uint32_t>(magic);
+}
+bool ObjectFile::Read(const char* data, size_t size) {
+	Clear();
+	if (size < trailer_size) return false;
+
+	Reader trailer(data + size - trailer_size, trailer_size);
+	uint32_t num_labels, num_refs, num_relocs, ver, mag;
+	trailer.Read(m_CodeSize);
+	trailer.Read(num_labels);
+	trailer.Read(num_refs);
+	trailer.Read(num_relocs);
+	trailer.Read(ver);
+	trailer.Read(mag);
+	if (mag != magic || ver != version || m_CodeSize > size - trailer_size) {
+		Clear();
+		return false;
+	}
+
+	Reader reader(data + m_CodeSize, size - trailer_size - static_cast<size_t>(m_CodeSize));
+	m_Labels.resize(num_labels);
+	for (size_t i = 0; i < num_labels; ++i) {
+		auto& label = m_Labels[i];
+		uint8_t global;
+		if (!reader.Read(label.Name) || !reader.Read(label.Offset) || !reader.Read(global)) {
+			Clear();
+			return false;
+		}
+		label.Global = global != 0;
+		m_LabelMap.emplace(label.Name, i);
+	}
+	m_Refs.resize(num_refs);
+	for (uint32_t i = 0; i < num_refs; ++i) {
+		if (!reader.Read(m_Refs[i])) {
+			Clear();
+			return false;
+		}
+		m_RefMap.emplace(m_Refs[i], i);
+	}
+	m_Relocations.resize(num_relocs);
+	for (auto& reloc : m_Relocations) {
+		if (!reader.Read(reloc.Ref) || !reader.Read(reloc.Position) || !reader.Read(reloc.ValueSize)
+			|| !reader.Read(reloc.Shift) || !reader.Read(reloc.Bits)
+			|| reloc.Ref >= num_refs || reloc.Position + reloc.ValueSize > m_CodeSize || reloc.ValueSize > sizeof(uint64_t))
+		{
+			Clear();
+			return false;
+		}
+	}
+	return true;
+}
+void ObjectFile::Relocate(OutputWriter& out, const char* code, const std::vector<uint64_t>& targets, std::vector<uint32_t>& out_of_range) const {
+	auto code_size = static_cast<size_t>(m_CodeSize);
+	size_t pos = 0;
+	for (size_t i = 0; i < m_Relocations.size();) {
+		auto position = m_Relocations[i].Position;
+		auto value_size = m_Relocations[i].ValueSize;
+		if (position < pos) {
+			BREAK();
+			++i;
+			continue;
+		}
+
+		out.Write(code + pos, position - pos);
+		uint64_t value = 0;
+		memcpy(&value, code + position, value_size);
+		for (; i < m_Relocations.size() && m_Relocations[i].Position == position; ++i) {
+			auto& reloc = m_Relocations[i];
+			auto target = targets[reloc.Ref];
+			uint64_t mask = reloc.Bits >= 64 ? ~0ull : (1ull << reloc.Bits) - 1;
+			if (target & ~mask)
+				out_of_range.push_back(reloc.Ref);
+			value = (value & ~(mask << reloc.Shift)) | ((target & mask) << reloc.Shift);
+		}
+		out.Write(&value, value_size);
+		pos = position + value_size;
+	}
+	out.Write(code + pos, code_size - pos);
+}
+void ObjectFile::Clear() {
+	m_CodeSize = 0;
+	m_Labels.clear();
+	m_LabelMap.clear();
+	m_Refs.clear();
+	m_RefMap.clear();
+	m_Relocations.clear();
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+/**********************************************************/
+// SCRambl Advanced SCR Compiler/Assembler
+// This program is distributed freely under the MIT license
+// (See the LICENSE file provided
+//	 or copy at http://opensource.org/licenses/MIT)
+/**********************************************************/
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Output.h"
+
+namespace SCRambl
+{
+	// Tables of a compiled object - the labels its code defines and the places its code refers to labels
+	// The code is written first and the tables go after it, with a trailer at the very end saying how big it all is
+	// The linker places each object's code and patches the references, without parsing anything again
+	class ObjectFile
+	{
+	public:
+		// A label defined by the code, at an offset from the start of it
+		struct LabelDef {
+			std::string Name;
+			uint32_t Offset;
+			bool Global;
+		};
+		// A reference to a label in the code - the label's offset goes in 'Bits' bits of the value at 'Position', shifted by 'Shift'
+		struct Relocation {
+			uint32_t Ref;						// index of the name referred to
+			uint32_t Position;
+			uint8_t ValueSize;					// bytes in the value
+			uint8_t Shift;
+			uint8_t Bits;
+		};
+
+		static const uint32_t magic = 0x4F524353;		// "SCRO"
+		static const uint32_t version = 1;
+
+		// Add a label defined by the code
+		void AddLabel(const std::string& name, uint32_t offset, bool global);
+		// Add a reference to a label by name, for the value at 'position' in the code
+		void AddRelocation(const std::string& name, uint64_t position, size_t value_size, size_t shift, size_t bits);
+		// Write the tables, after the code (of 'code_size' bytes)
+		void WriteTables(OutputWriter&, uint64_t code_size) const;
+		// Read the tables of an object - returns false if it's not one (the code is the first GetCodeSize() bytes)
+		bool Read(const char* data, size_t size);
+		// Write out the code, with each label reference patched to where its label ended up ('targets', by ref)
+		// The refs of labels too far away for the bits they're given go in 'out_of_range'
+		void Relocate(OutputWriter&, const char* code, const std::vector<uint64_t>& targets, std::vector<uint32_t>& out_of_range) const;
+		void Clear();
+
+		inline uint64_t GetCodeSize() const { return m_CodeSize; }
+		inline const std::vector<LabelDef>& GetLabels() const { return m_Labels; }
+		inline const std::vector<std::string>& GetRefs() const { return m_Refs; }
+		inline const std::vector<Relocation>& GetRelocations() const { return m_Relocations; }
+		// Label defined by the code, or nullptr
+		const LabelDef* FindLabel(const std::string& name) const;
+
+	private:
+		uint32_t AddRef(const std::string& name);
+
+		uint64_t m_CodeSize = 0;
+		std::vector<LabelDef> m_Labels;
+		std::unordered_map<std::string, size_t> m_LabelMap;
+		std::vector<std::string> m_Refs;
+		std::unordered_map<std::string, uint32_t> m_RefMap;
+		std::vector<Relocation> m_Relocations;			// in order of position
+	};
+}
@@ -113,7 +113,7 @@ namespace SCRambl
 				// Obviously doesnt work if theres no way to get an operator by adding that grapheme, of course
 				bool Next(Grapheme graph, const Cell *& next_out) const {
 					// ensure we have a cell for this grapheme
-					if (m_Cells.size() >= (unsigned)graph) {
+					if (m_Cells.size() > (unsigned)graph) {
 						// give it the next cell
 						next_out = &m_Cells[graph];
 						return true;
@@ -179,7 +179,7 @@ namespace SCRambl
 			inline const Cell& GetCell(Grapheme graph) const {
 				static const Cell default_cell;
 				//ASSERT(m_Cells.size() >= (unsigned)graph && "Something went wrong internally - or an out of range grapheme ID was used");
-				return m_Cells.size() >= (unsigned)graph ? m_Cells[graph] : default_cell;
+				return m_Cells.size() > (unsigned)graph ? m_Cells[graph] : default_cell;
 			}
 		};
 
@@ -193,6 +193,8 @@ namespace SCRambl
 			const OperatorCell* m_LastOperatorCell;
 
 		public:
+			using Cell = OperatorCell;
+
 			Scanner(Table<T>& table) : m_Table(table)
 			{ }
 			bool Scan(Lexing::State& state, Scripts::Position& pos) {
@@ -235,7 +237,30 @@ namespace SCRambl
 				return false;
 			}
 
+			// Find the longest operator in one go, for lexers that don't race the scanners
+			bool Match(Scripts::Position& pos) {
+				if (!pos->HasGrapheme()) return false;
+				const OperatorCell* cell = &m_Table.GetCell(pos->GetGrapheme());
+				const OperatorCell* last_cell = cell->GetOperator() ? cell : nullptr;
+				auto last_pos = pos;
+				for (auto next = pos + 1; next && next->HasGrapheme(); ++next) {
+					if (!cell->Next(next->GetGrapheme(), cell)) break;
+					if (cell->GetOperator()) {
+						last_cell = cell;
+						last_pos = next;
+					}
+				}
+				if (!last_cell) return false;
+				m_Cell = last_cell;
+				pos = last_pos + 1;
+				return true;
+			}
+
 			T GetOperator() const { ASSERT(m_Cell && "Can only get the operator after a succesful scan");  return m_Cell->GetOperator(); }
+
+			// The cell of the operator last scanned, so it can be put back later without scanning it again
+			inline const Cell* GetCell() const { return m_Cell; }
+			inline void SetCell(const Cell* cell) { m_Cell = cell; }
 		};
 
 		// Operation
@@ -537,6 +562,7 @@ namespace SCRambl
 			OperatorTable& GetTable() { return m_Table; }
 			const OperatorTable& GetTable() const { return m_Table; }
 			size_t Size() const { return m_Storage.size(); }
+			OperatorRef GetOperator(size_t idx) { return idx < m_Storage.size() ? OperatorRef(m_Storage, idx) : OperatorRef(); }
 			const std::vector<OperatorRef>& DefaultOperators() const { return m_DefaultOperators; }
 
 		public:
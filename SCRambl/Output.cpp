@@ -0,0 +1,50 @@
+#include "stdafx.h"
+#include "Output.h"
+
+using namespace SCRambl;
+
+/* FileOutputSink */
+FileOutputSink::FileOutputSink(const std::string& path) : m_File(path, std::ios::out | std::ios::binary | std::ios::trunc)
+{ }
+bool FileOutputSink::Write(const char* data, size_t size) {
+	m_File.write(data, size);
+	return !!m_File;
+}
+bool FileOutputSink::Close() {
+	if (!m_File.is_open()) return false;
+	m_File.close();
+	return !m_File.fail();
+}
+
+/* OutputWriter */
+OutputWriter::OutputWriter(size_t buffer_size) : m_Buffer(buffer_size ? buffer_size : 1)
+{ }
+OutputWriter::~OutputWriter() {
+	Close();
+}
+void OutputWriter::Open(std::unique_ptr<OutputSink> sink) {
+	Close();
+	m_Sink = std::move(sink);
+	m_Used = 0;
+	m_Flushed = 0;
+	m_Good = m_Sink != nullptr;
+}
+bool OutputWriter::Close() {
+	if (!m_Sink) return false;
+	Flush();
+	if (!m_Sink->Close()) m_Good = false;
+	m_Sink.reset();
+	return m_Good;
+}
+bool OutputWriter::Flush() {
+	if (m_Used) {
+		WriteToSink(m_Buffer.data(), m_Used);
+		m_Used = 0;
+	}
+	return m_Good;
+}
+void OutputWriter::WriteToSink(const char* data, size_t size) {
+	if (m_Sink && !m_Sink->Write(data, size))
+		m_Good = false;
+	m_Flushed += size;
+}
@@ -0,0 +1,103 @@
+/**********************************************************/
+// SCRambl Advanced SCR Compiler/Assembler
+// This program is distributed freely under the MIT license
+// (See the LICENSE file provided
+//	 or copy at http://opensource.org/licenses/MIT)
+/**********************************************************/
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SCRambl
+{
+	// Where output ends up - only ever handed big chunks, by an OutputWriter
+	class OutputSink {
+	public:
+		virtual ~OutputSink() { }
+
+		// Write bytes to the end - returns false if they couldn't be
+		virtual bool Write(const char* data, size_t size) = 0;
+		// Done writing
+		virtual bool Close() { return true; }
+	};
+
+	// Output to a file
+	class FileOutputSink : public OutputSink {
+	public:
+		FileOutputSink(const std::string& path);
+
+		bool Write(const char* data, size_t size) override;
+		bool Close() override;
+		inline bool IsOpen() const { return m_File.is_open(); }
+
+	private:
+		std::ofstream m_File;
+	};
+
+	// Output kept in memory, in a string owned by someone else (e.g. the build)
+	class MemoryOutputSink : public OutputSink {
+	public:
+		MemoryOutputSink(std::string& data) : m_Data(data)
+		{ }
+
+		bool Write(const char* data, size_t size) override {
+			m_Data.append(data, size);
+			return true;
+		}
+
+	private:
+		std::string& m_Data;
+	};
+
+	// Buffers output so the sink gets it in big chunks, rather than a few bytes a time
+	// Nothing reaches the sink until the buffer fills or it's flushed
+	class OutputWriter {
+	public:
+		OutputWriter(size_t buffer_size = 0x10000);
+		OutputWriter(const OutputWriter&) = delete;
+		~OutputWriter();
+
+		// Start writing to the sink, closing any other first
+		void Open(std::unique_ptr<OutputSink> sink);
+		// Flush what's left and close the sink
+		bool Close();
+		inline bool IsOpen() const { return m_Sink != nullptr; }
+
+		// Add bytes to the output
+		inline void Write(const void* data, size_t size) {
+			if (size > m_Buffer.size() - m_Used) {
+				Flush();
+				// too big to bother buffering
+				if (size >= m_Buffer.size()) {
+					WriteToSink(static_cast<const char*>(data), size);
+					return;
+				}
+			}
+			memcpy(&m_Buffer[m_Used], data, size);
+			m_Used += size;
+		}
+		template<typename T>
+		inline void Write(const T& v) { Write(&v, sizeof(T)); }
+
+		// Hand everything buffered to the sink
+		bool Flush();
+
+		// Bytes written so far, buffered or not
+		inline uint64_t Size() const { return m_Flushed + m_Used; }
+		// Returns false if the sink has failed at any point
+		inline bool Good() const { return m_Good; }
+
+	private:
+		void WriteToSink(const char* data, size_t size);
+
+		std::unique_ptr<OutputSink> m_Sink;
+		std::vector<char> m_Buffer;
+		size_t m_Used = 0;
+		uint64_t m_Flushed = 0;
+		bool m_Good = true;
+	};
+}
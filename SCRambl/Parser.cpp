@@ -264,25 +264,28 @@ States Parser::Parse_Neutral_CheckIdentifier(IToken* tok) {
 	Commands::Vector vec;
 	auto& token = tok->Get<Tokens::Identifier::Info<>>();
 	auto range = token.GetValue<Tokens::Identifier::ScriptRange>();
-	auto name = range.Format();
+	// looked up straight from the code - it's only copied if it turns out to be a new label
+	size_t size;
+	auto name = range.Begin().View(range.End(), size);
 
-	if (auto type = GetType(name)) {
+	if (auto type = GetType(name, size)) {
 		m_TypeParseState = TypeParseState(type, tok);
 		return state_parsing_type;
 	}
 
-	else if (auto label = m_Build.GetScriptLabel(name)) {
+	else if (auto label = m_Build.GetScriptLabel(name, size)) {
 		m_Label = label;
 		m_LabelTokenIt = m_TokenIt;
 		AddLabelRef(label, m_TokenIt);
 		return state_parsing_label;
 	}
-	else if (m_ExtraCommands.FindCommands(name, vec) > 0 || m_Commands.FindCommands(name, vec) > 0) {
+	else if (m_ExtraCommands.FindCommands(name, size, vec) > 0 || m_Commands.FindCommands(name, size, vec) > 0) {
+		m_Build.Count(Stat::commands_resolved);
 		// make a token and store it
 		if (vec.size() == 1)
-			m_TokenIt->SetToken(new Tokens::Command::Info(Tokens::Type::Command, range, vec[0]));
+			m_TokenIt->SetToken(m_Tokens.Create<Tokens::Command::Info>(Tokens::Type::Command, range, vec[0]));
 		else
-			m_TokenIt->SetToken(new Tokens::Command::OverloadInfo(Tokens::Type::CommandOverload, range, vec));
+			m_TokenIt->SetToken(m_Tokens.Create<Tokens::Command::OverloadInfo>(Tokens::Type::CommandOverload, range, vec));
 
 		if (ParseCommandOverloads(vec)) {
 			BeginCommandParsing();
@@ -291,7 +294,7 @@ States Parser::Parse_Neutral_CheckIdentifier(IToken* tok) {
 		else BREAK();
 		return state_parsing_command;
 	}
-	else if (auto var = m_Build.GetScriptVariable(name)) {
+	else if (auto var = m_Build.GetScriptVariable(name, size)) {
 		m_Variable = var;
 		m_VariableTokenIt = m_TokenIt;
 		return state_parsing_variable;
@@ -299,7 +302,7 @@ States Parser::Parse_Neutral_CheckIdentifier(IToken* tok) {
 	else if (IsCommandParsing()/* && m_CommandArgIt->GetType().IsCompatible()*/) {
 		auto type = m_CommandParseState.commandArgIt->GetType();
 		if (type->HasValueType(Types::ValueSet::Label)) {
-			m_Label = m_Build.AddScriptLabel(name, m_SizeCount);
+			m_Label = m_Build.AddScriptLabel(range.Format(), m_SizeCount);
 			m_LabelTokenIt = m_TokenIt;
 			AddLabelRef(label, m_TokenIt);
 			return state_parsing_label;
@@ -314,10 +317,11 @@ States Parser::Parse_Neutral_CheckIdentifier(IToken* tok) {
 States Parser::Parse_Neutral_CheckLabel(IToken* tok) {
 	auto& token = tok->Get<Tokens::Label::Info>();
 	auto range = token.GetValue<Tokens::Label::ScriptRange>();
-	auto name = range.Format();
+	size_t size;
+	auto name = range.Begin().View(range.End(), size);
 	ScriptLabel* label = nullptr;
-	if (label = m_Build.GetScriptLabel(name)) (*label)->SetOffset(m_SizeCount);
-	else label = m_Build.AddScriptLabel(name, m_SizeCount);
+	if (label = m_Build.GetScriptLabel(name, size)) (*label)->SetOffset(m_SizeCount);
+	else label = m_Build.AddScriptLabel(range.Format(), m_SizeCount);
 	return state_neutral;
 }
 States Parser::Parse_Neutral_CheckDelimiter(IToken* tok) {
@@ -424,7 +428,7 @@ States Parser::Parse_Neutral_CheckString(IToken* tok) {
 }
 States Parser::Parse_Neutral() {
 	States new_state = state_neutral;
-	auto type = m_TokenIt->GetToken()->GetType<Tokens::Type>();
+	auto type = m_TokenIt->GetType();
 
 	switch (type) {
 	case Tokens::Type::Character:
@@ -739,10 +743,8 @@ Token Parser::GetToken() const {
 IToken* Parser::PeekToken(Tokens::Type type, size_t off) {
 	auto it = m_TokenIt + off;
 	if (it != m_Tokens.End()) {
-		auto tok = it->GetToken();
-		auto ty = tok->GetType<Tokens::Type>();
-		if (type == Tokens::Type::None || type == ty) {
-			return tok;
+		if (type == Tokens::Type::None || it->IsType(type)) {
+			return it->GetToken();
 		}
 	}
 	return nullptr;
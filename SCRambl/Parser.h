@@ -805,10 +805,10 @@ namespace SCRambl
 			States Parse_Construct();
 
 			inline bool IsEOLReached() const {
-				return m_TokenIt == m_Tokens.end() || IsCharacterEOL(m_TokenIt->GetToken());
+				return m_TokenIt == m_Tokens.end() || IsCharacterEOL(*m_TokenIt);
 			}
 			inline Tokens::Type GetCurrentTokenType() const {
-				return m_TokenIt->GetToken()->GetType<Tokens::Type>();
+				return m_TokenIt->GetType();
 			}
 			static Types::NumberValueType GetNumberValueType(Types::Value* value) {
 				return value->Extend<Types::NumberValue>().GetNumberType();
@@ -914,6 +914,9 @@ namespace SCRambl
 			static bool IsCharacterEOL(IToken* toke) {
 				return IsCharacter(toke) && GetCharacterValue(toke) == Character::EOL;
 			}
+			static bool IsCharacterEOL(const Tokens::Token& token) {
+				return token.IsType(Tokens::Type::Character) && token.GetEnum<Character::Type>() == Character::EOL;
+			}
 			static bool IsDelimiter(IToken* toke) {
 				return IsTokenType(toke, Tokens::Type::Delimiter);
 			}
@@ -1054,6 +1057,10 @@ namespace SCRambl
 				auto ptr = m_Types.GetType(name);
 				return (ptr ? ptr : m_Build.GetTypes().GetType(name)).Ref();
 			}
+			inline VecRef<Types::Type> GetType(const char* name, size_t size) {
+				auto ptr = m_Types.GetType(name, size);
+				return (ptr ? ptr : m_Build.GetTypes().GetType(name, size)).Ref();
+			}
 
 			void Init();
 			void Finish();
@@ -0,0 +1,102 @@
+#include "stdafx.h"
+#include "PrecompiledHeader.h"
+#include "utils.h"
+
+using namespace SCRambl;
+
+namespace {
+	// 'SCRH'
+	const uint32_t header_magic = 0x48524353;
+}
+
+/* PrecompiledHeader */
+PrecompiledHeader::PrecompiledHeader(std::string header, std::string path, const uint64_t (&definitions)[2]) : m_Header(header), m_Path(path) {
+	m_Definitions[0] = definitions[0];
+	m_Definitions[1] = definitions[1];
+}
+bool PrecompiledHeader::Open() {
+	if (m_Path.empty()) return false;
+	MappedFile file(m_Path);
+	if (!file.IsOpen() || !file.Data()) return false;
+
+	Reader reader(file.Data(), file.Size());
+	if (reader.Read<uint32_t>() != header_magic || reader.Read<uint32_t>() != version)
+		return false;
+
+	uint64_t definitions[2];
+	definitions[0] = reader.Read<uint64_t>();
+	definitions[1] = reader.Read<uint64_t>();
+	if (!reader.OK() || !SameHash(definitions, m_Definitions) || reader.ReadString() != m_Header)
+		return false;
+
+	BuildCache::Entry entry;
+	entry.Hash[0] = reader.Read<uint64_t>();
+	entry.Hash[1] = reader.Read<uint64_t>();
+	for (auto n = reader.Read<uint32_t>(); n && reader.OK(); --n) {
+		entry.Includes.emplace_back(reader.ReadString());
+		entry.Includes.back().Hash[0] = reader.Read<uint64_t>();
+		entry.Includes.back().Hash[1] = reader.Read<uint64_t>();
+	}
+	entry.Data = reader.ReadString();
+	auto macros = reader.ReadString();
+	std::vector<std::string> included;
+	for (auto n = reader.Read<uint32_t>(); n && reader.OK(); --n)
+		included.emplace_back(reader.ReadString());
+	if (!reader.OK() || !reader.AtEnd())
+		return false;
+
+	// it's no good if the header or anything it included has changed
+	uint64_t hash[2];
+	if (!BuildCache::HashFile(m_Header, hash) || !SameHash(hash, entry.Hash))
+		return false;
+	for (auto& inc : entry.Includes) {
+		if (!BuildCache::HashFile(inc.Path, hash) || !SameHash(hash, inc.Hash))
+			return false;
+	}
+
+	Store(std::move(entry), std::move(macros), std::move(included));
+	return true;
+}
+void PrecompiledHeader::Store(BuildCache::Entry entry, std::string macros, std::vector<std::string> included) {
+	m_Entry = std::move(entry);
+	m_Macros = std::move(macros);
+	m_Included = std::move(included);
+	m_Ready = true;
+}
+bool PrecompiledHeader::Save() const {
+	if (m_Path.empty() || !m_Ready) return false;
+
+	Writer writer;
+	writer.Write<uint32_t>(header_magic);
+	writer.Write<uint32_t>(version);
+	writer.Write<uint64_t>(m_Definitions[0]);
+	writer.Write<uint64_t>(m_Definitions[1]);
+	writer.Write(m_Header);
+	writer.Write<uint64_t>(m_Entry.Hash[0]);
+	writer.Write<uint64_t>(m_Entry.Hash[1]);
+	writer.Write<uint32_t>(m_Entry.Includes.size());
+	for (auto& inc : m_Entry.Includes) {
+		writer.Write(inc.Path);
+		writer.Write<uint64_t>(inc.Hash[0]);
+		writer.Write<uint64_t>(inc.Hash[1]);
+	}
+	writer.Write(m_Entry.Data);
+	writer.Write(m_Macros);
+	writer.Write<uint32_t>(m_Included.size());
+	for (auto& path : m_Included)
+		writer.Write(path);
+
+	return SaveFile(m_Path, writer.Buffer());
+}
+BuildCache::Header PrecompiledHeader::GetDependency() const {
+	BuildCache::Header dependency;
+	dependency.Path = m_Header;
+	dependency.Hash[0] = m_Entry.Hash[0];
+	dependency.Hash[1] = m_Entry.Hash[1];
+	dependency.Definitions[0] = m_Definitions[0];
+	dependency.Definitions[1] = m_Definitions[1];
+	return dependency;
+}
+bool PrecompiledHeader::Matches(const BuildCache::Header& dependency) const {
+	return m_Ready && dependency.Path == m_Header && SameHash(dependency.Hash, m_Entry.Hash) && SameHash(dependency.Definitions, m_Definitions);
+}
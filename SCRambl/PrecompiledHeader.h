@@ -0,0 +1,63 @@
+/**********************************************************/
+// SCRambl Advanced SCR Compiler/Assembler
+// This program is distributed freely under the MIT license
+// (See the LICENSE file provided
+//	 or copy at http://opensource.org/licenses/MIT)
+/**********************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include "BuildCache.h"
+
+namespace SCRambl
+{
+	// A header gone through once for any number of files, so including it just brings back what it left behind
+	// That's the macros it defined, the files it included and what it preprocessed to (the tokens, as stored in a BuildCache::Entry)
+	// Saved to a file to be used by later builds, for as long as the header, its includes and the definitions stay the same
+	// It's gone through on its own, so it mustn't depend on anything defined before it's included
+	class PrecompiledHeader
+	{
+	public:
+		// bump whenever the layout (or what's stored) changes
+		enum { version = 2 };
+
+		using Writer = BuildCache::Writer;
+		using Reader = BuildCache::Reader;
+
+		// 'header' should be the canonical path, as that's what includes are matched on - the snapshot is only kept in memory if 'path' is empty
+		PrecompiledHeader(std::string header, std::string path, const uint64_t (&definitions)[2]);
+
+		inline const std::string& GetHeader() const { return m_Header; }
+		inline const std::string& GetPath() const { return m_Path; }
+		// Has it been loaded or stored yet?
+		inline bool IsReady() const { return m_Ready; }
+
+		// Load the snapshot from its file - returns false if there isn't one, or the header or definitions have changed since
+		bool Open();
+		// Keep a freshly made snapshot - the entry should have the hash of the header and its includes
+		void Store(BuildCache::Entry entry, std::string macros, std::vector<std::string> included);
+		// Write the snapshot to its file
+		bool Save() const;
+
+		// What the header was preprocessed to
+		inline const BuildCache::Entry& GetEntry() const { return m_Entry; }
+		// The macros it defined (see Preprocessor::WriteMacros)
+		inline const std::string& GetMacros() const { return m_Macros; }
+		// Canonical paths of the files it included
+		inline const std::vector<std::string>& GetIncluded() const { return m_Included; }
+
+		// What the cache entry of a file that used it keeps of it
+		BuildCache::Header GetDependency() const;
+		// Is it the one a cache entry was made with?
+		bool Matches(const BuildCache::Header&) const;
+
+	private:
+		std::string m_Header;
+		std::string m_Path;
+		uint64_t m_Definitions[2];
+		bool m_Ready = false;
+		BuildCache::Entry m_Entry;
+		std::string m_Macros;
+		std::vector<std::string> m_Included;
+	};
+}
@@ -6,6 +6,18 @@
 using namespace SCRambl;
 using namespace SCRambl::Preprocessing;
 
+// Send an event - workers save them up for the build thread to send once it gets to their file
+template<typename TEvent, typename... TArgs>
+void Preprocessor::SendEvent(TArgs&&... args) {
+	if (m_DeferredEvents) {
+		// events can't be copied, so they're kept by pointer
+		auto event = std::make_shared<TEvent>(m_Engine, std::forward<TArgs>(args)...);
+		auto& task = m_Task;
+		m_DeferredEvents->emplace_back([&task, event]{ task.CallEvent(*event); });
+	}
+	else m_Task.Event<TEvent>(std::forward<TArgs>(args)...);
+}
+
 bool DoesDirectiveIgnoreSourceControl(Directive::Type dir) {
 	switch (dir) {
 	case Directive::IF:
@@ -18,11 +30,33 @@ bool DoesDirectiveIgnoreSourceControl(Directive::Type dir) {
 	}
 	return false;
 }
+// Skip a string literal in code that's not being lexed yet - returns false if the line ends first
+bool SkipStringLiteral(Scripts::Position& pos) {
+	while (++pos) {
+		if (*pos == '"') {
+			++pos;
+			return true;
+		}
+		if (pos->GetType() == Symbol::eol)
+			return false;
+		if (*pos == '\\' && (!(++pos) || pos->GetType() == Symbol::eol))
+			return false;
+	}
+	return false;
+}
 
-Preprocessor::Preprocessor(Task& task, Engine& engine, Build& build) :
+Preprocessor::Preprocessor(Task& task, Engine& engine, Build& build, Scripts::FileRef file, Tokens::Storage& tokens, DeferredEvents& events) :
+	Preprocessor(task, engine, build, tokens)
+{
+	m_Files.assign(1, file);
+	m_DeferredEvents = &events;
+}
+Preprocessor::Preprocessor(Task& task, Engine& engine, Build& build) : Preprocessor(task, engine, build, build.GetScript().GetTokens())
+{ }
+Preprocessor::Preprocessor(Task& task, Engine& engine, Build& build, Tokens::Storage& tokens) :
 	m_State(init), m_Task(task),
 	m_Engine(engine), m_Build(build),
-	m_Tokens(build.GetScript().GetTokens()),
+	m_Tokens(tokens),
 	m_Lexer(),
 	m_OperatorScanner(m_Operators),
 	m_Information(m_CodePos),
@@ -55,6 +89,7 @@ Preprocessor::Preprocessor(Task& task, Engine& engine, Build& build) :
 	m_Directives["ifndef"] = Directive::IFNDEF;
 	m_Directives["include"] = Directive::INCLUDE;
 	m_Directives["undef"] = Directive::UNDEF;
+	m_Directives["pragma"] = Directive::PRAGMA;
 
 	m_Directives["register_var"] = Directive::REGISTER_VAR;
 	m_Directives["register_command"] = Directive::REGISTER_COMMAND;
@@ -116,11 +151,40 @@ void Preprocessor::Reset() {
 void Preprocessor::Run() {
 	try {
 		switch (m_State) {
-		case init:
-			m_Task.Event<event_begin>();
-			m_CodePos = m_Build.GetScript().GetCode();
+		case init: {
+			SendEvent<event_begin>();
+
+			// all of the input files, in the order they were given
+			auto& files = m_Build.GetScript().GetFiles();
+			m_Files.clear();
+			for (size_t i = 0; i < files.size(); ++i)
+				m_Files.emplace_back(files, i);
+
+			// the precompiled header is made (or loaded) before anything can include it
+			PrecompileHeader();
+
+			// files are gone through separately when threaded or cached - it's not worth it for a lone file, unless cached
+			auto config = m_Build.GetConfig();
+			bool cached = config && config->Preprocessing().IsCached();
+			if (cached && !config->Preprocessing().IsIsolated() && m_Files.size() > 1) {
+				// each file sees what the ones before it defined, which a cached file wouldn't
+				SendError(Error::cache_not_isolated, config->Preprocessing().GetCachePath());
+				cached = false;
+			}
+			if (config && ((config->Preprocessing().IsIsolated() && m_Files.size() > 1) || cached)) {
+				RunParallel(config->Preprocessing().GetNumThreads(), cached);
+				m_State = finished;
+				SendEvent<event_finish>();
+				break;
+			}
+
 			m_State = lexing;
+			if (!StartFile(0)) {
+				m_State = finished;
+				SendEvent<event_finish>();
+			}
 			break;
+		}
 		default:
 			RunningState();
 			break;
@@ -128,12 +192,525 @@ void Preprocessor::Run() {
 			Reset();
 			break;
 		}
+
+		// hand what was counted over to the build
+		m_Build.AddStats(m_Stats);
+		m_Stats = TaskStats();
 	}
 	catch (...)
 	{
 		throw;
 	}
 }
+void Preprocessor::Preprocess() {
+	m_State = lexing;
+	if (!StartFile(0))
+		m_State = finished;
+	while (m_State != finished)
+		RunningState();
+}
+void Preprocessor::RunParallel(size_t num_threads, bool cached) {
+	// each file gets a preprocessor to itself - they're all made here as they poke the engine
+	std::vector<FileJob> jobs(m_Files.size());
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		auto& job = jobs[i];
+		job.Worker.reset(new Preprocessor(m_Task, m_Engine, m_Build, m_Files[i], job.TokenStorage, job.Events));
+	}
+
+	// files that haven't changed since the last build can be brought back from the cache
+	std::unique_ptr<BuildCache> cache;
+	auto config = m_Build.GetConfig();
+	if (cached) {
+		cache.reset(new BuildCache(config->Preprocessing().GetCachePath(), m_Build.GetDefinitionHash()));
+		cache->Open();
+		for (size_t i = 0; i < jobs.size(); ++i) {
+			auto& job = jobs[i];
+			auto path = m_Files[i] ? m_Files[i]->GetPath() : "";
+			if (path.empty() || !BuildCache::HashFile(path, job.CacheEntry.Hash)) continue;
+			job.Cached = cache->Lookup(path, job.CacheEntry.Hash);
+		}
+	}
+	bool caching = cache != nullptr;
+
+	if (!num_threads) num_threads = std::thread::hardware_concurrency();
+	if (num_threads > jobs.size()) num_threads = jobs.size();
+	if (!num_threads) num_threads = 1;
+
+	// whoever is free takes the next file
+	std::atomic<size_t> next_job(0);
+	auto tracer = m_Build.GetTracer();
+	auto work = [this, &jobs, &next_job, caching, tracer]{
+		for (size_t i; (i = next_job++) < jobs.size();) {
+			auto& job = jobs[i];
+			Tracer::Span span;
+			try {
+				if (job.Cached) {
+					if (tracer) span.Begin(tracer, "file", m_Files[i]->GetPath(), "cached");
+					if (job.Worker->ReadCache(*job.Cached))
+						continue;
+				}
+				if (tracer) span.Begin(tracer, "file", m_Files[i] ? m_Files[i]->GetPath() : "");
+				job.Worker->Preprocess();
+				if (caching && job.Worker->IsCacheable())
+					job.Store = job.Worker->WriteCache(job.CacheEntry);
+			}
+			catch (...) {
+				job.Exception = std::current_exception();
+			}
+		}
+	};
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < num_threads; ++i)
+		threads.emplace_back(work);
+	work();
+	for (auto& thread : threads)
+		thread.join();
+	for (auto& job : jobs)
+		m_Stats.Add(job.Worker->m_Stats);
+
+	if (cache) {
+		for (size_t i = 0; i < jobs.size(); ++i) {
+			if (jobs[i].Store)
+				cache->Store(m_Files[i]->GetPath(), std::move(jobs[i].CacheEntry));
+		}
+		cache->Save();
+	}
+
+	// put it all together in file order, so it comes out the same every time
+	for (auto& job : jobs) {
+		for (auto& event : job.Events)
+			event();
+		m_Tokens.Append(job.TokenStorage);
+		if (job.Exception)
+			std::rethrow_exception(job.Exception);
+	}
+}
+bool Preprocessor::StartFile(size_t index) {
+	m_FileIndex = index;
+	if (m_FileIndex >= m_Files.size() || !m_Files[m_FileIndex])
+		return false;
+	m_Code = m_Files[m_FileIndex]->GetCode();
+	m_CodePos = Scripts::Position(*m_Code);
+	m_MacroFrames.clear();
+	if (m_Build.GetTracer()) m_FileStart = Tracer::Clock::now();
+	return true;
+}
+void Preprocessor::RegisterCommand(std::string name, size_t opcode, std::vector<std::pair<VecRef<Types::Type>, bool>> args) {
+	auto& commands = m_Commands;
+	auto add = [&commands, name, opcode, args]{
+		auto command = commands.AddCommand(name, opcode, nullptr);
+		for (auto& arg : args)
+			command->AddArg(arg.first, arg.second);
+	};
+	// the other files are being preprocessed too, so wait until the ones before this are done
+	if (m_DeferredEvents) {
+		m_DeferredEvents->emplace_back(add);
+		m_RegisteredCommands.emplace_back(name, opcode, std::move(args));
+	}
+	else add();
+}
+bool Preprocessor::WriteCache(BuildCache::Entry& entry) const {
+	if (m_Files.size() != 1 || !m_Files[0] || !m_Code) return false;
+
+	// anything included has to be checked too
+	entry.Includes.clear();
+	for (auto& inc : m_Files[0]->GetIncludes()) {
+		entry.Includes.emplace_back(inc.GetPath());
+		if (!BuildCache::HashFile(entry.Includes.back().Path, entry.Includes.back().Hash))
+			return false;
+	}
+
+	// the precompiled header goes back in with the file, so that has to be the same too
+	auto header = m_Precompiled.Code ? m_Build.GetPrecompiledHeader() : nullptr;
+	if (m_Precompiled.Code && !header) return false;
+	entry.Precompiled = header ? header->GetDependency() : BuildCache::Header();
+	if (header) entry.Includes.insert(entry.Includes.end(), header->GetEntry().Includes.begin(), header->GetEntry().Includes.end());
+	auto from_header = [this](size_t index, size_t first, size_t num){
+		return m_Precompiled.Code && index >= first && index < first + num;
+	};
+
+	// the code as preprocessing left it, as the tokens point into it
+	BuildCache::Writer writer;
+	writer.Write(std::string(m_Code->GetData(), m_Code->GetSize()));
+	auto& lines = m_Code->GetLines();
+	writer.Write<uint32_t>(lines.size());
+	for (auto& line : lines) {
+		writer.Write<uint32_t>(line.GetLine());
+		writer.Write<uint64_t>(line.GetOffset());
+	}
+
+	// then the tokens - everything they hold is kept as offsets into the code (or the precompiled header's, for its macros)
+	// the header's own tokens are left out, it puts them back itself
+	auto write_position = [this, &writer](const Scripts::Position& pos) -> bool {
+		auto code = pos.GetCode();
+		if (code != m_Code && code != m_Precompiled.Code) return false;
+		writer.Write<uint8_t>(code == m_Code ? 0 : 1);
+		writer.Write<uint64_t>(pos.GetOffset());
+		return true;
+	};
+	auto write_range = [&write_position](Scripts::Range range){
+		return write_position(range.Begin()) && write_position(range.End());
+	};
+	writer.Write<uint32_t>(m_Precompiled.Token);
+	writer.Write<uint32_t>(m_Tokens.Size() - (m_Precompiled.Code ? m_Precompiled.NumTokens : 0));
+	size_t index = 0;
+	for (auto it = m_Tokens.Begin(); it; ++it, ++index) {
+		if (from_header(index, m_Precompiled.Token, m_Precompiled.NumTokens)) continue;
+		auto& token = *it;
+		auto& info = *token.GetToken();
+		writer.Write<uint8_t>(static_cast<uint8_t>(token.GetType()));
+		if (!write_position(token.GetPosition())) return false;
+		switch (token.GetType()) {
+		case Tokens::Type::Character:
+			writer.Write<int32_t>(token.GetEnum<int>());
+			break;
+		case Tokens::Type::Identifier:
+			if (!write_range(Tokens::Identifier::GetScriptRange(info))) return false;
+			break;
+		case Tokens::Type::Label:
+			if (!write_range(Tokens::Label::GetScriptRange(info))) return false;
+			break;
+		case Tokens::Type::Directive:
+			if (!write_range(Tokens::Directive::GetScriptRange(info))) return false;
+			break;
+		case Tokens::Type::Number:
+			if (!write_range(Tokens::Number::GetScriptRange(info))) return false;
+			if (Tokens::Number::IsTypeFloat(info)) {
+				writer.Write(true);
+				writer.Write<float>(token.GetFloat());
+			}
+			else {
+				writer.Write(false);
+				writer.Write<uint64_t>(token.GetInteger());
+			}
+			break;
+		case Tokens::Type::Operator: {
+			if (!write_range(Tokens::Operator::GetScriptRange(info))) return false;
+			auto op = Tokens::Operator::GetOperator<Operators::OperatorRef>(info);
+			if (!op) return false;
+			writer.Write<uint32_t>(op.Index());
+			break;
+		}
+		case Tokens::Type::String:
+			if (!write_range(Tokens::String::GetScriptRange(info))) return false;
+			writer.Write(Tokens::String::GetString(info));
+			break;
+		case Tokens::Type::Delimiter:
+			if (!write_position(Tokens::Delimiter::GetScriptPosition(info)) || !write_range(Tokens::Delimiter::GetScriptRange(info)))
+				return false;
+			writer.Write<int32_t>(token.GetEnum<int>());
+			break;
+		default:
+			return false;
+		}
+	}
+
+	// and any commands it registered
+	writer.Write<uint32_t>(m_RegisteredCommands.size() - (m_Precompiled.Code ? m_Precompiled.NumCommands : 0));
+	for (size_t i = 0; i < m_RegisteredCommands.size(); ++i) {
+		if (from_header(i, m_Precompiled.Command, m_Precompiled.NumCommands)) continue;
+		auto& command = m_RegisteredCommands[i];
+		writer.Write(command.Name);
+		writer.Write<uint64_t>(command.Opcode);
+		writer.Write<uint32_t>(command.Args.size());
+		for (auto& arg : command.Args) {
+			writer.Write(arg.first ? arg.first->GetName() : std::string());
+			writer.Write(arg.second);
+		}
+	}
+
+	entry.Data = writer.Buffer();
+	return true;
+}
+bool Preprocessor::ReadCache(const BuildCache::Entry& entry) {
+	if (m_Files.size() != 1 || !StartFile(0))
+		return false;
+
+	// a file that used the precompiled header can only be put back with the same one
+	const PrecompiledHeader* header = nullptr;
+	CachedOutput cached, header_cached;
+	if (!entry.Precompiled.Path.empty()) {
+		header = m_Build.GetPrecompiledHeader();
+		if (!header || !header->Matches(entry.Precompiled) || !ReadCacheData(header->GetEntry().Data, false, header_cached))
+			return false;
+	}
+	if (!ReadCacheData(entry.Data, header != nullptr, cached))
+		return false;
+
+	RestoreCache(cached, m_Files[0], header, &header_cached);
+	m_State = finished;
+	return true;
+}
+bool Preprocessor::ReadCacheData(const std::string& data, bool precompiled, CachedOutput& cached) {
+	BuildCache::Reader reader(data.data(), data.size());
+	cached.Code = reader.ReadString();
+	for (auto n = reader.Read<uint32_t>(); n && reader.OK(); --n) {
+		auto line = reader.Read<uint32_t>();
+		auto offset = reader.Read<uint64_t>();
+		if (offset > cached.Code.size()) return false;
+		cached.Lines.emplace_back(line, static_cast<size_t>(offset));
+	}
+
+	// nothing can be in the precompiled header's code before it was included
+	cached.Precompiled = reader.Read<uint32_t>();
+	auto read_position = [&reader, &cached, precompiled](CachedPosition& pos, size_t index){
+		pos.Code = reader.Read<uint8_t>();
+		pos.Offset = reader.Read<uint64_t>();
+		return pos.Code == 0 || (pos.Code == 1 && precompiled && index >= cached.Precompiled);
+	};
+	auto read_range = [&read_position](CachedToken& tok, size_t index){
+		return read_position(tok.Begin, index) && read_position(tok.End, index);
+	};
+	auto num_tokens = reader.Read<uint32_t>();
+	if (!reader.OK() || (precompiled && cached.Precompiled > num_tokens)) return false;
+	cached.Tokens.reserve(num_tokens);
+	for (uint32_t i = 0; i < num_tokens; ++i) {
+		cached.Tokens.emplace_back();
+		auto& tok = cached.Tokens.back();
+		tok.Type = static_cast<Tokens::Type>(reader.Read<uint8_t>());
+		if (!read_position(tok.Position, i)) return false;
+		switch (tok.Type) {
+		case Tokens::Type::Character:
+			tok.Value = reader.Read<int32_t>();
+			break;
+		case Tokens::Type::Identifier:
+		case Tokens::Type::Label:
+		case Tokens::Type::Directive:
+			if (!read_range(tok, i)) return false;
+			break;
+		case Tokens::Type::Number:
+			if (!read_range(tok, i)) return false;
+			tok.IsFloat = reader.ReadBool();
+			if (tok.IsFloat) tok.Float = reader.Read<float>();
+			else tok.Integer = reader.Read<uint64_t>();
+			break;
+		case Tokens::Type::Operator:
+			if (!read_range(tok, i)) return false;
+			tok.Operator = m_Build.GetOperators().GetOperator(reader.Read<uint32_t>());
+			if (!tok.Operator) return false;
+			break;
+		case Tokens::Type::String:
+			if (!read_range(tok, i)) return false;
+			tok.String = reader.ReadString();
+			break;
+		case Tokens::Type::Delimiter:
+			// the token goes where the range begins, it's the delimiter itself that's wanted here
+			if (!read_position(tok.Position, i) || !read_range(tok, i)) return false;
+			tok.Value = reader.Read<int32_t>();
+			break;
+		default:
+			return false;
+		}
+		if (!reader.OK()) return false;
+	}
+
+	for (auto n = reader.Read<uint32_t>(); n && reader.OK(); --n) {
+		auto name = reader.ReadString();
+		auto opcode = static_cast<size_t>(reader.Read<uint64_t>());
+		std::vector<std::pair<VecRef<Types::Type>, bool>> args;
+		for (auto num_args = reader.Read<uint32_t>(); num_args && reader.OK(); --num_args) {
+			auto type = GetType(reader.ReadString());
+			auto isret = reader.ReadBool();
+			if (!type) return false;
+			args.emplace_back(type, isret);
+		}
+		cached.Commands.emplace_back(name, opcode, std::move(args));
+	}
+	return reader.OK() && reader.AtEnd();
+}
+void Preprocessor::RestoreCache(CachedOutput& cached, Scripts::FileRef file, const PrecompiledHeader* header, CachedOutput* header_cached) {
+	Scripts::LineList lines;
+	for (auto& line : cached.Lines)
+		lines.emplace_back(line.first, line.second, file);
+	auto& script_code = *file->GetCode();
+	script_code.Assign(std::move(cached.Code), std::move(lines));
+
+	Scripts::Code* codes[2] = { &script_code, nullptr };
+	auto get_position = [&codes](const CachedPosition& pos){
+		return Scripts::Position(*codes[pos.Code], static_cast<size_t>(pos.Offset));
+	};
+	for (size_t i = 0; i <= cached.Tokens.size(); ++i) {
+		// the precompiled header goes back in where it was included, with its own code
+		if (header && i == cached.Precompiled)
+			codes[1] = &IncludePrecompiledHeader(*header_cached, *header);
+		if (i == cached.Tokens.size()) break;
+
+		auto& tok = cached.Tokens[i];
+		auto pos = get_position(tok.Position);
+		Scripts::Range range(get_position(tok.Begin), get_position(tok.End));
+		switch (tok.Type) {
+		case Tokens::Type::Character:
+			CreateToken<Tokens::Character::Info<Character>>(Scripts::Range(pos, pos), Tokens::Type::Character, pos, Character(static_cast<Character::Type>(tok.Value)));
+			break;
+		case Tokens::Type::Identifier:
+			CreateToken<Tokens::Identifier::Info<>>(range, Tokens::Type::Identifier, range);
+			break;
+		case Tokens::Type::Label:
+			CreateToken<Tokens::Label::Info>(range, Tokens::Type::Label, range);
+			break;
+		case Tokens::Type::Directive:
+			CreateToken<Tokens::Directive::Info>(range, Tokens::Type::Directive, range);
+			break;
+		case Tokens::Type::Number:
+			if (tok.IsFloat)
+				CreateToken<TokenNumber<Numbers::FloatType, Numbers::Float>>(range, range, tok.Float);
+			else
+				CreateToken<TokenNumber<Numbers::IntegerType, Numbers::Integer>>(range, range, static_cast<unsigned long long>(tok.Integer));
+			break;
+		case Tokens::Type::Operator:
+			CreateToken<Tokens::Operator::Info<Operators::OperatorRef>>(range, Tokens::Type::Operator, range, tok.Operator);
+			break;
+		case Tokens::Type::String:
+			CreateToken<Tokens::String::Info>(range, Tokens::Type::String, range, tok.String);
+			break;
+		case Tokens::Type::Delimiter:
+			CreateToken<TokenDelimiter>(range, pos, range, Delimiter(static_cast<Delimiter::Type>(tok.Value)));
+			break;
+		}
+	}
+	for (auto& command : cached.Commands)
+		RegisterCommand(command.Name, command.Opcode, command.Args);
+}
+bool Preprocessor::WriteMacros(std::string& data) const {
+	// the bodies are kept as offsets into the code, which is stored along with the tokens
+	BuildCache::Writer writer;
+	writer.Write<uint32_t>(m_Macros.Size());
+	for (auto& pr : m_Macros) {
+		auto& macro = pr.second;
+		writer.Write(macro.GetName().GetString());
+		writer.Write(macro.GetCode().String());
+		writer.Write(macro.IsFunctionLike());
+		writer.Write<uint32_t>(macro.GetParams().size());
+		for (auto& param : macro.GetParams())
+			writer.Write(param);
+		writer.Write<uint32_t>(macro.GetBody().size());
+		for (auto& piece : macro.GetBody()) {
+			writer.Write(piece.IsParam());
+			if (piece.IsParam())
+				writer.Write<uint32_t>(piece.Param);
+			else {
+				// code from anywhere else can't be brought back
+				if (piece.Range.Begin().GetCode() != m_Code) return false;
+				writer.Write<uint64_t>(piece.Range.Begin().GetOffset());
+				writer.Write<uint64_t>(piece.Range.End().GetOffset());
+			}
+		}
+	}
+	data = writer.Buffer();
+	return true;
+}
+void Preprocessor::PrecompileHeader() {
+	auto config = m_Build.GetConfig();
+	if (!config || !config->Preprocessing().IsPrecompiled() || m_Build.GetPrecompiledHeader()) return;
+	auto& preprocessing = config->Preprocessing();
+	auto path = GetCanonicalPath(preprocessing.GetPrecompiledHeader());
+	Tracer::Span span(m_Build.GetTracer(), "precompile", path);
+
+	std::unique_ptr<PrecompiledHeader> header(new PrecompiledHeader(path, preprocessing.GetPrecompiledPath(), m_Build.GetDefinitionHash()));
+	if (!header->Open()) {
+		// go through it on its own, like an input file - if anything's wrong with it, it's just included as normal (so it's reported)
+		Scripts::Files files;
+		files.emplace_back(path);
+		if (!files.back().IsOpen()) return;
+
+		Tokens::Storage tokens;
+		DeferredEvents events;
+		Preprocessor worker(m_Task, m_Engine, m_Build, Scripts::FileRef(files, 0), tokens, events);
+		try {
+			worker.Preprocess();
+		}
+		catch (...) {
+			return;
+		}
+
+		BuildCache::Entry entry;
+		std::string macros;
+		if (!worker.IsCacheable() || !BuildCache::HashFile(path, entry.Hash) || !worker.WriteCache(entry) || !worker.WriteMacros(macros))
+			return;
+		header->Store(std::move(entry), std::move(macros), std::vector<std::string>(worker.m_Included.begin(), worker.m_Included.end()));
+		header->Save();
+	}
+
+	// the header itself might have a guard, which has to be known for it to be left out the next time
+	IncludeGuards::Guard guard;
+	MappedFile file(path);
+	if (file.IsOpen() && file.Data() && IncludeGuards::Detect(file.Data(), file.Size(), guard))
+		m_Build.GetIncludeGuards().Add(path, guard);
+	m_Build.SetPrecompiledHeader(std::move(header));
+}
+Scripts::Code& Preprocessor::IncludePrecompiledHeader(CachedOutput& cached, const PrecompiledHeader& header) {
+	// a second time, the cache couldn't tell which tokens came from which
+	if (m_Precompiled.Code) m_Cacheable = false;
+	m_Precompiled.Token = m_Tokens.Size();
+	m_Precompiled.Command = m_RegisteredCommands.size();
+
+	// the header gets code of its own, as the tokens and macro bodies point into it
+	auto file = m_Files[m_FileIndex]->IncludeCode(header.GetHeader());
+	RestoreCache(cached, file);
+	m_Precompiled.Code = file->GetCode();
+	m_Precompiled.NumTokens = m_Tokens.Size() - m_Precompiled.Token;
+	m_Precompiled.NumCommands = m_RegisteredCommands.size() - m_Precompiled.Command;
+	return *file->GetCode();
+}
+bool Preprocessor::ApplyPrecompiledHeader(const PrecompiledHeader& header) {
+	// the macros are read before anything is changed too
+	struct CachedPiece {
+		size_t Param = Macro::no_param;
+		uint64_t Begin = 0, End = 0;
+	};
+	struct CachedMacro {
+		std::string Name;
+		std::string Code;
+		bool FunctionLike = false;
+		Macro::Params Params;
+		std::vector<CachedPiece> Pieces;
+	};
+
+	BuildCache::Reader reader(header.GetMacros().data(), header.GetMacros().size());
+	std::vector<CachedMacro> macros;
+	for (auto n = reader.Read<uint32_t>(); n && reader.OK(); --n) {
+		macros.emplace_back();
+		auto& macro = macros.back();
+		macro.Name = reader.ReadString();
+		macro.Code = reader.ReadString();
+		macro.FunctionLike = reader.ReadBool();
+		for (auto i = reader.Read<uint32_t>(); i && reader.OK(); --i)
+			macro.Params.emplace_back(reader.ReadString());
+		for (auto i = reader.Read<uint32_t>(); i && reader.OK(); --i) {
+			macro.Pieces.emplace_back();
+			auto& piece = macro.Pieces.back();
+			if (reader.ReadBool())
+				piece.Param = reader.Read<uint32_t>();
+			else {
+				piece.Begin = reader.Read<uint64_t>();
+				piece.End = reader.Read<uint64_t>();
+			}
+		}
+	}
+	if (!reader.OK() || !reader.AtEnd()) return false;
+	CachedOutput cached;
+	if (!ReadCacheData(header.GetEntry().Data, false, cached)) return false;
+
+	// it's only included once it's all good
+	auto& code = IncludePrecompiledHeader(cached, header);
+	for (auto& cached : macros) {
+		Macro::Body body;
+		for (auto& piece : cached.Pieces) {
+			if (piece.Param != Macro::no_param)
+				body.emplace_back(piece.Param);
+			else
+				body.emplace_back(Scripts::Range(Scripts::Position(code, static_cast<size_t>(piece.Begin)), Scripts::Position(code, static_cast<size_t>(piece.End))));
+		}
+		auto id = m_Build.GetInterner().Intern(cached.Name);
+		bool defined = m_Macros.Get(id) != nullptr;
+		if (cached.FunctionLike) m_Macros.Define(id, cached.Name, CodeLine(cached.Code), body, cached.Params);
+		else m_Macros.Define(id, cached.Name, CodeLine(cached.Code), body);
+		if (!defined) RecordMacro(id, *m_Macros.Get(id));
+	}
+	for (auto& path : header.GetIncluded())
+		m_Included.emplace(path);
+	return true;
+}
 void Preprocessor::RunningState() {
 	auto old_state = m_State;
 
@@ -160,39 +737,41 @@ void Preprocessor::HandleToken() {
 
 	switch (m_Token) {
 	case TokenType::Eol: {
-		m_Build.CreateToken<Tokens::Character::Info<Character>>(range, Tokens::Type::Character, pos, Character(Character::Type::EOL));
+		CreateToken<Tokens::Character::Info<Character>>(range, Tokens::Type::Character, pos, Character(Character::Type::EOL));
 		break;
 	}
 	case TokenType::Identifier: {
-		m_Build.CreateToken<Tokens::Identifier::Info<>>(range, Tokens::Type::Identifier, m_Token.Range());
+		CreateToken<Tokens::Identifier::Info<>>(range, Tokens::Type::Identifier, m_Token.Range());
 		break;
 	}
 	case TokenType::Number: {
 		if (m_NumericScanner.Is<int>())
-			m_Build.CreateToken<TokenNumber<Numbers::IntegerType, Numbers::Integer>>(range, range, m_NumericScanner.Get<unsigned long long>());
+			CreateToken<TokenNumber<Numbers::IntegerType, Numbers::Integer>>(range, range, m_NumericScanner.Get<unsigned long long>());
 		else
-			m_Build.CreateToken<TokenNumber<Numbers::FloatType, Numbers::Float>>(range, range, m_NumericScanner.Get<float>());
+			CreateToken<TokenNumber<Numbers::FloatType, Numbers::Float>>(range, range, m_NumericScanner.Get<float>());
 		break;
 	}
 	case TokenType::Label: {
 		// TODO: do
-		m_Build.CreateToken<Tokens::Label::Info>(range, Tokens::Type::Label, range);
+		CreateToken<Tokens::Label::Info>(range, Tokens::Type::Label, range);
 		break;
 	}
 	case TokenType::Operator: {
-		m_Build.CreateToken<Tokens::Operator::Info<Operators::Type>>(range, Tokens::Type::Operator, range, m_OperatorScanner.GetOperator());
+		// these are only meant for directives, there's no putting them back from the cache
+		m_Cacheable = false;
+		CreateToken<Tokens::Operator::Info<Operators::Type>>(range, Tokens::Type::Operator, range, m_OperatorScanner.GetOperator());
 		break;
 	}
 	case TokenType::ParseOperator: {
-		m_Build.CreateToken<Tokens::Operator::Info<Operators::OperatorRef>>(range, Tokens::Type::Operator, range, m_ParserOperatorScanner.GetOperator());
+		CreateToken<Tokens::Operator::Info<Operators::OperatorRef>>(range, Tokens::Type::Operator, range, m_ParserOperatorScanner.GetOperator());
 		break;
 	}
 	case TokenType::Directive: {
-		m_Build.CreateToken<Tokens::Directive::Info>(range, Tokens::Type::Directive, range);
+		CreateToken<Tokens::Directive::Info>(range, Tokens::Type::Directive, range);
 		break;
 	}
 	case TokenType::String: {
-		m_Build.CreateToken<Tokens::String::Info>(range, Tokens::Type::String, range, m_String);
+		CreateToken<Tokens::String::Info>(range, Tokens::Type::String, range, m_String);
 		break;
 	}
 	default: break;
@@ -201,54 +780,113 @@ void Preprocessor::HandleToken() {
 	m_State = lexing;
 }
 void Preprocessor::HandleDirective() {
-	auto& task = m_Task;
 	switch (auto directive = m_Directive) {
 	case Directive::DEFINE:
 		if (Lex() == Lexing::Result::found_token && m_Token == TokenType::Identifier) {
 			Macro::Name name = m_Identifier;
+			auto id = m_IdentifierID;
+			// a macro that's already defined stays as it is
+			bool defined = m_Macros.Get(id) != nullptr;
+
+			// a parenthesis straight after the name makes it function-like
+			bool function_like = m_CodePos && *m_CodePos == '(';
+			Macro::Params params;
+			if (function_like) {
+				bool ok = false;
+				m_DisableMacroExpansion = true;
+				Lex();
+				while (Lex() == Lexing::Result::found_token) {
+					if (m_Token == TokenType::CloseParen && params.empty()) {
+						ok = true;
+						break;
+					}
+					if (m_Token != TokenType::Identifier) {
+						SendError(Error::dir_expected_identifier, m_Token.Range());
+						break;
+					}
+					params.emplace_back(m_Identifier);
+
+					if (Lex() != Lexing::Result::found_token) break;
+					if (m_Token == TokenType::CloseParen) {
+						ok = true;
+						break;
+					}
+					if (m_Token != TokenType::Separator) {
+						SendError(Error::expected_separator, m_Token.Range());
+						break;
+					}
+				}
+				m_DisableMacroExpansion = false;
+
+				if (!ok) {
+					// to recover, skip to the eol and leave it undefined
+					while (m_CodePos && m_CodePos->GetType() != Symbol::eol) ++m_CodePos;
+					break;
+				}
+			}
 
 			// skip to the good bit
 			while (m_CodePos && m_CodePos->IsIgnorable()) ++m_CodePos;
 
-			// gather up thy symbols
+			// find the end of thy symbols - the code stays where it is and gets lexed from here when the macro is used
 			if (m_CodePos && m_CodePos->GetType() != Symbol::eol) {
-				std::set<const Macro*> macrosThatAreNotMacros;
 				CodeLine code;
+				Macro::Body body;
 
 				auto start_pos = m_CodePos;
+				auto end_pos = m_CodePos;
+				auto piece_pos = m_CodePos;
 				while (m_CodePos && m_CodePos->GetType() != Symbol::eol) {
 					if (m_CodePos->IsIgnorable()) {
 						++m_CodePos;
 						continue;
 					}
-					auto result = m_Lexer.ScanFor(TokenType::Identifier, m_CodePos, m_Token);
-					switch (result) {
-					case Lexing::Result::still_scanning:
-						continue;
-					case Lexing::Result::found_nothing:
-						break;
-					case Lexing::Result::found_token:
-						m_Identifier = m_Token.Range().Format();
-
-						if (auto macro = m_Macros.Get(m_Identifier)) {
-							if (macrosThatAreNotMacros.find(macro) == macrosThatAreNotMacros.end()) {
-								macrosThatAreNotMacros.emplace(macro);
-								bool b = m_CodePos == start_pos;
-								m_CodePos = m_Build.GetScript().GetCode().Erase(m_Token.Begin(), m_Token.End());
-								m_CodePos = m_Build.GetScript().GetCode().Insert(m_CodePos, macro->GetCode());
-								if (b) start_pos = m_CodePos;
-								continue;
+
+					// only a comment ends it early (it's handled as normal after this)
+					if (*m_CodePos == '/') {
+						auto next = m_CodePos + 1;
+						if (next && (*next == '/' || *next == '*'))
+							break;
+						++m_CodePos;
+					}
+					// skip strings, so nothing in them is mistaken for a comment or parameter
+					else if (*m_CodePos == '"') {
+						if (!SkipStringLiteral(m_CodePos))
+							break;
+					}
+					// whole words, so parameter names aren't found in other names or numbers
+					else if (m_CodePos->GetType() == Symbol::identifier || m_CodePos->GetType() == Symbol::number) {
+						auto word_pos = m_CodePos;
+						while (m_CodePos && (m_CodePos->GetType() == Symbol::identifier || m_CodePos->GetType() == Symbol::number))
+							++m_CodePos;
+
+						if (!params.empty() && word_pos->GetType() == Symbol::identifier) {
+							auto it = std::find(params.begin(), params.end(), word_pos.Select(m_CodePos));
+							if (it != params.end()) {
+								// cut the body up around the parameter, the argument gets lexed in its place
+								if (piece_pos < word_pos)
+									body.emplace_back(Scripts::Range(piece_pos, word_pos));
+								body.emplace_back(static_cast<size_t>(it - params.begin()));
+								piece_pos = m_CodePos;
 							}
 						}
-						m_CodePos = m_Token.End();
-						continue;
 					}
-					++m_CodePos;
+					else ++m_CodePos;
+					end_pos = m_CodePos;
 				}
+				if (piece_pos < end_pos)
+					body.emplace_back(Scripts::Range(piece_pos, end_pos));
+				m_CodePos = end_pos;
 
-				m_Macros.Define(name, m_Build.GetScript().GetCode().Copy(start_pos, m_CodePos, code));
+				m_Code->Copy(start_pos, end_pos, code);
+				if (function_like) m_Macros.Define(id, name, code, body, params);
+				else m_Macros.Define(id, name, code, body);
 			}
-			else m_Macros.Define(name);
+			else if (function_like) m_Macros.Define(id, name, Macro::Code(), Macro::Body(), params);
+			else m_Macros.Define(id, name);
+
+			// lex the body once now (after copying it, as lexing strings changes the code)
+			if (!defined) RecordMacro(id, *m_Macros.Get(id));
 		}
 		break;
 
@@ -256,8 +894,10 @@ void Preprocessor::HandleDirective() {
 		// make sure we're not handed dirty macro code
 		m_DisableMacroExpansionOnce = true;
 
-		if (Lex() == Lexing::Result::found_token && m_Token == TokenType::Identifier)
-			m_Macros.Undefine(m_Identifier);
+		if (Lex() == Lexing::Result::found_token && m_Token == TokenType::Identifier) {
+			m_Macros.Undefine(m_IdentifierID);
+			m_MacroTokens.erase(m_IdentifierID);
+		}
 		else
 			throw;
 		break;
@@ -268,12 +908,12 @@ void Preprocessor::HandleDirective() {
 
 	case Directive::IFDEF:
 		if (Lex() == Lexing::Result::found_token && m_Token == TokenType::Identifier)
-			PushSourceControl(GetSourceControl() ? (m_Macros.Get(m_Identifier) != nullptr) : false);
+			PushSourceControl(GetSourceControl() ? (m_Macros.Get(m_IdentifierID) != nullptr) : false);
 		break;
 
 	case Directive::IFNDEF:
 		if (Lex() == Lexing::Result::found_token && m_Token == TokenType::Identifier)
-			PushSourceControl(GetSourceControl() ? (m_Macros.Get(m_Identifier) == nullptr) : false);
+			PushSourceControl(GetSourceControl() ? (m_Macros.Get(m_IdentifierID) == nullptr) : false);
 		break;
 
 	case Directive::ELIF:
@@ -294,55 +934,108 @@ void Preprocessor::HandleDirective() {
 	case Directive::INCLUDE:
 		if (Lex() == Lexing::Result::found_token && m_Token == TokenType::String)
 		{
-			if (m_Build.GetScript().Include(m_CodePos, m_String))
+			Tracer::Span span;
+			if (auto tracer = m_Build.GetTracer())
+				span.Begin(tracer, "include", m_String, m_Files[m_FileIndex]->GetPath());
+
+			// if it'd do nothing this time, don't even open it
+			auto& guards = m_Build.GetIncludeGuards();
+			auto path = GetCanonicalPath(m_String);
+			IncludeGuards::Guard guard;
+			bool known = guards.Find(path, guard);
+			if (known && (guard.Once ? m_Included.find(path) != m_Included.end() : IsMacroDefined(guard.Macro))) {
+				++m_Stats[Stat::includes_skipped];
+				m_CodePos.NextLine();
+				m_State = lexing;
+				return;
+			}
+
+			// a precompiled header is brought back just as it was left, without going through it
+			auto header = m_Build.GetPrecompiledHeader();
+			if (header && header->GetHeader() == path && ApplyPrecompiledHeader(*header)) {
+				++m_Stats[Stat::includes_skipped];
+				m_Included.emplace(path);
+				m_CodePos.NextLine();
+				m_State = lexing;
+				return;
+			}
+
+			// the included code goes on the end
+			auto size = m_Code->GetSize();
+			if (m_Build.GetScript().Include(m_Files[m_FileIndex], m_CodePos, m_String))
 			{
+				++m_Stats[Stat::includes_opened];
+				m_Included.emplace(path);
+				if (!known && IncludeGuards::Detect(m_Code->GetData() + size, m_Code->GetSize() - size, guard))
+					guards.Add(path, guard);
 				m_State = lexing;
 				return;
 			}
-			else m_Task.Event<error_include_failed>(m_String);
+			else {
+				m_Cacheable = false;
+				SendEvent<error_include_failed>(m_String);
+			}
+		}
+		else {
+			m_Cacheable = false;
+			SendEvent<error_dir_expected_file_name>(m_Directive);
 		}
-		else m_Task.Event<error_dir_expected_file_name>(m_Directive);
 		break;
 
-	case Directive::REGISTER_COMMAND:
+	case Directive::PRAGMA:
+		// '#pragma once' is found when the file is included - anything else is ignored
+		while (m_CodePos && m_CodePos->GetType() != Symbol::eol) ++m_CodePos;
+		break;
+
+	case Directive::REGISTER_COMMAND: {
+		std::string name;
+		size_t opcode = 0;
+		std::vector<std::pair<VecRef<Types::Type>, bool>> args;
 		if (Lex(
 			[this](const LexerToken& tok){ return tok == TokenType::Number && m_NumericScanner.Is<int>(); },
-			[&task, &directive](const LexerToken& tok){ task.Event<error_dir_expected_command_id>(directive); }
+			[this, &directive](const LexerToken& tok){
+				m_Cacheable = false;
+				SendEvent<error_dir_expected_command_id>(directive);
+			}
 			)) {
-			auto opcode = m_NumericScanner.Get<size_t>();
+			opcode = m_NumericScanner.Get<size_t>();
 
 			if (Lex(TokenType::Identifier, [this](const LexerToken& tok){
 				SendError(Error::dir_expected_identifier, m_Directive);
 			})) {
-				auto command = m_Commands.AddCommand(m_Identifier, opcode, nullptr);
+				name = m_Identifier;
 						
 				if (Lex() == Lexing::Result::found_token) {
 					bool openParen = m_Token == TokenType::OpenParen;
-					if (openParen) {
-						if (!Lex(TokenType::Identifier, [this](const LexerToken& tok){ SendError(Error::dir_expected_identifier, m_Directive); }))
-							break;
-					}
+					bool ok = true;
+					if (openParen)
+						ok = Lex(TokenType::Identifier, [this](const LexerToken& tok){ SendError(Error::dir_expected_identifier, m_Directive); });
 					else if (m_Token != TokenType::Identifier)
 						SendError(Error::dir_expected_identifier, m_Directive);
 
-					do {
-						auto str = m_Token.Range().Format();
-						bool isret = false;
-						if (str[0] == '=') {
-							isret = true;
-							str = str.substr(1);
-						}
-						if (auto type = GetType(str)) {
-							command->AddArg(type, isret);
-						}
-						if (!Lexpect(TokenType::Separator)) break;
-					} while (Lex() == Lexing::Result::found_token);
+					if (ok) {
+						do {
+							auto str = m_Token.Range().Format();
+							bool isret = false;
+							if (str[0] == '=') {
+								isret = true;
+								str = str.substr(1);
+							}
+							if (auto type = GetType(str)) {
+								args.emplace_back(type, isret);
+							}
+							if (!Lexpect(TokenType::Separator)) break;
+						} while (Lex() == Lexing::Result::found_token);
 
-					if (openParen) Lexpect(TokenType::CloseParen);
+						if (openParen) Lexpect(TokenType::CloseParen);
+					}
 				}
 			}
 		}
+		if (!name.empty())
+			RegisterCommand(name, opcode, std::move(args));
 		break;
+	}
 
 	default:
 		//BREAK();		// invalid directive - should've alredy reported - now the preprocessor can continue
@@ -353,19 +1046,18 @@ void Preprocessor::HandleDirective() {
 	return;
 }
 void Preprocessor::HandleComment() {
-	// handle it with care by deleting the shit out of it
-	m_CodePos = m_Build.GetScript().GetCode().Erase(m_Token.Begin(), m_Token.End());
-
-	// that felt good... add a single space in its place as an extra sign of indignity...
-	m_CodePos.Insert(' ');
+	// step right over it - the code is left as it is, so nothing after it has to move
+	m_CodePos = m_Token.End();
 
 	m_State = lexing;
 }
 void Preprocessor::LexerPhase() {
 	if (m_State == lexing) {
+		LeaveMacros();
 		if (m_CodePos) {
 			while (m_CodePos && m_CodePos->IsIgnorable())
 				++m_CodePos;
+			LeaveMacros();
 			if (m_CodePos->IsEOL()) {
 				if (!m_WasLastTokenEOL) {
 					AddToken<Tokens::Character::Info<Character>>(m_CodePos, Tokens::Type::Character, m_CodePos, Character::EOL);
@@ -435,12 +1127,19 @@ void Preprocessor::LexerPhase() {
 
 		while (m_CodePos && m_CodePos->IsIgnorable())
 			++m_CodePos;
+		LeaveMacros();
 	}
 
-	// ya, we're done here...
+	// ya, we're done here... (with this file, at least)
 	if (!m_CodePos) {
+		// workers have their files traced for them
+		auto tracer = m_Build.GetTracer();
+		if (tracer && !m_DeferredEvents)
+			tracer->AddSpan("file", m_Files[m_FileIndex]->GetPath(), m_FileStart, Tracer::Clock::now());
+		if (StartFile(m_FileIndex + 1))
+			return;
 		m_State = finished;
-		m_Task.Event<event_finish>();
+		if (!m_DeferredEvents) SendEvent<event_finish>();
 		return;
 	}
 
@@ -703,7 +1402,7 @@ int Preprocessor::ProcessExpression(bool paren) {
 		case TokenType::Identifier:
 			if (defined_operator)
 			{
-				val = m_Macros.Get(m_Identifier) != nullptr;
+				val = m_Macros.Get(m_IdentifierID) != nullptr;
 				got_val = true;
 				defined_operator = false;
 				m_DisableMacroExpansion = false;
@@ -853,15 +1552,19 @@ bool Preprocessor::Lexpect(SCRambl::TokenType type) {
 Lexing::Result Preprocessor::Lex() {
 	Lexing::Result result;
 
-	// it is a crime to consider any of these a macro, under punishment of death by infinite recursion (a slow, painful way to go)
-	std::unordered_set<std::string> identifiersThatAreNotMacros;
+	// one span for all the expanding done to get a token
+	Tracer::Span expansion;
 
 	while (true) {
 		while (m_CodePos && m_CodePos->IsIgnorable())
 			++m_CodePos;
+		LeaveMacros();
+
+		// macros used in code are played back from their tokens, rather than being lexed again
+		bool played = !m_MacroFrames.empty() && m_MacroFrames.back().IsPlayback();
 
 		// If we're preprocessing a directive, directly return further directions
-		if (m_State == found_directive) {
+		if (m_State == found_directive && !played) {
 			m_OperatorScanner.Enable();			// enable preprocessor operators
 			m_ParserOperatorScanner.Disable();	// disable parser (proper) operators
 
@@ -891,7 +1594,8 @@ Lexing::Result Preprocessor::Lex() {
 				
 		// try to lex something - catch and handle any thrown scanner errors
 		try {
-			result = m_CodePos ? m_Lexer.Scan(m_CodePos, m_Token) : Lexing::Result::found_nothing;
+			if (played) result = PlayMacroToken();
+			else result = m_CodePos ? m_Lexer.Scan(m_CodePos, m_Token) : Lexing::Result::found_nothing;
 		}
 		catch (const StringLiteralScanner::Error & err) {
 			switch (err) {
@@ -939,8 +1643,9 @@ Lexing::Result Preprocessor::Lex() {
 			if (!GetSourceControl() && (m_Token != TokenType::Directive))
 					continue;
 
-			// tell brother
-			m_Task.Event<event_found_token>(m_Token.Range());
+			// tell brother (if he's listening)
+			if (m_Build.IsEventEnabled(EventConfig::FOUND_TOKEN))
+				SendEvent<event_found_token>(m_Token.Range());
 
 			switch (m_Token)
 			{
@@ -949,6 +1654,9 @@ Lexing::Result Preprocessor::Lex() {
 				\*/
 			case TokenType::Comment:
 			case TokenType::BlockComment:
+				// leave the code of macros be - their comments aren't in their bodies anyway
+				if (!m_MacroFrames.empty())
+					continue;
 				// handle comments immediately - get rid o' that ol' waste o' space
 				HandleComment();
 				continue;
@@ -958,7 +1666,7 @@ Lexing::Result Preprocessor::Lex() {
 				\*/
 			case TokenType::Directive:
 				// get the directive identifier and look up its ID
-				m_Directive = GetDirective(m_Build.GetScript().GetCode().Select(m_Token.Inside(), m_Token.End()));
+				m_Directive = GetDirective(m_Token.Inside().Select(m_Token.End()));
 
 				// if the source is being skipped, wait until we have a related directive
 				if (!GetSourceControl() && !DoesDirectiveIgnoreSourceControl(m_Directive))
@@ -978,21 +1686,19 @@ Lexing::Result Preprocessor::Lex() {
 				break;
 
 			case TokenType::String:
-				// save the string
-				m_String = m_Build.GetScript().GetCode().Select(m_Token.Inside(), m_Token.End());
-				m_String = m_String.substr(0, m_String.find_last_not_of('\0') + 1);
+				// save the string (the token ends after the closing quote)
+				m_String = m_Token.Inside().Select(m_Token.End() - 1);
 				break;
 
 			case TokenType::Identifier:
 				// save the identifier
-				//m_Identifier = m_Script.GetCode().Select(m_Token.Begin(), m_Token.End());
-				m_Identifier = m_Token.Range().Format();
+				if (!played) SaveIdentifier();
 
 				if (false)
 				{
 			case TokenType::Label:
 				// save the label name
-				m_Identifier = m_Token.Range().Format();
+				if (!played) SaveIdentifier();
 				if (m_CodePos->GetType() == Symbol::punctuator)
 					++m_CodePos;
 				}
@@ -1000,22 +1706,24 @@ Lexing::Result Preprocessor::Lex() {
 				// in certain cases we may want the macros actual identifier
 				if (!m_DisableMacroExpansion && !m_DisableMacroExpansionOnce)
 				{
-					// ensure this identifier isn't not a macro... double negative, yes, but there's a big difference
-					if (identifiersThatAreNotMacros.find(m_Identifier) == identifiersThatAreNotMacros.end())
+					// it is a crime to consider a macro being expanded a macro, under punishment of death by infinite recursion (a slow, painful way to go)
+					auto guard = GetMacroGuard();
+					if (!IsExpandingMacro(m_IdentifierID, guard))
 					{
-						// check for macro
-						if (auto * macro = m_Macros.Get(m_Identifier))
+						// check for macro - a function-like macro without any arguments is just an identifier
+						auto * macro = m_Macros.Get(m_IdentifierID);
+						if (macro)
 						{
-							// NO! you CANNOT be a macro twice, don't be so stupid
-							identifiersThatAreNotMacros.emplace(m_Identifier);
-
-							// remove the identifier from code
-							m_CodePos = m_Build.GetScript().GetCode().Erase(m_Token.Begin(), m_Token.End());
-
-							// insert the macro code
-							m_CodePos = m_Build.GetScript().GetCode().Insert(m_CodePos, macro->GetCode().Symbols());
-							// continue parsing until we have a REAL token
-							continue;
+							auto tracer = m_Build.GetTracer();
+							if (tracer && !expansion.IsActive())
+								expansion.Begin(tracer, "macro", m_Identifier, m_Files[m_FileIndex]->GetPath());
+
+							// lex the macro code where it is (or play it back), rather than copying it over the identifier
+							if (ExpandMacro(m_IdentifierID, *macro, guard)) {
+								++m_Stats[Stat::macros_expanded];
+								// continue parsing until we have a REAL token
+								continue;
+							}
 						}
 					}
 				}
@@ -1028,8 +1736,321 @@ Lexing::Result Preprocessor::Lex() {
 		break;
 	}
 
+	// whatever nothing was found at gets stepped over first
+	if (result != Lexing::Result::found_nothing)
+		LeaveMacros();
 	return result;
 }
+bool Preprocessor::IsMacroDefined(const std::string& name) const {
+	auto id = m_Build.GetInterner().Find(name);
+	return id != Interner::none && m_Macros.Get(id) != nullptr;
+}
+bool Preprocessor::ExpandMacro(SymbolID id, const Macro& macro, SymbolID guard) {
+	// in code, macros are played back from the tokens lexed when they were defined
+	auto body = m_State != found_directive ? m_MacroTokens.find(id) : m_MacroTokens.end();
+	bool playback = body != m_MacroTokens.end();
+
+	MacroArgs args;
+	MacroTokenArgs token_args;
+	if (macro.IsFunctionLike()) {
+		if (!m_MacroFrames.empty() && m_MacroFrames.back().IsPlayback()) {
+			// there's no code to lex the arguments from in tokens being played back
+			if (!playback || !LexMacroArgs(macro, token_args))
+				return false;
+		}
+		else {
+			if (!LexMacroArgs(macro, args))
+				return false;
+			// the arguments are lexed as part of where the macro was used
+			for (size_t i = 0; playback && i < args.size(); ++i) {
+				token_args.emplace_back();
+				playback = RecordMacroTokens(args[i], guard, token_args.back());
+			}
+		}
+	}
+
+	if (playback) EnterMacro(body->second, token_args, guard);
+	else EnterMacro(id, macro, args, guard);
+	return true;
+}
+bool Preprocessor::LexMacroArgs(const Macro& macro, MacroArgs& args) {
+	// the arguments can't go past the end of the macro they're in
+	auto end = m_MacroFrames.empty() ? Scripts::Position() : m_MacroFrames.back().End;
+	auto in_range = [&end](const Scripts::Position& pos){
+		return pos && pos->GetType() != Symbol::eol && (!end || pos < end);
+	};
+
+	auto pos = m_CodePos;
+	while (in_range(pos) && pos->IsIgnorable()) ++pos;
+	if (!in_range(pos) || *pos != '(')
+		return false;
+
+	// split the arguments up by the commas between the outermost parentheses
+	auto arg_begin = pos + 1, arg_end = arg_begin;
+	int depth = 0;
+	for (++pos; in_range(pos);) {
+		if (pos->IsIgnorable()) {
+			if (arg_begin == pos) arg_begin = arg_end = pos + 1;
+			++pos;
+			continue;
+		}
+		if (*pos == '"') {
+			if (!SkipStringLiteral(pos)) break;
+			arg_end = pos;
+			continue;
+		}
+		if (*pos == '(') ++depth;
+		else if (*pos == ')' && depth) --depth;
+		else if (!depth && (*pos == ',' || *pos == ')')) {
+			args.emplace_back(arg_begin, arg_end);
+			if (*pos == ')') {
+				m_CodePos = pos + 1;
+
+				// 'F()' has no arguments, rather than one empty one
+				if (macro.GetParams().empty() && args.size() == 1 && args[0].Begin() == args[0].End())
+					args.clear();
+				if (args.size() != macro.GetParams().size())
+					SendError(Error::macro_wrong_number_of_args, *macro.GetName());
+				return true;
+			}
+			arg_begin = arg_end = ++pos;
+			continue;
+		}
+		arg_end = ++pos;
+	}
+
+	SendError(Error::macro_unterminated_args, *macro.GetName());
+	args.clear();
+	return false;
+}
+bool Preprocessor::LexMacroArgs(const Macro& macro, MacroTokenArgs& args) {
+	// the arguments can't go past the end of the macro they're in
+	auto& frame = m_MacroFrames.back();
+	auto& tokens = frame.Tokens;
+	auto next = frame.Next;
+	if (next >= tokens.size() || !tokens[next].Is('('))
+		return false;
+
+	// split the arguments up by the commas between the outermost parentheses
+	args.emplace_back();
+	int depth = 0;
+	for (++next; next < tokens.size(); ++next) {
+		auto& token = tokens[next];
+		if (token.Is('(')) ++depth;
+		else if (token.Is(')') && depth) --depth;
+		else if (!depth && token.Is(',')) {
+			args.emplace_back();
+			continue;
+		}
+		else if (!depth && token.Is(')')) {
+			frame.Next = next + 1;
+
+			// 'F()' has no arguments, rather than one empty one
+			if (macro.GetParams().empty() && args.size() == 1 && args[0].empty())
+				args.clear();
+			if (args.size() != macro.GetParams().size())
+				SendError(Error::macro_wrong_number_of_args, *macro.GetName());
+			return true;
+		}
+		args.back().emplace_back(token);
+	}
+
+	SendError(Error::macro_unterminated_args, *macro.GetName());
+	args.clear();
+	return false;
+}
+void Preprocessor::EnterMacro(SymbolID id, const Macro& macro, const MacroArgs& args, SymbolID guard) {
+	MacroFrame frame;
+	for (auto& piece : macro.GetBody()) {
+		if (!piece.IsParam())
+			frame.Pieces.emplace_back(piece.Range, id);
+		else if (piece.Param < args.size() && args[piece.Param].Begin() != args[piece.Param].End())
+			frame.Pieces.emplace_back(args[piece.Param], guard);
+	}
+	if (frame.Pieces.empty()) return;
+
+	frame.Piece = 0;
+	frame.End = frame.Pieces[0].Range.End();
+	frame.Caller = guard;
+	frame.Return = m_CodePos;
+	m_CodePos = frame.Pieces[0].Range.Begin();
+	m_MacroFrames.emplace_back(std::move(frame));
+}
+void Preprocessor::EnterMacro(const MacroTokens& body, const MacroTokenArgs& args, SymbolID guard) {
+	// copy the body over a run at a time, splicing the arguments in place of the parameters
+	m_MacroFrames.emplace_back();
+	auto& frame = m_MacroFrames.back();
+	frame.Tokens.reserve(body.size());
+	auto run = body.begin();
+	for (auto it = body.begin(); it != body.end(); ++it) {
+		if (!it->IsParam()) continue;
+		frame.Tokens.insert(frame.Tokens.end(), run, it);
+		if (it->Param < args.size())
+			frame.Tokens.insert(frame.Tokens.end(), args[it->Param].begin(), args[it->Param].end());
+		run = it + 1;
+	}
+	frame.Tokens.insert(frame.Tokens.end(), run, body.end());
+	if (frame.Tokens.empty()) {
+		m_MacroFrames.pop_back();
+		return;
+	}
+
+	frame.Next = 0;
+	frame.Caller = guard;
+	frame.Return = m_CodePos;
+	m_CodePos = frame.Tokens[0].Begin;
+}
+void Preprocessor::LeaveMacros() {
+	while (!m_MacroFrames.empty()) {
+		auto& frame = m_MacroFrames.back();
+		if (frame.IsPlayback()) {
+			// the lexer's kept at the next token to be played back
+			if (frame.Next < frame.Tokens.size()) {
+				m_CodePos = frame.Tokens[frame.Next].Begin;
+				return;
+			}
+		}
+		else {
+			while (m_CodePos < frame.End && m_CodePos->IsIgnorable())
+				++m_CodePos;
+			if (m_CodePos < frame.End)
+				return;
+
+			// on to the next bit of the body, or back to where the macro was used
+			if (++frame.Piece < frame.Pieces.size()) {
+				auto& range = frame.Pieces[frame.Piece].Range;
+				m_CodePos = range.Begin();
+				frame.End = range.End();
+				continue;
+			}
+		}
+
+		m_CodePos = frame.Return;
+		m_MacroFrames.pop_back();
+	}
+}
+void Preprocessor::RecordMacro(SymbolID id, const Macro& macro) {
+	MacroTokens tokens;
+	for (auto& piece : macro.GetBody()) {
+		if (piece.IsParam()) {
+			tokens.emplace_back();
+			tokens.back().Param = piece.Param;
+		}
+		else if (!RecordMacroTokens(piece.Range, id, tokens))
+			return;
+	}
+	m_MacroTokens[id] = std::move(tokens);
+}
+bool Preprocessor::RecordMacroTokens(const Scripts::Range& range, SymbolID guard, MacroTokens& tokens) {
+	// lexed as code, which is the only place they're played back
+	m_OperatorScanner.Disable();
+	m_ParserOperatorScanner.Enable();
+
+	auto pos = range.Begin();
+	while (true) {
+		while (pos < range.End() && pos->IsIgnorable())
+			++pos;
+		if (!(pos < range.End()))
+			return true;
+
+		MacroToken token;
+		token.Begin = pos;
+		token.Guard = guard;
+
+		Lexing::Result result;
+		try {
+			result = m_Lexer.Scan(pos, token.Token);
+		}
+		catch (const StringLiteralScanner::Error&) {
+			return false;
+		}
+		catch (const BlockCommentScanner::Error&) {
+			return false;
+		}
+
+		if (result == Lexing::Result::still_scanning)
+			continue;
+		if (result == Lexing::Result::found_nothing) {
+			tokens.emplace_back(token);
+			++pos;
+			continue;
+		}
+		if (range.End() < token.Token.End())
+			return false;
+		pos = token.Token.End();
+
+		switch (token.Token) {
+		case TokenType::Comment:
+		case TokenType::BlockComment:
+		case TokenType::Directive:
+			// these need the code, so it'll have to be lexed again
+			return false;
+		case TokenType::Identifier:
+		case TokenType::Label: {
+			size_t size;
+			auto str = token.Token.Begin().View(token.Token.End(), size);
+			token.ID = m_Build.GetInterner().Intern(str, size);
+			// same as Lex, the label punctuator goes with it
+			if (token.Token == TokenType::Label && pos < range.End() && pos->GetType() == Symbol::punctuator)
+				++pos;
+			break;
+		}
+		case TokenType::Number:
+			token.IsInt = m_NumericScanner.Is<int>();
+			token.IntValue = m_NumericScanner.Get<long long>();
+			token.FloatValue = m_NumericScanner.Get<float>();
+			break;
+		case TokenType::ParseOperator:
+			token.Operator = m_ParserOperatorScanner.GetCell();
+			break;
+		default: break;
+		}
+		token.Found = true;
+		tokens.emplace_back(token);
+	}
+}
+Lexing::Result Preprocessor::PlayMacroToken() {
+	auto& frame = m_MacroFrames.back();
+	auto& token = frame.Tokens[frame.Next++];
+	m_CodePos = token.Begin;
+	if (!token.Found)
+		return Lexing::Result::found_nothing;
+
+	// put everything back the way the scanners left it
+	m_Token = token.Token;
+	switch (m_Token) {
+	case TokenType::Identifier:
+	case TokenType::Label: {
+		size_t size;
+		auto str = m_Token.Begin().View(m_Token.End(), size);
+		m_IdentifierID = token.ID;
+		m_Identifier.assign(str, size);
+		break;
+	}
+	case TokenType::Number:
+		if (token.IsInt) m_NumericScanner.Set(token.IntValue);
+		else m_NumericScanner.Set(token.FloatValue);
+		break;
+	case TokenType::ParseOperator:
+		m_ParserOperatorScanner.SetCell(token.Operator);
+		break;
+	default: break;
+	}
+	return Lexing::Result::found_token;
+}
+SymbolID Preprocessor::GetMacroGuard() const {
+	if (m_MacroFrames.empty()) return Interner::none;
+	auto& frame = m_MacroFrames.back();
+	return frame.IsPlayback() ? frame.Tokens[frame.Next - 1].Guard : frame.Pieces[frame.Piece].ID;
+}
+bool Preprocessor::IsExpandingMacro(SymbolID id, SymbolID guard) const {
+	if (guard == id) return true;
+	// ...or anything the macros being expanded were used in
+	for (auto& frame : m_MacroFrames) {
+		if (frame.Caller == id) return true;
+	}
+	return false;
+}
 bool Preprocessor::LexNumber() {
 	if (Lex() == Lexing::Result::found_token) {
 		if (m_Token == TokenType::Number)
@@ -1062,7 +2083,7 @@ bool Preprocessor::GetSourceControl() const {
 
 bool Preprocessor::OpenDelimiter(Scripts::Position pos, Delimiter type) {
 	auto range = Scripts::Range(pos, pos);
-	auto token = m_Build.CreateToken<TokenDelimiter>(range, pos, range, type);
+	auto token = CreateToken<TokenDelimiter>(range, pos, range, type);
 	m_Delimiters.emplace(token);
 	return true;
 }
@@ -1074,9 +2095,9 @@ bool Preprocessor::CloseDelimiter(Scripts::Position pos, Delimiter type) {
 		auto begin = Tokens::Delimiter::GetScriptRange(*tok).Begin();
 		auto range = Scripts::Range(begin, pos);
 		// replace the token with an updated Scripts::Range
-		token->SetToken(new TokenDelimiter(begin, range, type));
+		token->SetToken(m_Tokens.Create<TokenDelimiter>(begin, range, type));
 		// mark the closing position
-		m_Build.CreateToken<TokenDelimiter>(range, pos, range, type);
+		CreateToken<TokenDelimiter>(range, pos, range, type);
 		m_Delimiters.pop();
 		return true;
 	}
@@ -1090,8 +2111,9 @@ VecRef<Types::Type> Preprocessor::GetType(const std::string& name) {
 template<typename... TArgs>
 void Preprocessor::SendError(Error type, TArgs&&... args) {
 	// send
+	m_Cacheable = false;
 	std::vector<std::string> params;
-	m_Task.Event<error_event>(Basic::Error(m_Engine, type), params);
+	SendEvent<error_event>(Basic::Error(m_Engine, type), params);
 }
 template<typename First, typename... Args>
 void Preprocessor::SendError(Error type, First&& first, Args&&... args) {
@@ -1100,7 +2122,8 @@ void Preprocessor::SendError(Error type, First&& first, Args&&... args) {
 	// format the error parameters to the vector
 	m_Engine.Format(params, first, args...);
 	// send
-	m_Task.Event<error_event>(Basic::Error(m_Engine, type), params);
+	m_Cacheable = false;
+	SendEvent<error_event>(Basic::Error(m_Engine, type), params);
 }
 
 // Scanners - BORING! ;)
@@ -1219,7 +2242,7 @@ bool StringLiteralScanner::Scan(Lexing::State& state, Scripts::Position& pos) {
 		return false;
 
 	case Lexing::State::inside:
-		while (pos) {
+		while (pos.Seek<CharScan::Match<'\\', '"', '\n'>>()) {
 			// escaped? just skip it :)
 			if (pos == '\\') {
 				if (++pos) ++pos;
@@ -1229,12 +2252,10 @@ bool StringLiteralScanner::Scan(Lexing::State& state, Scripts::Position& pos) {
 				throw(Error::unterminated);
 			}
 			else if (pos == '"') {
-				*pos = '\0';
 				++pos;
 				state = Lexing::State::after;
 				return true;
 			}
-			else ++pos;
 		}
 		return false;
 
@@ -1258,7 +2279,7 @@ bool CommentScanner::Scan(Lexing::State& state, Scripts::Position& pos) {
 
 		// run to the end of the line, quick!
 	case Lexing::State::inside:
-		while (pos && pos->GetType() != Symbol::eol) ++pos;
+		pos.Seek<CharScan::Match<'\n', '\0'>>();
 		state = Lexing::State::after;
 		return true;
 
@@ -1285,24 +2306,28 @@ bool BlockCommentScanner::Scan(Lexing::State& state, Scripts::Position& pos) {
 
 		// check for nested comments and closing comment
 	case Lexing::State::inside:
-		do {
-			if (pos->GetType() == Symbol::punctuator) {
-				if (pos == '/') {
-					if (last_char == '*') {
-						++pos;
-						if (!--depth) {
-							state = Lexing::State::after;
-							return true;
-						}
-					}
-				}
-				else if (last_char == '/' && pos == '*') {
-					++depth;
+		while (pos) {
+			char c = *pos;
+			if (c == '/' && last_char == '*') {
+				if (!--depth) {
+					++pos;
+					state = Lexing::State::after;
+					return true;
 				}
+				c = '\0';
+			}
+			else if (c == '*' && last_char == '/') {
+				++depth;
+				c = '\0';
 			}
 
-			last_char = *pos;
-		} while (++pos);
+			last_char = c;
+			if (++pos && pos != '/' && pos != '*') {
+				// nothing else matters until the next one of these
+				pos.Seek<CharScan::Match<'/', '*'>>();
+				last_char = '\0';
+			}
+		}
 
 		if (depth)
 			throw(Error::end_of_file_reached);
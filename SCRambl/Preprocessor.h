@@ -6,10 +6,16 @@
 /**********************************************************/
 #pragma once
 #include <stack>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <thread>
 #include "Tasks.h"
 #include "Engine.h"
 #include "Scripts.h"
 #include "Lexer.h"
+#include "PreprocessorLexer.h"
 #include "Macros.h"
 #include "Identifiers.h"
 #include "Operators.h"
@@ -17,6 +23,8 @@
 #include "Labels.h"
 #include "TokenInfo.h"
 #include "Tokens.h"
+#include "BuildCache.h"
+#include "PrecompiledHeader.h"
 
 namespace SCRambl
 {
@@ -125,6 +133,13 @@ namespace SCRambl
 				expected_opening_paren,					// 1020
 				expected_separator,						// 1021
 				expr_unmatched_closing_delimiter,		// 1022
+				macro_unterminated_args,				// 1023
+				macro_wrong_number_of_args,				// 1024
+
+				// warnings
+				warning_begin							= 3000,
+				cache_not_isolated						= 3000,
+				warning_end,
 
 				// fatal errors
 				fatal_begin								= 4000,
@@ -154,6 +169,7 @@ namespace SCRambl
 				ELSE,
 				ENDIF,
 				UNDEF,
+				PRAGMA,
 
 				REGISTER_VAR,
 				REGISTER_COMMAND,
@@ -190,6 +206,8 @@ namespace SCRambl
 					break;
 				case ENDIF: name = "endif";
 					break;
+				case PRAGMA: name = "pragma";
+					break;
 				}
 				return !name.empty() ? ("#" + name) : "(invalid)";
 			}
@@ -297,12 +315,115 @@ namespace SCRambl
 			friend class Information;
 
 			using LexerToken = Lexing::Token<TokenType>;
+#ifdef SCRAMBL_SCANNER_LEXER
+			// the original scanner race - slower, but handy for diffing against the DFA
 			using LexerMachine = Lexing::Lexer<TokenType>;
+#else
+			using LexerMachine = Lexer;
+#endif
 			using DirectiveMap = std::unordered_map<std::string, Directive>;
 			using OperatorTable = Operators::Table<Operators::Type>;
 			using OperatorScanner = Operators::Scanner<Operators::Type>;
 			template<typename... T>
 			using TToken = TokenInfo<Tokens::Type, T...>;
+			using DeferredEvents = std::vector<std::function<void()>>;
+			using ParserOperatorScanner = Operators::Scanner<Operators::OperatorRef>;
+			// the code given for each parameter of a function-like macro
+			using MacroArgs = std::vector<Scripts::Range>;
+
+			// One input file preprocessed with a state of its own, so it can be done on another thread
+			struct FileJob {
+				Tokens::Storage TokenStorage;
+				DeferredEvents Events;
+				std::unique_ptr<Preprocessor> Worker;
+				std::exception_ptr Exception;
+				const BuildCache::Entry* Cached = nullptr;	// what the file came to last time, if it's not changed
+				BuildCache::Entry CacheEntry;				// what it came to this time (only if Store is set)
+				bool Store = false;
+			};
+			// A command registered by a file, kept to go in the cache
+			struct RegisteredCommand {
+				std::string Name;
+				size_t Opcode;
+				std::vector<std::pair<VecRef<Types::Type>, bool>> Args;
+
+				RegisteredCommand(std::string name, size_t opcode, std::vector<std::pair<VecRef<Types::Type>, bool>> args) : Name(name), Opcode(opcode), Args(args)
+				{ }
+			};
+			// A position kept in a cache entry - in the file's own code, or the precompiled header's
+			struct CachedPosition {
+				uint8_t Code = 0;
+				uint64_t Offset = 0;
+			};
+			struct CachedToken {
+				Tokens::Type Type;
+				CachedPosition Position, Begin, End;
+				int32_t Value = 0;
+				bool IsFloat = false;
+				uint64_t Integer = 0;
+				float Float = 0.0f;
+				Operators::OperatorRef Operator;
+				std::string String;
+			};
+			// Everything in a cache entry, read and checked before anything's changed (see ReadCacheData)
+			struct CachedOutput {
+				std::string Code;
+				std::vector<std::pair<unsigned long, size_t>> Lines;	// number and offset of each
+				size_t Precompiled = 0;				// token the precompiled header's tokens go before
+				std::vector<CachedToken> Tokens;
+				std::vector<RegisteredCommand> Commands;
+			};
+			// Where the precompiled header was brought back, so the cache can leave out what came from it
+			struct AppliedHeader {
+				const Scripts::Code* Code = nullptr;
+				size_t Token = 0, NumTokens = 0;
+				size_t Command = 0, NumCommands = 0;
+			};
+			// A token of a macro body (or argument) lexed once, so using the macro in code plays it back rather than lexing it again
+			// Those that aren't found are characters the lexer steps over, like parentheses, which LexerPhase sees as normal
+			struct MacroToken {
+				Scripts::Position Begin;				// where the lexer started on it
+				LexerToken Token;
+				bool Found = false;
+				size_t Param = Macro::no_param;			// slot in the body for an argument
+				SymbolID Guard = Interner::none;		// the macro it came from (see IsExpandingMacro)
+				SymbolID ID = Interner::none;			// identifiers and labels
+				bool IsInt = true;						// numbers
+				long long IntValue = 0;
+				float FloatValue = 0.0f;
+				const ParserOperatorScanner::Cell* Operator = nullptr;
+
+				inline bool IsParam() const { return Param != Macro::no_param; }
+				// Is it just this character?
+				inline bool Is(char c) const { return *Begin == c && (!Found || Token.End() == Begin + 1); }
+			};
+			using MacroTokens = std::vector<MacroToken>;
+			// ...the arguments of a function-like macro, as tokens
+			using MacroTokenArgs = std::vector<MacroTokens>;
+
+			// A macro being expanded - its code is lexed where it was defined, then it's back to where it was used
+			// In code, it's played back from its tokens instead, with those of the arguments spliced in
+			struct MacroFrame {
+				// A range of the body or of an argument, and the macro it's guarded against expanding
+				// Arguments belong to whatever the macro was used in, so 'F(F(1))' still expands both
+				struct Section {
+					Scripts::Range Range;
+					SymbolID ID;
+
+					Section(Scripts::Range range, SymbolID id) : Range(range), ID(id)
+					{ }
+				};
+
+				std::vector<Section> Pieces;		// the body, with the arguments in place of the parameters
+				size_t Piece;					// range being lexed
+				Scripts::Position End;			// end of that range
+				MacroTokens Tokens;				// ...or the tokens being played back
+				size_t Next;					// token to play back next
+				SymbolID Caller;				// the macro it was used in
+				Scripts::Position Return;		// just after the macro was used
+
+				inline bool IsPlayback() const { return !Tokens.empty(); }
+			};
 
 		public:
 			enum State {
@@ -328,6 +449,39 @@ namespace SCRambl
 			const Information& GetInfo() const { return m_Information; }
 
 		private:
+			Preprocessor(Task&, Engine&, Build&, Tokens::Storage&);
+			// Preprocess one file into its own token storage, holding events back for the build thread
+			Preprocessor(Task&, Engine&, Build&, Scripts::FileRef, Tokens::Storage&, DeferredEvents&);
+
+			// Preprocess everything in one go
+			void Preprocess();
+			// Preprocess each input file on a pool of threads, then merge the tokens in file order
+			void RunParallel(size_t num_threads, bool cached);
+			// Start on a file - returns false if there's no such file
+			bool StartFile(size_t index);
+			// Can the file be cached? (not if it had errors or produced anything that can't be stored)
+			inline bool IsCacheable() const { return m_Cacheable; }
+			// Store the preprocessed code, tokens and registered commands of the file in a cache entry
+			bool WriteCache(BuildCache::Entry&) const;
+			// Bring the file back to how it was after preprocessing from a cache entry - nothing is touched if it can't be
+			bool ReadCache(const BuildCache::Entry&);
+			// Read and check the data of a cache entry - positions can only be in the precompiled header's code if it was used
+			bool ReadCacheData(const std::string& data, bool precompiled, CachedOutput&);
+			// Put the code of a cache entry in a file and add its tokens and commands
+			// If the file used the precompiled header, what it had is put back where it was included
+			void RestoreCache(CachedOutput&, Scripts::FileRef, const PrecompiledHeader* = nullptr, CachedOutput* header = nullptr);
+			// Store the macros defined, with their bodies as offsets into the code of the file
+			bool WriteMacros(std::string&) const;
+			// Make or load the precompiled header of the config, if there is one and the build hasn't got it yet
+			void PrecompileHeader();
+			// Put back the tokens and commands of the precompiled header as an include of the current file, returning its code
+			Scripts::Code& IncludePrecompiledHeader(CachedOutput&, const PrecompiledHeader&);
+			// Bring back everything the precompiled header left behind, as if it'd been included - returns false if it can't be
+			bool ApplyPrecompiledHeader(const PrecompiledHeader&);
+
+			// Send an event (or save it for later if we're not on the build thread)
+			template<typename TEvent, typename... TArgs>
+			void SendEvent(TArgs&&... args);
 			// Send an error event
 			template<typename... TArgs>
 			void SendError(Error, TArgs&&... args);
@@ -363,6 +517,30 @@ namespace SCRambl
 			VecRef<Types::Type> GetType(const std::string&);
 			// Lex main code
 			Lexing::Result Lex();
+			// Returns true if the macro is defined
+			bool IsMacroDefined(const std::string&) const;
+			// Expand a macro used in whatever the guard is (see GetMacroGuard) - returns false if it's function-like without arguments
+			bool ExpandMacro(SymbolID, const Macro&, SymbolID guard);
+			// Get the arguments in parentheses after a function-like macro - returns false if there aren't any
+			bool LexMacroArgs(const Macro&, MacroArgs&);
+			// ...from the tokens of the macro being played back
+			bool LexMacroArgs(const Macro&, MacroTokenArgs&);
+			// Start lexing the code of a macro, coming back to where we are once it's all been lexed
+			void EnterMacro(SymbolID, const Macro&, const MacroArgs&, SymbolID guard);
+			// Start playing back the tokens of a macro, coming back to where we are once they've all been played
+			void EnterMacro(const MacroTokens&, const MacroTokenArgs&, SymbolID guard);
+			// Go back from any macros that have been lexed to the end
+			void LeaveMacros();
+			// Lex the body of a macro that's just been defined, so it can be played back - it's lexed from its code each time if it can't be
+			void RecordMacro(SymbolID, const Macro&);
+			// Lex a range of code as it would be lexed in code, adding the tokens - returns false if it can't be played back like that
+			bool RecordMacroTokens(const Scripts::Range&, SymbolID guard, MacroTokens&);
+			// Play back the next token of the macro being expanded, just as if it had been lexed
+			Lexing::Result PlayMacroToken();
+			// Get the macro whatever was last lexed came from (or Interner::none)
+			SymbolID GetMacroGuard() const;
+			// Returns true if the macro is being expanded, or lexed from one that is (so it's not a macro again till it's done)
+			bool IsExpandingMacro(SymbolID, SymbolID guard) const;
 			// Lex with error callback
 			template<typename TFunc>
 			inline bool Lex(TokenType type, TFunc func) {
@@ -381,6 +559,14 @@ namespace SCRambl
 				func(m_Token);
 				return false;
 			}
+			// Save the identifier of the last token, interning it - straight from the code, no strings made in between
+			inline void SaveIdentifier() {
+				auto range = m_Token.Range();
+				size_t size;
+				auto str = range.Begin().View(range.End(), size);
+				m_IdentifierID = m_Build.GetInterner().Intern(str, size);
+				m_Identifier.assign(str, size);
+			}
 			// Lex main code, returns true if token of TokenType is found, automatically sends errors
 			bool Lexpect(TokenType);
 			// Lex around for a number
@@ -391,14 +577,22 @@ namespace SCRambl
 				m_WasLastTokenEOL = false;
 				return m_Tokens.Add<T>(pos, std::forward<TArgs&&>(args)...);
 			}
+			// Add a preprocessing token and tell everyone about it
+			template<typename T, typename... TArgs>
+			inline VecRef<Tokens::Token> CreateToken(Scripts::Range range, TArgs&&... args) {
+				auto token = m_Tokens.Add<T>(range.Begin(), std::forward<TArgs>(args)...);
+				if (m_Build.IsEventEnabled(EventConfig::ADDED_TOKEN))
+					SendEvent<event_added_token>(range);
+				return token;
+			}
+			// Register a command (only after the files before it have been, when preprocessing in parallel)
+			void RegisterCommand(std::string name, size_t opcode, std::vector<std::pair<VecRef<Types::Type>, bool>> args);
 			// Handle expressions
 			int ProcessExpression(bool paren = false);
 			// Perform unary operation on passed value - returns false if no change could be made as the operator was unsupported
 			static bool ExpressUnary(Operators::Type op, int& val);
 			// Get current line number
 			inline long GetLineNumber() const { return m_CodePos.GetLine(); }
-			// Get code of the current line
-			inline CodeLine& GetLineCode() { return m_CodePos.GetLine().GetCode(); }
 			// Returns directive_invalid if it didnt exist
 			inline Directive GetDirective(const std::string& str) const {
 				DirectiveMap::const_iterator it;
@@ -427,11 +621,21 @@ namespace SCRambl
 			Task& m_Task;
 			Commands& m_Commands;
 			Tokens::Storage& m_Tokens;
+			DeferredEvents* m_DeferredEvents = nullptr;
+			bool m_Cacheable = true;
+			AppliedHeader m_Precompiled;
+			std::vector<RegisteredCommand> m_RegisteredCommands;
+			TaskStats m_Stats;							// counted since the last step (or by a worker, for the whole file)
 			//
+			std::vector<Scripts::FileRef> m_Files;		// files to preprocess, in order
+			size_t m_FileIndex = 0;
+			Scripts::Code* m_Code = nullptr;			// code of the current file
 			Scripts::Position m_CodePos;
+			Tracer::Clock::time_point m_FileStart;		// when the current file was started on (only when tracing)
 			//
 			std::string m_String;					// last scanned string
 			std::string	m_Identifier;				// last scanned identifier
+			SymbolID m_IdentifierID = Interner::none;	// ...and its interned number
 			Directive m_Directive;
 			//
 			LexerToken m_Token;
@@ -440,6 +644,9 @@ namespace SCRambl
 			DirectiveMap m_Directives;
 			std::stack<VecRef<Tokens::Token>> m_Delimiters;
 			//
+			std::vector<MacroFrame> m_MacroFrames;	// macros being expanded, innermost last
+			std::unordered_map<SymbolID, MacroTokens> m_MacroTokens;	// the bodies of macros, lexed when they were defined
+			std::unordered_set<std::string> m_Included;	// canonical paths of the files included (for #pragma once)
 			bool m_DisableMacroExpansion = false;
 			bool m_DisableMacroExpansionOnce = false;
 			bool m_WasLastTokenEOL = false;
@@ -457,7 +664,7 @@ namespace SCRambl
 			OperatorTable m_Operators;
 			OperatorScanner m_OperatorScanner;
 			Operators::Table<Operators::OperatorRef>& m_ParserOperators;
-			Operators::Scanner<Operators::OperatorRef> m_ParserOperatorScanner;
+			ParserOperatorScanner m_ParserOperatorScanner;
 		};
 
 		// The Preprocessor and Task become one
@@ -0,0 +1,254 @@
+#include "stdafx.h"
+#include "PreprocessorLexer.h"
+#include "Preprocessor.h"
+
+using namespace SCRambl;
+using namespace SCRambl::Preprocessing;
+
+namespace {
+	// The DFA tables - built from the symbol table, so they always agree with the scanners
+	struct Tables {
+		unsigned char classes[0x100];
+		unsigned char next[Lexer::max_state][Lexer::max_class];
+		unsigned rules[Lexer::max_state];		// the rules each state could still end up as
+
+		Tables() {
+			// classify every character
+			for (int c = 0; c < 0x100; ++c) {
+				classes[c] = Lexer::class_other;
+				if (c >= 0x80) continue;
+				switch (c) {
+				case '\0': classes[c] = Lexer::class_nul; break;
+				case '"': classes[c] = Lexer::class_quote; break;
+				case '\\': classes[c] = Lexer::class_backslash; break;
+				case '/': classes[c] = Lexer::class_slash; break;
+				case '*': classes[c] = Lexer::class_star; break;
+				case '#': classes[c] = Lexer::class_hash; break;
+				case ':': classes[c] = Lexer::class_colon; break;
+				default: {
+					Symbol sym(static_cast<char>(c));
+					switch (sym.GetType()) {
+					case Symbol::eol: classes[c] = Lexer::class_eol; break;
+					case Symbol::whitespace: classes[c] = Lexer::class_space; break;
+					case Symbol::identifier: classes[c] = Lexer::class_identifier; break;
+					case Symbol::number: classes[c] = Lexer::class_number; break;
+					default:
+						if (sym.HasGrapheme()) classes[c] = Lexer::class_punctuator;
+						break;
+					}
+					break;
+				}
+				}
+			}
+
+			// everything stops unless told otherwise
+			for (auto& row : next) for (auto& to : row) to = Lexer::state_stop;
+
+			// what the first character could be
+			Set(Lexer::state_start, Lexer::class_identifier, Lexer::state_identifier);
+			Set(Lexer::state_start, Lexer::class_number, Lexer::state_number);
+			Set(Lexer::state_start, Lexer::class_quote, Lexer::state_string);
+			Set(Lexer::state_start, Lexer::class_slash, Lexer::state_slash);
+			Set(Lexer::state_start, Lexer::class_hash, Lexer::state_hash);
+
+			// identifiers & labels
+			Set(Lexer::state_identifier, Lexer::class_identifier, Lexer::state_identifier);
+			Set(Lexer::state_identifier, Lexer::class_number, Lexer::state_identifier);
+
+			// #directives
+			Set(Lexer::state_hash, Lexer::class_identifier, Lexer::state_directive);
+			Set(Lexer::state_directive, Lexer::class_identifier, Lexer::state_directive);
+			Set(Lexer::state_directive, Lexer::class_number, Lexer::state_directive);
+
+			// "strings"
+			SetAll(Lexer::state_string, Lexer::state_string);
+			Set(Lexer::state_string, Lexer::class_backslash, Lexer::state_string_escape);
+			Set(Lexer::state_string, Lexer::class_quote, Lexer::state_string_end);
+			Set(Lexer::state_string, Lexer::class_eol, Lexer::state_string_eol);
+			SetAll(Lexer::state_string_escape, Lexer::state_string);
+
+			// comments
+			Set(Lexer::state_slash, Lexer::class_slash, Lexer::state_comment);
+			Set(Lexer::state_slash, Lexer::class_star, Lexer::state_block_open);
+			SetAll(Lexer::state_comment, Lexer::state_comment);
+			Set(Lexer::state_comment, Lexer::class_eol, Lexer::state_stop);
+			Set(Lexer::state_comment, Lexer::class_nul, Lexer::state_stop);
+
+			// /* block /* comments */ nest */
+			for (auto state : { Lexer::state_block_comment, Lexer::state_block_open, Lexer::state_block_close }) {
+				SetAll(state, Lexer::state_block_comment);
+				Set(state, Lexer::class_slash, Lexer::state_block_slash);
+				Set(state, Lexer::class_star, Lexer::state_block_star);
+			}
+			SetAll(Lexer::state_block_slash, Lexer::state_block_comment);
+			Set(Lexer::state_block_slash, Lexer::class_slash, Lexer::state_block_slash);
+			Set(Lexer::state_block_slash, Lexer::class_star, Lexer::state_block_open);
+			SetAll(Lexer::state_block_star, Lexer::state_block_comment);
+			Set(Lexer::state_block_star, Lexer::class_star, Lexer::state_block_star);
+			Set(Lexer::state_block_star, Lexer::class_slash, Lexer::state_block_close);
+
+			// which rules need to be on for the DFA to go into each state
+			for (auto& r : rules) r = 0;
+			rules[Lexer::state_identifier] = Bit(Lexer::rule_label) | Bit(Lexer::rule_identifier);
+			rules[Lexer::state_hash] = rules[Lexer::state_directive] = Bit(Lexer::rule_directive);
+			rules[Lexer::state_number] = Bit(Lexer::rule_number);
+			rules[Lexer::state_string] = rules[Lexer::state_string_escape] = rules[Lexer::state_string_eol] = rules[Lexer::state_string_end] = Bit(Lexer::rule_string);
+			rules[Lexer::state_slash] = Bit(Lexer::rule_comment) | Bit(Lexer::rule_block_comment);
+			rules[Lexer::state_comment] = Bit(Lexer::rule_comment);
+			for (auto state : { Lexer::state_block_comment, Lexer::state_block_slash, Lexer::state_block_star, Lexer::state_block_open, Lexer::state_block_close, Lexer::state_block_end })
+				rules[state] = Bit(Lexer::rule_block_comment);
+		}
+
+		static inline unsigned Bit(Lexer::Rule rule) { return 1 << rule; }
+		inline void Set(Lexer::StateID from, Lexer::Class cls, Lexer::StateID to) { next[from][cls] = to; }
+		inline void SetAll(Lexer::StateID from, Lexer::StateID to) {
+			for (auto& state : next[from]) state = to;
+		}
+	};
+	const Tables s_Tables;
+}
+
+Lexer::Lexer() {
+	for (auto& rule : m_Rules) {
+		rule.type = TokenType::None;
+		rule.scanner = nullptr;
+	}
+}
+
+void Lexer::AddRule(Rule rule, TokenType type, Lexing::Scanner& scanner) {
+	m_Rules[rule].type = type;
+	m_Rules[rule].scanner = &scanner;
+}
+void Lexer::AddTokenScanner(TokenType type, BlockCommentScanner& scanner) { AddRule(rule_block_comment, type, scanner); }
+void Lexer::AddTokenScanner(TokenType type, CommentScanner& scanner) { AddRule(rule_comment, type, scanner); }
+void Lexer::AddTokenScanner(TokenType type, DirectiveScanner& scanner) { AddRule(rule_directive, type, scanner); }
+void Lexer::AddTokenScanner(TokenType type, StringLiteralScanner& scanner) { AddRule(rule_string, type, scanner); }
+void Lexer::AddTokenScanner(TokenType type, LabelScanner& scanner) { AddRule(rule_label, type, scanner); }
+void Lexer::AddTokenScanner(TokenType type, IdentifierScanner& scanner) { AddRule(rule_identifier, type, scanner); }
+void Lexer::AddTokenScanner(TokenType type, Numbers::Scanner& scanner) {
+	AddRule(rule_number, type, scanner);
+	m_NumberScanner = &scanner;
+}
+
+unsigned Lexer::GetRules() const {
+	unsigned rules = 0;
+	for (int i = 0; i < max_rule; ++i) {
+		if (m_Rules[i].scanner && m_Rules[i].scanner->IsEnabled())
+			rules |= 1 << i;
+	}
+	return rules;
+}
+
+Lexing::Result Lexer::Scan(const Scripts::Position& pos, Token& token) {
+	return Scan(pos, token, GetRules(), nullptr);
+}
+Lexing::Result Lexer::ScanFor(TokenType type, const Scripts::Position& pos, Token& token) {
+	auto rules = GetRules();
+	for (int i = 0; i < max_rule; ++i) {
+		if (m_Rules[i].type != type)
+			rules &= ~(1 << i);
+	}
+	return Scan(pos, token, rules, &type);
+}
+
+Lexing::Result Lexer::Scan(const Scripts::Position& start, Token& token, unsigned rules, const TokenType* type) {
+	auto pos = start;
+	auto state = state_start;
+	int depth = 0;
+
+	// walk the DFA until there's nowhere to go
+	while (pos) {
+		auto next = static_cast<StateID>(s_Tables.next[state][s_Tables.classes[static_cast<unsigned char>(*pos)]]);
+		if (next == state_stop || !(s_Tables.rules[next] & rules)) break;
+		state = next;
+
+		switch (state) {
+		case state_number: {
+			// the number scanner can take it from here
+			Scripts::Position inside;
+			if (!m_NumberScanner->Match(pos, inside)) return ScanOperator(start, token, type);
+			token(m_Rules[rule_number].type, start, inside, pos);
+			return Lexing::Result::found_token;
+		}
+		case state_string_eol:
+			throw(StringLiteralScanner::Error::unterminated);
+		case state_block_open:
+			++depth;
+			break;
+		case state_block_close:
+			if (!--depth) state = state_block_end;
+			break;
+		}
+
+		++pos;
+
+		// nothing else matters until the next one of these
+		switch (state) {
+		case state_comment:
+			pos.Seek<CharScan::Match<'\n', '\0'>>();
+			break;
+		case state_string:
+			pos.Seek<CharScan::Match<'\\', '"', '\n'>>();
+			break;
+		case state_block_comment:
+		case state_block_open:
+		case state_block_close:
+			pos.Seek<CharScan::Match<'/', '*'>>();
+			break;
+		}
+	}
+
+	// see what we ended up with
+	switch (state) {
+	case state_identifier:
+		// a colon makes it a label - as long as there's nothing important immediately after it
+		if ((rules & (1 << rule_label)) && pos && s_Tables.classes[static_cast<unsigned char>(*pos)] == class_colon) {
+			auto nextpos = pos + 1;
+			if (!nextpos || nextpos->IsIgnorable() || nextpos->IsEOL()) {
+				token(m_Rules[rule_label].type, start, start + 1, pos);
+				return Lexing::Result::found_token;
+			}
+		}
+		if ((rules & (1 << rule_identifier)) && (!pos || pos->IsSeparating())) {
+			token(m_Rules[rule_identifier].type, start, start + 1, pos);
+			return Lexing::Result::found_token;
+		}
+		break;
+	case state_directive:
+		if (!pos || pos->IsSeparating()) {
+			token(m_Rules[rule_directive].type, start, start + 1, pos);
+			return Lexing::Result::found_token;
+		}
+		break;
+	case state_string_end:
+		token(m_Rules[rule_string].type, start, start + 1, pos);
+		return Lexing::Result::found_token;
+	case state_comment:
+		token(m_Rules[rule_comment].type, start, start + 2, pos);
+		return Lexing::Result::found_token;
+	case state_block_end:
+		token(m_Rules[rule_block_comment].type, start, start + 2, pos);
+		return Lexing::Result::found_token;
+	case state_block_comment:
+	case state_block_slash:
+	case state_block_star:
+	case state_block_open:
+	case state_block_close:
+		// still in the comment at the end of the file
+		throw(BlockCommentScanner::Error::end_of_file_reached);
+	}
+
+	// no luck - maybe it's an operator
+	return ScanOperator(start, token, type);
+}
+Lexing::Result Lexer::ScanOperator(const Scripts::Position& start, Token& token, const TokenType* type) {
+	for (auto& op : m_Operators) {
+		if (!op.scanner->IsEnabled() || (type && op.type != *type)) continue;
+		auto pos = start;
+		if (op.match(op.scanner, pos)) {
+			token(op.type, start, start, pos);
+			return Lexing::Result::found_token;
+		}
+	}
+	return Lexing::Result::found_nothing;
+}
@@ -0,0 +1,119 @@
+/**********************************************************/
+// SCRambl Advanced SCR Compiler/Assembler
+// This program is distributed freely under the MIT license
+// (See the LICENSE file provided
+//	 or copy at http://opensource.org/licenses/MIT)
+/**********************************************************/
+#pragma once
+#include <vector>
+#include "Lexer.h"
+#include "Numbers.h"
+#include "Operators.h"
+#include "TokenInfo.h"
+
+namespace SCRambl
+{
+	namespace Preprocessing
+	{
+		class BlockCommentScanner;
+		class CommentScanner;
+		class DirectiveScanner;
+		class StringLiteralScanner;
+		class LabelScanner;
+		class IdentifierScanner;
+
+		/*\
+		 - Preprocessing::Lexer - single pass, table-driven replacement for the scanner race of Lexing::Lexer
+		 - The comment, directive, string, label and identifier rules are compiled into one DFA, so each
+		 - character is looked at once, without virtual calls or list nodes
+		 - Numbers and operators are read by their scanners (non-virtually) in one go once the DFA gets to them
+		 - Scanners are added the same way as for Lexing::Lexer, they only say which rules are on and what they're called
+		\*/
+		class Lexer {
+		public:
+			using Token = Lexing::Token<TokenType>;
+
+			// rules in order of precedence - the same order the scanners used to be added in
+			enum Rule {
+				rule_block_comment, rule_comment, rule_directive, rule_string,
+				rule_label, rule_identifier, rule_number,
+				max_rule
+			};
+
+			// character classes
+			enum Class : unsigned char {
+				class_other, class_eol, class_nul, class_space, class_identifier, class_number,
+				class_quote, class_backslash, class_slash, class_star, class_hash, class_colon,
+				class_punctuator,
+				max_class
+			};
+
+			// DFA states
+			enum StateID : unsigned char {
+				state_stop,
+				state_start,
+				state_identifier,
+				state_hash, state_directive,
+				state_number,
+				state_string, state_string_escape, state_string_eol, state_string_end,
+				state_slash, state_comment,
+				state_block_comment, state_block_slash, state_block_star, state_block_open, state_block_close, state_block_end,
+				max_state
+			};
+
+			Lexer();
+
+			// hook up the scanners the rules stand in for
+			void AddTokenScanner(TokenType type, BlockCommentScanner& scanner);
+			void AddTokenScanner(TokenType type, CommentScanner& scanner);
+			void AddTokenScanner(TokenType type, DirectiveScanner& scanner);
+			void AddTokenScanner(TokenType type, StringLiteralScanner& scanner);
+			void AddTokenScanner(TokenType type, LabelScanner& scanner);
+			void AddTokenScanner(TokenType type, IdentifierScanner& scanner);
+			void AddTokenScanner(TokenType type, Numbers::Scanner& scanner);
+			// operators are tried in the order they're added, after everything else
+			template<typename T>
+			void AddTokenScanner(TokenType type, Operators::Scanner<T>& scanner) {
+				m_Operators.push_back({ type, &scanner, &MatchOperator<T> });
+			}
+
+			/*\
+			 - Same as Lexing::Lexer::Scan, except it never needs to be called more than once per token
+			 - Returns found_token or found_nothing (or throws the same errors as the scanners would)
+			\*/
+			Lexing::Result Scan(const Scripts::Position& pos, Token& token);
+			/*\
+			 - Same as Lexing::Lexer::ScanFor - only the rule for that token type gets a go
+			\*/
+			Lexing::Result ScanFor(TokenType type, const Scripts::Position& pos, Token& token);
+
+		private:
+			struct RuleInfo {
+				TokenType type;
+				Lexing::Scanner* scanner;
+			};
+			struct OperatorInfo {
+				TokenType type;
+				Lexing::Scanner* scanner;
+				bool(*match)(Lexing::Scanner*, Scripts::Position&);
+			};
+
+			template<typename T>
+			static bool MatchOperator(Lexing::Scanner* scanner, Scripts::Position& pos) {
+				return static_cast<Operators::Scanner<T>*>(scanner)->Match(pos);
+			}
+
+			void AddRule(Rule, TokenType, Lexing::Scanner&);
+			// bit per enabled rule
+			unsigned GetRules() const;
+			// run the DFA for the rules in the mask, fall back to operators (only of 'type', if non-null) if it comes up with nothing
+			Lexing::Result Scan(const Scripts::Position& pos, Token& token, unsigned rules, const TokenType* type);
+			Lexing::Result ScanOperator(const Scripts::Position& pos, Token& token, const TokenType* type);
+
+		private:
+			RuleInfo m_Rules[max_rule];
+			std::vector<OperatorInfo> m_Operators;
+			Numbers::Scanner* m_NumberScanner = nullptr;
+		};
+	}
+}
@@ -11,14 +11,15 @@
 #include <stack>
 #include <unordered_map>
 #include "Types.h"
+#include "Interner.h"
 
 namespace SCRambl
 {
-	template<typename TObj, typename TKey = std::string>
+	template<typename TObj, typename TKey = SymbolID>
 	class ScriptObject;
 	
 	/*\ Scope - Scope of variables, labels, you name it \*/
-	template<typename TObj, typename TKey = std::string>
+	template<typename TObj, typename TKey = SymbolID>
 	class Scope
 	{
 	public:
@@ -71,7 +72,7 @@ namespace SCRambl
 	};
 
 	/*\ ScriptObjects - Manager for script objects \*/
-	template<typename TObj, typename TKey = std::string>
+	template<typename TObj, typename TKey = SymbolID>
 	class ScriptObjects
 	{
 	public:
@@ -85,6 +86,7 @@ namespace SCRambl
 		ScriptObjects() = default;
 		virtual ~ScriptObjects() = default;
 
+		// Add an object under the key - the type, index in scope and args go to its constructor
 		template<typename... TArgs>
 		ScriptObject* Add(const Types::Type* type, Key key, TArgs&&... args) {
 			bool global = true;
@@ -98,7 +100,7 @@ namespace SCRambl
 			auto& scope = global ? Global() : Local();
 			// create object
 			auto idx = m_Objects.size();
-			m_Objects.emplace_back(scope, type, scope.Size(), key, args...);
+			m_Objects.emplace_back(scope, type, scope.Size(), args...);
 			ASSERT(m_Objects.size() > idx);
 			// add to scope
 			scope.Add(key, m_Objects.back().Ptr());
@@ -111,6 +113,12 @@ namespace SCRambl
 			return it == m_Map.end() ? nullptr : &*it->second;
 		}
 
+		// Every object added, even those of scopes that have ended
+		inline typename List::const_iterator Begin() const { return m_Objects.begin(); }
+		inline typename List::const_iterator End() const { return m_Objects.end(); }
+		inline typename List::const_iterator begin() const { return Begin(); }
+		inline typename List::const_iterator end() const { return End(); }
+
 		size_t LocalDepth() const { return m_Scopes.size(); }
 		bool HasLocal() const { return !m_Scopes.empty(); }
 		
@@ -12,6 +12,7 @@
 #include <unordered_map>
 #include <memory>
 #include "utils.h"
+#include "utils/mmap.h"
 #include "Symbols.h"
 
 namespace SCRambl
@@ -20,52 +21,56 @@ namespace SCRambl
 		class Code;
 		class File;
 		class Line;
-		class Column;
 		class Range;
 		class Position;
 
-		using CodeList = std::list<Line>;
+		using LineList = std::vector<Line>;
 		using Files = std::vector<File>;
 		using FileRef = VecRef<File>;
 
-		/*\ Scripts::Line - this is one \*/
+		/*\ Scripts::Line - this is one (well, where it starts in the buffer) \*/
 		class Line {
+			friend class Code;
+			friend class Position;
+
 		public:
 			Line() = default;
-			Line(unsigned long, CodeLine, const FileRef);
+			Line(unsigned long, size_t, const FileRef);
 
 			unsigned long GetLine() const;
-			CodeLine& GetCode();
-			const CodeLine& GetCode() const;
+			size_t GetOffset() const;
 			const FileRef GetFile() const;
 
-			operator const CodeLine&() const;
-			operator CodeLine&();
 			operator unsigned long() const;
 
 		private:
-			const FileRef m_File;
+			FileRef m_File;
 			unsigned long m_Line = 0;
-			CodeLine m_Code;
+			size_t m_Offset = 0;
 		};
 
-		/*\ Scripts::Code - where symbolic data lives in peaceful bliss \*/
+		/*\
+		 - Scripts::Code - where symbolic data lives in peaceful bliss
+		 - All lines share one contiguous buffer, the line index records where each of them starts
+		 - Symbols are classified from the buffer characters when they're asked for
+		 - A mapped file can be used as the buffer, it's only copied once something needs changing
+		\*/
 		class Code {
 			friend class Position;
 
 		public:
 			Code();
-			Code(const CodeList&);
+			Code(const Code&);
 
 			void SetFile(FileRef file);
-			const CodeList & GetLines() const;
+			const LineList & GetLines() const;
+			const char* GetData() const;
+			size_t GetSize() const;
+			bool IsMapped() const;
 			long NumSymbols() const;
 			long NumLines() const;
 			bool IsEmpty() const;
 
-			const CodeList& operator *() const;
-			const CodeList* operator ->() const;
-
 			/*\ Get begin line Position \*/
 			Position Begin();
 
@@ -74,11 +79,34 @@ namespace SCRambl
 
 			/*\ Add a line of code to the grande list \*/
 			void AddLine(const CodeLine&);
+			void AddLine(const std::string&);
 			Position& AddLine(Position&, const CodeLine&);
 
+			/*\
+			 - Add the raw contents of a mapped file, borrowing them if there's no other code
+			 - Trigraphs and line splices are resolved wherever they turn up
+			 - Returns the number of lines added
+			\*/
+			long Map(std::shared_ptr<const MappedFile>);
+
+			/*\
+			 - Add code from elsewhere to the end, as lines of the current file
+			 - Returns the number of lines added
+			\*/
+			long Append(const Code&);
+
 			/*\ Make the code vanish completely \*/
 			void Clear();
 
+			/*\ Copy borrowed symbols into our own buffer, so they can be changed (and whatever they were borrowed from can go) \*/
+			void Detach();
+
+			/*\
+			 - Replace all of the code with a buffer and the index of its lines
+			 - Used to bring back code that was already processed (see BuildCache)
+			\*/
+			void Assign(std::string, LineList);
+
 			/*\
 			 - Insert code from elsewhere onto the next line
 		 	 - Returns the beginning position of the inserted code
@@ -102,6 +130,12 @@ namespace SCRambl
 			\*/
 			std::string Select(const Position&, const Position&) const;
 
+			/*\
+			 - Points at the string sequence from Position A to Position B without copying it
+			 - Only good until the code is next changed
+			\*/
+			const char* View(const Position&, const Position&, size_t& size) const;
+
 			/*\
 			 - Copy the symbols from Position A to Position B
 			 - Returns the vector of collected symbols
@@ -109,13 +143,25 @@ namespace SCRambl
 			CodeLine& Copy(const Position&, const Position&, CodeLine&) const;
 
 		private:
-			CodeList m_Code;
+			std::string m_Buffer;
+			std::shared_ptr<const MappedFile> m_Mapping;
+			const char* m_Data = nullptr;		// either the buffer or the mapping
+			size_t m_Size = 0;
+			LineList m_Lines;
 			FileRef m_CurrentFile;
-			long m_NumSymbols = 0;
 
-			CodeList& GetLines();
-			CodeList& operator*();
-			CodeList* operator->();
+			// point back at the buffer after changing it
+			inline void Refresh() { m_Data = m_Buffer.data(); m_Size = m_Buffer.size(); }
+
+			// offset of the end of the line (i.e. the beginning of the next one)
+			size_t GetLineEnd(size_t) const;
+			// index of the line containing the offset
+			size_t GetLineIndex(size_t) const;
+
+			// insert/erase characters and keep the line index in check
+			void InsertSymbols(size_t, size_t, const char*, size_t);
+			void EraseSymbols(size_t, size_t);
+			void ReplaceSymbol(size_t, char);
 		};
 
 		/*\ Scripts::Position(tm) - iterating through all that matters since '14 \*/
@@ -123,15 +169,27 @@ namespace SCRambl
 			friend class Code;
 
 		public:
+			// Symbols aren't stored, so operator-> needs something to point at
+			class SymbolPtr {
+			public:
+				SymbolPtr(Symbol sym) : m_Symbol(sym)
+				{ }
+
+				inline const Symbol* operator->() const { return &m_Symbol; }
+
+			private:
+				Symbol m_Symbol;
+			};
+
 			// construct invalid thing
 			Position();
 
 			// beginning of code
 			Position(Code&);
 			Position(Code*);
-			// specified line of code
-			Position(Code*, unsigned long, unsigned long = 0);
-			Position(Code*, CodeList::iterator&);
+
+			// offset in code
+			Position(Code&, size_t);
 
 			/*\
 			 - Attempt to set this position at the next line
@@ -142,13 +200,36 @@ namespace SCRambl
 			 - Attempt to set this position at the next symbol
 			 - Returns true if another symbol is available
 			\*/
-			bool Forward();
+			inline bool Forward() {
+				if (m_Offset >= m_pCode->m_Size) return false;
+				++m_Offset;
+				Sync();
+				return !IsEnd();
+			}
 
 			/*\
 			 - Attempt to set this position at the previous symbol
 			 - Returns true if another symbol is available
 			\*/
-			bool Backward();
+			inline bool Backward() {
+				if (!m_Offset) return false;
+				--m_Offset;
+				if (m_LineIdx >= m_pCode->m_Lines.size()) m_LineIdx = m_pCode->m_Lines.size() - 1;
+				while (m_LineIdx && m_pCode->m_Lines[m_LineIdx].m_Offset > m_Offset) --m_LineIdx;
+				return true;
+			}
+
+			/*\
+			 - Skip ahead to the next character in the set (see CharScan::Match)
+			 - Returns true if one was found before the end
+			\*/
+			template<typename TSet>
+			inline bool Seek() {
+				if (IsEnd()) return false;
+				m_Offset += CharScan::Find<TSet>(m_pCode->m_Data + m_Offset, m_pCode->m_Size - m_Offset);
+				Sync();
+				return !IsEnd();
+			}
 
 			/*\
 			 - Attempt to erase the symbol at the current position
@@ -168,6 +249,12 @@ namespace SCRambl
 			\*/
 			Position& Insert(const CodeLine&);
 
+			/*\
+			 - Attempt to replace the symbol at the current position
+			 - Returns a reference to this position
+			\*/
+			Position& Replace(const Symbol&);
+
 			/*\
 			- Select a string from this position to the specified one
 			\*/
@@ -175,19 +262,26 @@ namespace SCRambl
 				return GetCode()->Select(*this, end);
 			}
 
+			/*\
+			- View the string from this position to the specified one without copying it
+			\*/
+			inline const char* View(const Position& end, size_t& size) const {
+				return GetCode()->View(*this, end, size);
+			}
+
 			/*\ Returns true if this position is at the end of the symbol list \*/
 			inline bool IsEnd() const {
-				return !m_pCode || GetCode()->IsEmpty() || m_LineIt == GetCodeLines().end() || m_CodeIt == m_LineIt->GetCode().End();
+				return !m_pCode || m_Offset >= m_pCode->m_Size;
 			}
 
 			/*\ Returns true if each Position refers to the same script position \*/
 			inline bool Compare(const Position& pos) const {
-				return m_pCode == pos.m_pCode && m_LineIt == pos.m_LineIt && m_CodeIt == pos.m_CodeIt;
+				return m_pCode == pos.m_pCode && m_Offset == pos.m_Offset;
 			}
 
 			/*\ Returns true if both Position's are on the same line \*/
 			inline bool IsOnSameLine(const Position& pos) const {
-				return m_LineIt == pos.m_LineIt;
+				return m_LineIdx == pos.m_LineIdx;
 			}
 
 			/*\ Returns true if the Position is on an earlier line \*/
@@ -202,47 +296,44 @@ namespace SCRambl
 
 			/*\ Returns true if the position is earlier \*/
 			inline bool IsEarlier(const Position& pos) const {
-				return IsOnEarlierLine(pos) || (IsOnSameLine(pos) && GetColumn() > pos.GetColumn());
+				return m_Offset > pos.m_Offset;
 			}
 
 			/*\ Returns true if the position is later \*/
 			inline bool IsLater(const Position& pos) const {
-				return IsOnLaterLine(pos) || (IsOnSameLine(pos) && GetColumn() < pos.GetColumn());
+				return m_Offset < pos.m_Offset;
 			}
 
 			/*\ Returns true if the Position points to the same character \*/
 			inline bool Compare(const char c) const {
-				return !IsEnd() ? *m_CodeIt == c : false;
+				return !IsEnd() ? GetChar() == c : false;
 			}
 
 			// Get teh code
 			inline Code* GetCode() { ASSERT(m_pCode); return m_pCode; }
 			inline const Code* GetCode() const { ASSERT(m_pCode); return m_pCode; }
-			inline CodeList& GetCodeLines() { ASSERT(m_pCode); return m_pCode->GetLines(); }
-			inline const CodeList& GetCodeLines() const { ASSERT(m_pCode); return m_pCode->GetLines(); }
+			inline const LineList& GetCodeLines() const { ASSERT(m_pCode); return m_pCode->GetLines(); }
 
 			// Get the current line of this position
-			inline Line& GetLine() { return *m_LineIt; }
-			inline const Line& GetLine() const { return *m_LineIt; }
+			inline const Line& GetLine() const { return m_pCode->m_Lines[m_LineIdx]; }
 
 			// Get the current number of the column at this position
-			inline int GetColumn() const { return m_CodeIt->Number(); }
+			int GetColumn() const;
+
+			// Get the offset of this position in the code buffer
+			inline size_t GetOffset() const { return m_Offset; }
 
-			// Get the current line code of this position
-			inline CodeLine& GetLineCode() { return m_LineIt->GetCode(); }
-			inline const CodeLine& GetLineCode() const { return m_LineIt->GetCode(); }
+			// Get the current character of this position
+			inline char GetChar() const { return m_pCode->m_Data[m_Offset]; }
 
 			// Get the current symbol of this position
-			inline Symbol& GetSymbol() { return *m_CodeIt; }
-			inline const Symbol& GetSymbol() const { return *m_CodeIt; }
+			inline Symbol GetSymbol() const { return GetChar(); }
 
 			// GetSymbol()
-			inline Symbol& operator*() { return GetSymbol(); }
-			inline const Symbol& operator*() const { return GetSymbol(); }
+			inline Symbol operator*() const { return GetSymbol(); }
 
 			// GetSymbol()
-			inline Symbol* operator->() { return &**this; }
-			inline const Symbol* operator->() const { return &**this; }
+			inline SymbolPtr operator->() const { return GetSymbol(); }
 
 			// !IsEnd()
 			inline operator bool() const { return !IsEnd(); }
@@ -258,17 +349,15 @@ namespace SCRambl
 				return *this;
 			}
 
-			// 
+			//
 			inline Position& operator=(const Position& pos) {
 				m_pCode = pos.m_pCode;
-				m_CodeIt = pos.m_CodeIt;
-				m_LineIt = pos.m_LineIt;
+				m_Offset = pos.m_Offset;
+				m_LineIdx = pos.m_LineIdx;
 				return *this;
 			}
-			inline Position operator[](int i) {
-				Position new_pos = *this;
-				for (i; i > 0; --i) if (!new_pos.Forward()) break;
-				return new_pos;
+			inline Position operator[](int i) const {
+				return *this + i;
 			}
 
 			// Forward()
@@ -283,14 +372,14 @@ namespace SCRambl
 			}
 			inline Position operator+(int n) const {
 				Position new_pos = *this;
-				for (n; n > 0; --n)
-				{
-					if (!new_pos.Forward()) break;
-				}
-				return new_pos;
+				return new_pos += n;
 			}
 			inline Position& operator+=(int n) {
-				for (n; n > 0; --n) if (!Forward()) break;
+				if (n > 0) {
+					auto size = m_pCode->m_Size;
+					m_Offset = m_Offset + n < size ? m_Offset + n : size;
+					Sync();
+				}
 				return *this;
 			}
 
@@ -306,14 +395,13 @@ namespace SCRambl
 			}
 			inline Position operator-(int n) const {
 				Position new_pos = *this;
-				for (n; n > 0; --n)
-				{
-					if (!new_pos.Backward()) break;
-				}
-				return new_pos;
+				return new_pos -= n;
 			}
 			inline Position& operator-=(int n) {
-				for (n; n > 0; --n) if (!Backward()) break;
+				if (n > 0) {
+					m_Offset = static_cast<size_t>(n) < m_Offset ? m_Offset - n : 0;
+					m_LineIdx = m_pCode->GetLineIndex(m_Offset);
+				}
 				return *this;
 			}
 
@@ -355,16 +443,18 @@ namespace SCRambl
 			static inline std::string Formatter(const Position& pos) {
 				return std::to_string(pos.GetLine().GetLine());
 			}
-		
+
 		private:
 			Code* m_pCode = nullptr;
-			CodeList::iterator m_LineIt;		// (x)
-			CodeLine::iterator m_CodeIt;		// (y)
-
-			inline CodeList::iterator GetLineIt() { return m_LineIt; }
-			inline CodeLine::iterator GetSymbolIt() { return m_CodeIt; }
-
-			void GetCodeLine();
+			size_t m_Offset = 0;			// (x)
+			size_t m_LineIdx = 0;			// (y)
+
+			// move the line index up to wherever the offset has got to
+			inline void Sync() {
+				auto& lines = m_pCode->m_Lines;
+				if (m_Offset >= m_pCode->m_Size) m_LineIdx = lines.size();
+				else while (m_LineIdx + 1 < lines.size() && lines[m_LineIdx + 1].m_Offset <= m_Offset) ++m_LineIdx;
+			}
 		};
 
 		/*\ Scripts::Range - Range of Position's in the script \*/
@@ -395,4 +485,4 @@ namespace SCRambl
 			inline std::string Format() const { return Formatter(*this); }
 		};
 	}
-}
\ No newline at end of file
+}
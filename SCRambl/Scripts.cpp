@@ -36,30 +36,36 @@ void Script::SetCode(const void* data) {
 	if (!m_Code) m_Code = new Code();
 	if (!m_Code->IsEmpty()) m_Code->Clear();
 	if (cdata[i]) {
+		std::string line;
 		do {
-			CodeLine line;
 			std::string code;
 			for (; cdata[i] && cdata[i] != '\n'; ++i)
 				code.push_back(cdata[i]);
+			line.clear();
 			eol = ProcessCodeLine(code, line, eol);
 			m_Code->AddLine(line);
 		} while (cdata[++i]);
 	}
 }
 void Script::ReadFile(std::ifstream& file, Code& dest) {
-	std::string code;
+	std::string code, line;
 
 	// use this flag to prevent multiple concurrent eol's and escape new lines
 	bool eol = false;
 	while (std::getline(file, code)) {
-		CodeLine line;
+		line.clear();
 		eol = ProcessCodeLine(code, line, eol);
 		dest.AddLine(line);
 	}
 }
-bool Script::ProcessCodeLine(const std::string& code, CodeLine& line, bool eol) {
+bool Script::ProcessCodeLine(const std::string& code, std::string& line, bool eol) {
 	int col = 1;
-	if (!code.empty()) {
+	if (!code.empty() && CharScan::Find<CharScan::Match<'?', '\\'>>(code.data(), code.size()) == code.size()) {
+		// nothing to look out for, take the lot
+		line.append(code);
+		eol = true;
+	}
+	else if (!code.empty()) {
 		for (auto it = code.begin(); it != code.end(); ++col) {
 			char c = *it;
 			++it;
@@ -88,13 +94,13 @@ bool Script::ProcessCodeLine(const std::string& code, CodeLine& line, bool eol)
 				break;
 			}
 
-			line.Append(c);
+			line.push_back(c);
 			eol = true;
 		}
 	}
 
 	if (eol) {
-		line.Append(Symbol::eol);
+		line.push_back(Symbol(Symbol::eol));
 		eol = false;
 	}
 	return eol;
@@ -102,9 +108,10 @@ bool Script::ProcessCodeLine(const std::string& code, CodeLine& line, bool eol)
 FileRef Script::OpenFile(const std::string& path) {
 	FileRef ref(m_Files);
 	bool wasempty = m_Files.empty();
-	m_Files.emplace_back(m_Code ? (m_Code, path) : path);
+	// each file gets code of its own, the preprocessor goes through them in order
+	m_Files.emplace_back(path);
 	if (wasempty && ref) m_Code = ref->GetCode();
-	if (m_Code) m_Code->SetFile(ref);
+	if (ref) ref->GetCode()->SetFile(ref);
 	return m_File = ref;
 }
 bool Script::IsFileOpen() const {
@@ -114,12 +121,16 @@ long long Script::GetNumLines() const {
 	return m_Code->NumLines();
 }
 Position Script::Include(Position& pos, const std::string& path) {
-	ASSERT(m_File);
+	return Include(m_File, pos, path);
+}
+Position Script::Include(FileRef file, Position& pos, const std::string& path) {
+	ASSERT(file);
 	try {
-		m_File->IncludeFile(pos, path);
+		if (m_SourceCache) file->IncludeFile(pos, path, *m_SourceCache);
+		else file->IncludeFile(pos, path);
 	}
 	catch (const File &) {
-		return m_Code->End();
+		return file->GetCode()->End();
 	}
 	return pos;
 }
@@ -140,9 +151,9 @@ Tokens::Map Script::GenerateTokenMap() {
 }
 
 /* Scripts::File */
-File::File() : m_Code(new Code())
+File::File() : m_CodeOwner(std::make_shared<Code>()), m_Code(m_CodeOwner.get())
 { }
-File::File(const File& file) : m_Parent(file.m_Parent), m_Code(file.m_Code),
+File::File(const File& file) : m_Parent(file.m_Parent), m_CodeOwner(file.m_CodeOwner), m_Code(file.m_Code),
 	m_FileOpen(file.m_FileOpen), m_Begin(file.m_Begin), m_End(file.m_End),
 	m_Path(file.m_Path), m_NumLines(file.m_NumLines)
 {
@@ -155,7 +166,7 @@ File::File(File* parent) : m_Parent(parent), m_Code(parent->GetCode())
 { }
 File::File(Code* code) : m_Code(code)
 { }
-File::File(std::string path) : m_Code(new Code()) {
+File::File(std::string path) : m_CodeOwner(std::make_shared<Code>()), m_Code(m_CodeOwner.get()) {
 	Open(path);
 }
 File::File(File* parent, std::string path) : m_Parent(parent), m_Path(path), m_Code(parent->GetCode()), m_FileOpen(false) {
@@ -165,7 +176,6 @@ File::File(Code* code, std::string path) : m_Code(code), m_Path(path), m_FileOpe
 	Open(path);
 }
 File::~File() {
-	if (m_Code) delete m_Code;
 	m_Code = nullptr;
 }
 bool File::IsOpen() const {
@@ -177,13 +187,30 @@ long File::GetNumLines() const {
 long File::GetNumIncludes() const {
 	return m_Includes.size();
 }
+std::string File::GetPath() const {
+	return m_Path;
+}
+const Files& File::GetIncludes() const {
+	return m_Includes;
+}
 Code* File::GetCode() const {
 	return m_Code;
 }
 void File::SetCode(Code* code) {
 	m_Code = code;
 }
-bool File::Open(std::string path) {
+bool File::Open(std::string path, LoadMode mode) {
+	if (mode == LoadMode::mapped) {
+		auto mapping = std::make_shared<MappedFile>(path);
+		if (mapping->IsOpen()) {
+			m_FileOpen = true;
+			m_Path = path;
+			m_NumLines += m_Code->Map(mapping);
+			return m_FileOpen;
+		}
+		// no luck? do it the old fashioned way
+	}
+
 	std::ifstream file(path, std::ios::in);
 	if (file) {
 		m_FileOpen = true;
@@ -198,10 +225,10 @@ bool File::Open(std::string path) {
 }
 void File::ReadFile(std::ifstream& file) {
 	bool eol = false;	// use to prevent eol sequences and escape new lines
-	std::string code;
+	std::string code, line;
 	while (std::getline(file, code)) {
 		int col = 1;
-		CodeLine line;
+		line.clear();
 		if (!code.empty()) {
 			for (auto it = code.begin(); it != code.end(); ++col) {
 				char c = *it;
@@ -214,225 +241,385 @@ void File::ReadFile(std::ifstream& file) {
 					}
 				}
 
-				line.Append(c);
+				line.push_back(c);
 				eol = true;
 			}
 		}
 
+		// ended with a newline like mapped code
 		if (eol) {
-			line.Append(Symbol::eol);
+			line.push_back('\n');
 			eol = false;
 		}
 
-		m_Code->End() << line;
-		m_Code->End().NextLine();
+		m_Code->AddLine(line);
 		++m_NumLines;
 	}
 }
+bool File::Open(std::string path, SourceCache& cache) {
+	if (auto code = cache.Get(path)) {
+		m_FileOpen = true;
+		m_Path = path;
+		m_NumLines += m_Code->Append(*code);
+		return m_FileOpen;
+	}
+	// it couldn't be mapped, so it's read without the cache
+	return Open(path, LoadMode::stream);
+}
 FileRef File::IncludeFile(Position& pos, std::string path) {
 	FileRef ref(m_Includes);
 	m_Includes.emplace_back(this, path);
 	pos.NextLine();
 	return ref;
 }
+FileRef File::IncludeFile(Position& pos, std::string path, SourceCache& cache) {
+	FileRef ref(m_Includes);
+	m_Includes.emplace_back(this);
+	m_Includes.back().Open(path, cache);
+	pos.NextLine();
+	return ref;
+}
+FileRef File::IncludeCode(std::string path) {
+	FileRef ref(m_Includes);
+	m_Includes.emplace_back();
+	auto& file = m_Includes.back();
+	file.m_Parent = this;
+	file.m_Path = path;
+	file.m_FileOpen = true;
+	return ref;
+}
 
 /* Scripts::Position */
 Position::Position() : m_pCode(nullptr)
 { }
 Position::Position(Code& code) : Position(&code)
 { }
-Position::Position(Code* code) : m_pCode(code) {
-	m_LineIt = m_pCode->GetLines().begin();
-	GetCodeLine();
-}
-Position::Position(Code* code, CodeList::iterator& it) : m_pCode(code) {
-	m_LineIt = it;
-	GetCodeLine();
-}
-Position::Position(Code* code, unsigned long line, unsigned long col) : m_pCode(code) {
-	auto src_it = code->GetLines().end();
-	for (auto it = code->GetLines().begin(); it != code->GetLines().end(); ++it) {
-		if (it->GetLine() < line) {
-			src_it = it;
-		}
-		//m_LineIt = m_pCode->AddLine();
-	}
-		
-	m_LineIt = src_it != code->GetLines().end() ? src_it : code->GetLines().end();
-	if (col != -1) {
-		m_CodeIt = m_LineIt->GetCode().End();
-		for (auto it = m_LineIt->GetCode().Begin(); it != m_LineIt->GetCode().End(); ++it)
-		{
-			if (it->Number() < col) {
-				m_CodeIt = it;
-			}
-			else break;
-		}
-	}
-	else m_CodeIt = m_LineIt->GetCode().Begin();
-}
-void Position::GetCodeLine() {
-	if (!m_pCode->IsEmpty() && m_LineIt != m_pCode->GetLines().end())
-		m_CodeIt = m_LineIt->GetCode().Begin();
-}
+Position::Position(Code* code) : m_pCode(code)
+{ }
+Position::Position(Code& code, size_t offset) : m_pCode(&code),
+	m_Offset(offset < code.m_Size ? offset : code.m_Size), m_LineIdx(code.GetLineIndex(m_Offset))
+{ }
 Position& Position::NextLine() {
-	if (m_LineIt != m_pCode->GetLines().end()) {
-		while (++m_LineIt != m_pCode->GetLines().end()) {
-			m_CodeIt = m_LineIt->GetCode().Begin();
-			if (m_CodeIt != m_LineIt->GetCode().End())
-				break;
+	auto& lines = m_pCode->m_Lines;
+	if (m_LineIdx < lines.size()) {
+		// skip any lines that have been emptied out
+		while (++m_LineIdx < lines.size()) {
+			m_Offset = lines[m_LineIdx].m_Offset;
+			if (m_Offset != m_pCode->GetLineEnd(m_LineIdx))
+				return *this;
 		}
+		m_Offset = m_pCode->m_Size;
 	}
 	return *this;
 }
-bool Position::Forward() {
-	if (m_CodeIt != m_LineIt->GetCode().End()) {
-		if (++m_CodeIt != m_LineIt->GetCode().End())
-			return true;
-	}
-	// better luck next line
-	return NextLine();
-}
-bool Position::Backward() {
-	if (m_CodeIt != m_LineIt->GetCode().Begin()) {
-		--m_CodeIt;
-		return true;
-	}
-	while (m_LineIt != m_pCode->GetLines().begin()) {
-		--m_LineIt;
-		m_CodeIt = GetLine().GetCode().End();
-		if (m_CodeIt != GetLine().GetCode().Begin())
-			return true;
+int Position::GetColumn() const {
+	// work it out from the start of the line - a tab takes up to 4 columns
+	int col = 0;
+	if (IsEnd()) return col;
+	auto data = m_pCode->m_Data;
+	for (auto i = GetLine().GetOffset(); i <= m_Offset; ++i) {
+		if (data[i] == '\t') col += 4 - (col % 4);
+		else ++col;
 	}
-	return false;
+	return col;
 }
 Position& Position::Insert(const Symbol& sym) {
 	// insert a single character
-	if (!IsEnd()) m_CodeIt = GetLine().GetCode().Insert(m_CodeIt, sym);
+	if (!IsEnd()) {
+		char c = sym.GetChar();
+		m_pCode->InsertSymbols(m_Offset, m_LineIdx, &c, 1);
+	}
+	return *this;
+}
+Position& Position::Insert(const CodeLine& code) {
+	return m_pCode->Insert(*this, code);
+}
+Position& Position::Replace(const Symbol& sym) {
+	if (!IsEnd()) m_pCode->ReplaceSymbol(m_Offset, sym.GetChar());
 	return *this;
 }
 Position& Position::Delete() {
 	// erase a single character
 	if (!IsEnd()) {
-		m_CodeIt = GetLine().GetCode().Erase(m_CodeIt);
-		if (m_CodeIt == GetLine().GetCode().End())
-			Forward();
+		m_pCode->EraseSymbols(m_Offset, m_Offset + 1);
+		Sync();
 	}
 	return *this;
 }
 
 /* Scripts::Code */
 Code::Code() = default;
-Code::Code(const CodeList& code) : m_Code(code)
-{ }
-CodeList& Code::operator*() {
-	return GetLines();
-}
-CodeList* Code::operator->() {
-	return &**this;
+Code::Code(const Code& code) : m_Buffer(code.m_Buffer), m_Mapping(code.m_Mapping),
+	m_Data(code.m_Data), m_Size(code.m_Size), m_Lines(code.m_Lines), m_CurrentFile(code.m_CurrentFile)
+{
+	if (!m_Mapping) Refresh();
 }
 void Code::SetFile(FileRef file) {
 	m_CurrentFile = file;
 }
-const CodeList& Code::GetLines() const {
-	return m_Code;
+const LineList& Code::GetLines() const {
+	return m_Lines;
 }
-CodeList& Code::GetLines() {
-	return m_Code;
+const char* Code::GetData() const {
+	return m_Data;
+}
+size_t Code::GetSize() const {
+	return m_Size;
+}
+bool Code::IsMapped() const {
+	return m_Mapping != nullptr;
 }
 long Code::NumSymbols() const {
-	return m_NumSymbols;
+	return m_Size;
 }
 long Code::NumLines() const {
-	return m_CurrentFile ? m_CurrentFile->GetNumLines() : m_Code.size();
+	return m_CurrentFile ? m_CurrentFile->GetNumLines() : m_Lines.size();
 }
 bool Code::IsEmpty() const {
-	return m_Code.empty();
+	return !m_Size;
+}
+size_t Code::GetLineEnd(size_t idx) const {
+	return idx + 1 < m_Lines.size() ? m_Lines[idx + 1].m_Offset : m_Size;
+}
+size_t Code::GetLineIndex(size_t offset) const {
+	if (offset >= m_Size) return m_Lines.size();
+	// last line starting at or before the offset
+	auto it = std::upper_bound(m_Lines.begin(), m_Lines.end(), offset, [](size_t off, const Line& line){
+		return off < line.m_Offset;
+	});
+	return it != m_Lines.begin() ? std::distance(m_Lines.begin(), it) - 1 : 0;
+}
+void Code::Detach() {
+	if (m_Mapping) {
+		m_Buffer.assign(m_Data, m_Size);
+		m_Mapping.reset();
+		Refresh();
+	}
 }
-const CodeList& Code::operator*() const {
-	return GetLines();
+void Code::InsertSymbols(size_t offset, size_t line, const char* data, size_t size) {
+	Detach();
+	m_Buffer.insert(offset, data, size);
+	Refresh();
+	// every line after this one has been pushed along
+	for (auto i = line + 1; i < m_Lines.size(); ++i)
+		m_Lines[i].m_Offset += size;
+}
+void Code::EraseSymbols(size_t begin, size_t end) {
+	if (end <= begin) return;
+	auto idx = GetLineIndex(begin);
+	Detach();
+	m_Buffer.erase(begin, end - begin);
+	Refresh();
+	// lines starting inside the erased bit are left empty, the rest get pulled back
+	for (auto i = idx; i < m_Lines.size(); ++i) {
+		auto& off = m_Lines[i].m_Offset;
+		if (off > end) off -= end - begin;
+		else if (off > begin) off = begin;
+	}
 }
-const CodeList* Code::operator->() const {
-	return &**this;
+void Code::ReplaceSymbol(size_t offset, char c) {
+	if (m_Data[offset] == c) return;
+	Detach();
+	m_Buffer[offset] = c;
 }
 Position Code::Begin() {
 	return this;
 }
 Position Code::End() {
 	Position pos(this);
-	pos.m_LineIt = m_Code.empty() ? m_Code.begin() : m_Code.end();
-	pos.GetCodeLine();
+	pos.m_Offset = m_Size;
+	pos.m_LineIdx = m_Lines.size();
 	return pos;
 }
 void Code::AddLine(const CodeLine& code) {
 	if (!code.Empty()) {
-		m_Code.emplace_back(NumLines() + 1, code, m_CurrentFile);
-		m_NumSymbols += code.Size();
+		m_Lines.emplace_back(NumLines() + 1, m_Size, m_CurrentFile);
+		Detach();
+		for (auto& col : code)
+			m_Buffer.push_back(*col);
+		Refresh();
+	}
+}
+void Code::AddLine(const std::string& code) {
+	if (!code.empty()) {
+		m_Lines.emplace_back(NumLines() + 1, m_Size, m_CurrentFile);
+		Detach();
+		m_Buffer.append(code);
+		Refresh();
 	}
 }
 Position& Code::AddLine(Position& pos, const CodeLine& code) {
 	if (!code.Empty()) {
-		pos.m_LineIt = m_Code.emplace(pos.GetLineIt(), NumLines() + 1, code, m_CurrentFile);
-		pos.GetCodeLine();
-		m_NumSymbols += code.Size();
+		// the new line goes before the one at the position
+		auto idx = pos.m_LineIdx < m_Lines.size() ? pos.m_LineIdx : m_Lines.size();
+		auto offset = idx < m_Lines.size() ? m_Lines[idx].m_Offset : m_Size;
+		std::string str = code.String();
+
+		Detach();
+		m_Buffer.insert(offset, str);
+		Refresh();
+		for (auto i = idx; i < m_Lines.size(); ++i)
+			m_Lines[i].m_Offset += str.size();
+		m_Lines.emplace(m_Lines.begin() + idx, NumLines() + 1, offset, m_CurrentFile);
+
+		pos.m_Offset = offset;
+		pos.m_LineIdx = idx;
 	}
 	return pos;
 }
+long Code::Map(std::shared_ptr<const MappedFile> file) {
+	auto begin = m_Size;
+	if (!file->Size()) return 0;
+
+	// nothing else here? then just borrow the lot
+	if (!m_Size && !m_Mapping) {
+		m_Mapping = file;
+		m_Data = file->Data();
+		m_Size = file->Size();
+	}
+	else {
+		Detach();
+		m_Buffer.append(file->Data(), file->Size());
+		Refresh();
+	}
+
+	// index the lines
+	long num_lines = 0;
+	auto first_line = NumLines() + 1;
+	for (auto offset = begin; offset < m_Size; ++num_lines) {
+		m_Lines.emplace_back(first_line + num_lines, offset, m_CurrentFile);
+		auto eol = static_cast<const char*>(memchr(m_Data + offset, '\n', m_Size - offset));
+		offset = eol ? eol - m_Data + 1 : m_Size;
+	}
+
+	// every line has to end somewhere
+	if (m_Data[m_Size - 1] != '\n') {
+		Detach();
+		m_Buffer.push_back('\n');
+		Refresh();
+	}
+
+	// find any trigraphs or line splices - hopefully there are none and nothing gets touched
+	struct Splice { size_t offset, length; char replacement; };
+	std::vector<Splice> splices;
+	size_t skip = 0;
+	CharScan::ForEach<CharScan::Match<'?', '\\'>>(m_Data + begin, m_Size - begin, [&](size_t i){
+		auto at = begin + i, offset = at;
+		if (offset < skip) return true;
+
+		char c = m_Data[offset];
+		size_t length = 1;
+		if (c == '?') {
+			if (offset + 2 >= m_Size || m_Data[offset + 1] != '?') return true;
+			c = GetTrigraphChar(m_Data[offset + 2]);
+			if (!c) return true;
+			offset += 2;
+			length = 3;
+		}
+		if (c == '\\') {
+			// is it escaping the new line?
+			auto next = offset + 1;
+			if (next < m_Size && m_Data[next] == '\r') ++next;
+			if (next < m_Size && m_Data[next] == '\n') {
+				splices.push_back({ at, next - at + 1, 0 });
+				skip = next + 1;
+				return true;
+			}
+		}
+		if (length > 1) {
+			splices.push_back({ at, length, c });
+			skip = offset + 1;
+		}
+		return true;
+	});
+
+	// work backwards so the offsets still point where they should
+	for (auto it = splices.rbegin(); it != splices.rend(); ++it) {
+		if (it->replacement) {
+			ReplaceSymbol(it->offset, it->replacement);
+			EraseSymbols(it->offset + 1, it->offset + it->length);
+		}
+		else EraseSymbols(it->offset, it->offset + it->length);
+	}
+	return num_lines;
+}
+long Code::Append(const Code& code) {
+	if (code.IsEmpty()) return 0;
+
+	auto offset = m_Size;
+	auto first_line = NumLines() + 1;
+	Detach();
+	m_Buffer.append(code.m_Data, code.m_Size);
+	Refresh();
+
+	long num_lines = 0;
+	for (auto& line : code.m_Lines)
+		m_Lines.emplace_back(first_line + num_lines++, offset + line.m_Offset, m_CurrentFile);
+	return num_lines;
+}
 void Code::Clear() {
-	m_Code.clear();
-	m_NumSymbols = 0;
+	m_Buffer.clear();
+	m_Mapping.reset();
+	m_Lines.clear();
+	Refresh();
+}
+void Code::Assign(std::string buffer, LineList lines) {
+	m_Buffer = std::move(buffer);
+	m_Mapping.reset();
+	m_Lines = std::move(lines);
+	Refresh();
 }
 Position& Code::Insert(Position& at, const Code& code) {
-	auto lnit = at.GetLineIt();
-	++lnit;
-	for (auto line : *code) {
-		lnit = at.GetCode()->GetLines().insert(lnit, line);
-		++lnit;
-	}
+	if (code.IsEmpty()) return at;
+
+	// everything goes in after the current line
+	auto idx = at.m_LineIdx < m_Lines.size() ? at.m_LineIdx + 1 : m_Lines.size();
+	auto offset = idx < m_Lines.size() ? m_Lines[idx].m_Offset : m_Size;
+
+	Detach();
+	m_Buffer.insert(offset, code.m_Data, code.m_Size);
+	Refresh();
+	for (auto i = idx; i < m_Lines.size(); ++i)
+		m_Lines[i].m_Offset += code.m_Size;
+
+	std::vector<Line> lines(code.m_Lines);
+	for (auto& line : lines)
+		line.m_Offset += offset;
+	m_Lines.insert(m_Lines.begin() + idx, lines.begin(), lines.end());
+
 	at.NextLine();
 	return at;
 }
 Position& Code::Insert(Position& at, const CodeLine& code) {
-	// keep a count of how many characters are added so we can fix the pointer
-	int i = 0;
-	for (auto ch : code) {
-		at << ch;
-		++at;
-		++i;
-	}
-
-	// revert to the old position
-	at.m_CodeIt -= i;
+	// the position stays at the beginning of the inserted code
+	std::string str = code.String();
+	at.m_pCode->InsertSymbols(at.m_Offset, at.m_LineIdx, str.data(), str.size());
 	return at;
 }
 Position& Code::Erase(Position& beg, Position& end) {
-	// update the end position
-	auto end_it = end.GetSymbolIt();
-	auto end_ln = end.GetLineIt();
-
-	// if they're not on the same line, erase the inbetweeny lines
-	if (beg.GetLineIt() != end.GetLineIt()) {
-		do {
-			auto & symbols = beg.GetLineCode();
-			auto beg_it = beg.GetSymbolIt();
-			beg.NextLine();
-			symbols.Erase(beg_it, symbols.End());
-		} while (beg.GetLineIt() != end.GetLineIt());
-	}
-
 	// bye-bye
-	end.m_CodeIt = beg.GetLineCode().Erase(beg.GetSymbolIt(), end.GetSymbolIt());
-	if (end.m_CodeIt == end.GetLineCode().End())
-		end.NextLine();
+	EraseSymbols(beg.m_Offset, end.m_Offset);
+
+	// update the end position
+	end.m_Offset = beg.m_Offset;
+	end.m_LineIdx = GetLineIndex(end.m_Offset);
 
 	// return the updated beginning position
 	return beg = end;
 }
 std::string Code::Select(const Position& beg, const Position& end) const {
-	std::string r;
-	for (auto cur = beg; cur && cur != end; ++cur)
-		if (cur) r += *cur;
-	return r;
+	if (beg.IsEnd()) return "";
+	auto end_offset = end.m_pCode == this && end.m_Offset > beg.m_Offset ? end.m_Offset : m_Size;
+	return std::string(m_Data + beg.m_Offset, end_offset - beg.m_Offset);
+}
+const char* Code::View(const Position& beg, const Position& end, size_t& size) const {
+	if (beg.IsEnd()) {
+		size = 0;
+		return "";
+	}
+	auto end_offset = end.m_pCode == this && end.m_Offset > beg.m_Offset ? end.m_Offset : m_Size;
+	size = end_offset - beg.m_Offset;
+	return m_Data + beg.m_Offset;
 }
 CodeLine& Code::Copy(const Position& beg, const Position& end, CodeLine& vec) const {
 	for (auto cur = beg; cur != end; ++cur)
@@ -441,26 +628,17 @@ CodeLine& Code::Copy(const Position& beg, const Position& end, CodeLine& vec) co
 }
 
 /* Scripts::Line */
-Line::Line(unsigned long line, CodeLine code, const FileRef file) : m_Line(line), m_Code(code), m_File(file)
+Line::Line(unsigned long line, size_t offset, const FileRef file) : m_Line(line), m_Offset(offset), m_File(file)
 { }
 const FileRef Line::GetFile() const {
 	return m_File;
 }
-CodeLine& Line::GetCode() {
-	return m_Code;
-}
-const CodeLine& Line::GetCode() const {
-	return m_Code;
-}
 unsigned long Line::GetLine() const {
 	return m_Line;
 }
-Line::operator const CodeLine&() const {
-	return GetCode();
-}
-Line::operator CodeLine&() {
-	return GetCode();
+size_t Line::GetOffset() const {
+	return m_Offset;
 }
 Line::operator unsigned long() const {
 	return GetLine();
-}
\ No newline at end of file
+}
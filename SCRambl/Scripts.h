@@ -7,6 +7,7 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <memory>
 #include <fstream>
 #include <assert.h>
 #include <unordered_map>
@@ -19,17 +20,22 @@
 #include "Types.h"
 #include "ScriptObjects.h"
 #include "Labels.h"
+#include "SourceCache.h"
 
 namespace SCRambl
 {
 	using TokenPtrVec = std::vector<IToken*>;
 
 	namespace Scripts {
-		using CodeList = std::list<Line>;
-		using CodeListRef = CodeList::iterator;
 		using Files = std::vector<File>;
 		using FileRef = VecRef<File>;
 
+		// How a File gets its code
+		enum class LoadMode {
+			stream,				// read line by line
+			mapped,				// map the file into memory and use it where it lies
+		};
+
 		/*\ Scripts::File - Script files and includes \*/
 		class File {
 		public:
@@ -46,18 +52,25 @@ namespace SCRambl
 			bool IsInclude() const;
 			long GetNumLines() const;
 			long GetNumIncludes() const;
+			const Files& GetIncludes() const;
 			std::string GetPath() const;
 			Code* GetCode() const;
 			void SetCode(Code*);
-			bool Open(std::string);
+			bool Open(std::string, LoadMode = LoadMode::mapped);
 			bool Open(Code*, std::string);
+			// Open from the cache, reading the file only if it's not there
+			bool Open(std::string, SourceCache&);
 			FileRef IncludeFile(Position&, std::string);
+			FileRef IncludeFile(Position&, std::string, SourceCache&);
+			// Include a file whose code is kept apart from ours (it's given none to begin with)
+			FileRef IncludeCode(std::string);
 
 		private:
 			void ReadFile(std::ifstream&);
 
 			bool m_FileOpen = false;
 			File* m_Parent;
+			std::shared_ptr<Code> m_CodeOwner;	// set if the code was made for this file (copies share it)
 			Code* m_Code;
 			Position m_Begin;
 			Position m_End;
@@ -92,11 +105,21 @@ namespace SCRambl
 		[in] position
 		[in] include file path */
 		Scripts::Position Include(Scripts::Position&, const std::string&);
+		/* Include File (into a specific file)
+		[in] file
+		[in] position
+		[in] include file path */
+		Scripts::Position Include(Scripts::FileRef, Scripts::Position&, const std::string&);
+		// Get included files from a cache rather than reading them each time (nullptr to stop)
+		inline void SetSourceCache(SourceCache* cache) { m_SourceCache = cache; }
 
 		Tokens::Map GenerateTokenMap();
 
 		// Get the code list
 		Scripts::Code& GetCode() { return *m_Code; }
+		// Get the opened files (not includes)
+		Scripts::Files& GetFiles() { return m_Files; }
+		const Scripts::Files& GetFiles() const { return m_Files; }
 		// Get the labels
 		Scripts::Labels& GetLabels() { return m_Labels ; }
 		// Get the tokens
@@ -106,7 +129,7 @@ namespace SCRambl
 		const Tokens::Storage& GetParseTokens() const { return m_ParseTokens; }
 
 	private:
-		bool ProcessCodeLine(const std::string&, CodeLine&, bool = false);
+		bool ProcessCodeLine(const std::string&, std::string&, bool = false);
 
 		Tokens::Storage m_Tokens;
 		Tokens::Storage m_ParseTokens;
@@ -115,5 +138,6 @@ namespace SCRambl
 		Scripts::Labels m_Labels;
 		Scripts::FileRef m_File;
 		Scripts::Code* m_Code;
+		SourceCache* m_SourceCache = nullptr;
 	};
 }
\ No newline at end of file
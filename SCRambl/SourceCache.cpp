@@ -0,0 +1,41 @@
+#include "stdafx.h"
+#include "SourceCache.h"
+
+using namespace SCRambl;
+
+SourceCache::CodeRef SourceCache::Get(const std::string& path) {
+	auto canonical = GetCanonicalPath(path);
+	uint64_t time, size;
+	if (!GetFileInfo(canonical, time, size)) return nullptr;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto it = m_Entries.find(canonical);
+		if (it != m_Entries.end() && it->second.Time == time && it->second.Size == size)
+			return it->second.Code;
+	}
+
+	// read it without holding anyone else up - if another thread reads it too, one of them wins
+	auto mapping = std::make_shared<MappedFile>(canonical);
+	if (!mapping->IsOpen()) return nullptr;
+	auto code = std::make_shared<Scripts::Code>();
+	code->Map(mapping);
+	// keep a copy rather than the mapping, which would stop the file being saved for as long as the engine's around
+	code->Detach();
+	mapping.reset();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto& entry = m_Entries[canonical];
+	entry.Code = code;
+	entry.Time = time;
+	entry.Size = size;
+	return code;
+}
+void SourceCache::Clear() {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Entries.clear();
+}
+size_t SourceCache::Size() const {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Entries.size();
+}
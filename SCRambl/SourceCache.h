@@ -0,0 +1,45 @@
+/**********************************************************/
+// SCRambl Advanced SCR Compiler/Assembler
+// This program is distributed freely under the MIT license
+// (See the LICENSE file provided
+//	 or copy at http://opensource.org/licenses/MIT)
+/**********************************************************/
+#pragma once
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "Scripts-code.h"
+
+namespace SCRambl
+{
+	// Code of included files, read and split into lines once for any number of includes (by any number of builds)
+	// Kept by canonical path, each file is checked against its modification time and size whenever it's got, and read again if it's changed
+	// One is kept by the engine and shared by all of its builds (can be used from any thread)
+	class SourceCache
+	{
+	public:
+		using CodeRef = std::shared_ptr<const Scripts::Code>;
+
+		SourceCache() = default;
+		SourceCache(const SourceCache&) = delete;
+
+		// Code of a file, read if it's not cached or has changed - nullptr if it can't be read
+		CodeRef Get(const std::string& path);
+		// Forget everything (the code stays alive as long as something's using it)
+		void Clear();
+		// Number of files cached
+		size_t Size() const;
+
+	private:
+		struct Entry {
+			CodeRef Code;
+			uint64_t Time;
+			uint64_t Size;
+		};
+
+		mutable std::mutex m_Mutex;
+		std::unordered_map<std::string, Entry> m_Entries;
+	};
+}
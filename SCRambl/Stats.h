@@ -0,0 +1,76 @@
+/**********************************************************/
+// SCRambl Advanced SCR Compiler/Assembler
+// This program is distributed freely under the MIT license
+// (See the LICENSE file provided
+//	 or copy at http://opensource.org/licenses/MIT)
+/**********************************************************/
+#pragma once
+#include <stdint.h>
+#include <map>
+
+namespace SCRambl
+{
+	// Things counted while a task runs
+	enum class Stat {
+		tokens,					// tokens added to the script
+		macros_expanded,
+		includes_opened,
+		includes_skipped,		// includes left out because of an include guard or #pragma once, or brought in precompiled
+		commands_resolved,		// command names matched to commands
+		bytes_emitted,			// bytes written to output files
+		allocations,			// token info allocated
+		max
+	};
+
+	// How long a task took and how much it got through
+	struct TaskStats {
+		double Seconds = 0.0;
+		size_t Steps = 0;						// times the task was run
+		uint64_t Counts[static_cast<size_t>(Stat::max)];
+
+		TaskStats() : Counts()
+		{ }
+
+		inline uint64_t& operator[](Stat stat) { return Counts[static_cast<size_t>(stat)]; }
+		inline uint64_t operator[](Stat stat) const { return Counts[static_cast<size_t>(stat)]; }
+
+		// Add the time and counts of another
+		inline void Add(const TaskStats& other) {
+			Seconds += other.Seconds;
+			Steps += other.Steps;
+			for (size_t i = 0; i < static_cast<size_t>(Stat::max); ++i)
+				Counts[i] += other.Counts[i];
+		}
+	};
+
+	// Stats of each task of a build, by task ID
+	class BuildStats {
+	public:
+		using Map = std::map<int, TaskStats>;
+
+		// Stats of a task, added if it's not been run yet
+		inline TaskStats& Get(int task) { return m_Tasks[task]; }
+		// Stats of a task, or nullptr if it's not been run
+		inline const TaskStats* Find(int task) const {
+			auto it = m_Tasks.find(task);
+			return it != m_Tasks.end() ? &it->second : nullptr;
+		}
+		inline const Map& GetTasks() const { return m_Tasks; }
+
+		// Loading definitions and such, before any task is run
+		inline TaskStats& Setup() { return m_Setup; }
+		inline const TaskStats& Setup() const { return m_Setup; }
+
+		// Setup and every task together
+		inline TaskStats Total() const {
+			auto total = m_Setup;
+			for (auto& pr : m_Tasks)
+				total.Add(pr.second);
+			return total;
+		}
+
+	private:
+		TaskStats m_Setup;
+		Map m_Tasks;
+	};
+}
@@ -11,6 +11,7 @@
 #include <map>
 #include <unordered_map>
 #include "utils.h"
+#include "utils/charscan.h"
 
 namespace SCRambl
 {
@@ -63,15 +64,16 @@ namespace SCRambl
 			return ' ';
 		}
 
-		void GetCharSymbolType(char character)
+		struct charsetpair { Type first; Grapheme second; };
+
+		static const charsetpair& GetCharSet(char character)
 		{
-			struct charsetpair { Type first; Grapheme second; };
-			static const std::vector<charsetpair> character_set = {
+			static const charsetpair character_set[0x80] = {
 				// Control chars
 				/* 00 */	{ /*NUL*/ eol },
 				/* 01-08 */	{ /*SOH*/ unknown },	{ /*STX*/ unknown },	{ /*ETX*/ unknown },	{ /*EOT*/ unknown },
 							{ /*ENQ*/ unknown },	{ /*ACK*/ unknown },	{ /*BEL*/ unknown },	{ /*BS */ unknown },
-				/* 09-0F */	{ /*HT */ whitespace }, { /*LF */ whitespace }, { /*VT */ whitespace }, { /*FF */ whitespace },
+				/* 09-0F */	{ /*HT */ whitespace }, { /*LF */ eol },		{ /*VT */ whitespace }, { /*FF */ whitespace },
 							{ /*CR */ whitespace }, { /*SO */ unknown },	{ /*SI */ unknown },
 				/* 10-1F */	{ /*DLE*/ unknown },	{ /*DC1*/ unknown },	{ /*DC2*/ unknown },	{ /*DC3*/ unknown },
 							{ /*DC4*/ unknown },	{ /*NAK*/ unknown },	{ /*SYN*/ unknown },	{ /*ETB*/ unknown },
@@ -126,13 +128,19 @@ namespace SCRambl
 							{ /* */ unknown },
 				// Extended...
 			};
+			static const charsetpair extended = { unknown };
 			int8_t ch = character;
 			ASSERT(character >= 0 && character <= 127);
-			ASSERT(character_set.size() == 0x80);
 			ASSERT(character_set['('].second == Grapheme::left_paren);
 			ASSERT(character_set[')'].second == Grapheme::right_paren);
-			m_Type = character_set[ch].first;
-			m_Grapheme = character_set[ch].second;
+			return ch >= 0 ? character_set[ch] : extended;
+		}
+
+		void GetCharSymbolType(char character)
+		{
+			auto& charset = GetCharSet(character);
+			m_Type = charset.first;
+			m_Grapheme = charset.second;
 		}
 
 	public:
@@ -147,6 +155,42 @@ namespace SCRambl
 			m_Character(GetGenericTypeChar(generic_type))
 		{ }
 
+		// Classify a character without constructing a Symbol
+		static inline Type GetCharType(char character) { return GetCharSet(character).first; }
+
+		// Classify a run of characters, one type for each
+		static inline void ClassifyScalar(const char* data, size_t size, Type* out, size_t i = 0) {
+			for (; i < size; ++i) out[i] = GetCharType(data[i]);
+		}
+		static inline void Classify(const char* data, size_t size, Type* out) {
+			size_t i = 0;
+#ifdef SCRAMBL_SIMD_SSE2
+			// do the common stuff 16 at a time, since whitespace is 0 anything matched can just be OR'd in
+			static_assert(whitespace == 0, "whitespace must be the zero symbol type");
+			for (; i + 16 <= size; i += 16) {
+				auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+				auto lower = _mm_or_si128(block, _mm_set1_epi8(0x20));
+				auto alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+				auto idents = _mm_or_si128(alpha, CharScan::Match<'_', '.'>::SSE2(block));
+				auto digits = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1)));
+				auto spaces = CharScan::Match<' ', '\t', '\v', '\f', '\r'>::SSE2(block);
+				auto eols = CharScan::Match<'\0', '\n'>::SSE2(block);
+				auto types = _mm_or_si128(_mm_and_si128(idents, _mm_set1_epi8(identifier)), _mm_and_si128(digits, _mm_set1_epi8(number)));
+				types = _mm_or_si128(types, _mm_and_si128(eols, _mm_set1_epi8(eol)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), types);
+
+				// the rest (mostly punctuation) can go to the table
+				auto known = _mm_or_si128(_mm_or_si128(idents, digits), _mm_or_si128(spaces, eols));
+				auto rest = static_cast<uint32_t>(~_mm_movemask_epi8(known) & 0xFFFF);
+				for (; rest; rest &= rest - 1) {
+					auto j = i + CharScan::LowestBit(rest);
+					out[j] = GetCharType(data[j]);
+				}
+			}
+#endif
+			ClassifyScalar(data, size, out, i);
+		}
+
 		inline char GetChar() const	{ return m_Character; }
 		inline Type GetType() const	{ return m_Type; }
 		inline Grapheme GetGrapheme() const	{ return m_Grapheme; }
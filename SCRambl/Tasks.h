@@ -6,6 +6,8 @@
 /**********************************************************/
 #pragma once
 #include <queue>
+#include <string>
+#include <vector>
 #include <memory>
 #include <map>
 #include <set>
@@ -25,58 +27,24 @@ namespace SCRambl
 		using task_exception::task_exception;
 	};
 
+	struct task_event;
+
 	namespace TaskSystem {
 		class Task;
 
+		// Event types are numbered at startup - each task keeps the handlers of an event type at that index
+		inline size_t NextEventID() {
+			static size_t next = 0;
+			return next++;
+		}
 		template<typename TEvent>
 		struct event_id {
-			static std::vector<std::type_index> vec;
+			static const size_t value;
 		};
+		template<typename TEvent>
+		const size_t event_id<TEvent>::value = NextEventID();
 
 		namespace {
-			// Events & handlers
-			class TaskEvent {
-				friend class Task;
-
-			public:
-				TaskEvent() = default;
-				virtual ~TaskEvent() {
-					// delete the function pointers
-					for (auto fun : m_Handlers) {
-						delete static_cast<std::function<bool(void)>*>(fun);
-					}
-				}
-
-				inline void SetName(std::string v, bool b = false) { if (m_Name.empty() || b) m_Name = v; }
-
-				// Add event handler
-				template<typename Func>
-				void AddHandler(Func handler) {
-					// sum magic
-					auto function = new decltype(to_function(handler))(to_function(handler));
-					// add the handler
-					m_Handlers.emplace_back(static_cast<void*>(function));
-				}
-				// Call handlers, returns number of successful calls
-				template<typename TEvent>
-				size_t CallHandler(TEvent& event) {
-					// this is surely impossible...?
-					if (m_Handlers.empty()) return false;
-					size_t calls = 0;
-					event.SetName(m_Name);
-					for (auto fun : m_Handlers) {
-						auto func = static_cast<std::function<bool(TEvent&)>*>(fun);
-						if (!(*func)(event)) break;
-						++calls;
-					}
-					return calls;
-				}
-
-			private:
-				std::vector<void*> m_Handlers;
-				std::string m_Name;
-			};
-
 			// Task interface - Task runner
 			class ITask
 			{
@@ -90,8 +58,17 @@ namespace SCRambl
 
 		// Task - tasks and events
 		class Task : public ITask {
-			using EventPair = std::pair<std::string, TaskEvent>;
-			using Events = std::deque<EventPair>;
+			// A handler, called straight through a function pointer with the event cast back to what it was added for
+			struct Handler {
+				bool (*Call)(void*, task_event&);
+				std::shared_ptr<void> Func;
+			};
+			// Everything added for one event type
+			struct EventSlot {
+				bool Added = false;
+				std::string Name;
+				std::vector<Handler> Handlers;
+			};
 
 		public:
 			enum State { init, running, error, finished };
@@ -101,17 +78,11 @@ namespace SCRambl
 			// Add an event
 			template<typename TEvent>
 			inline bool AddEvent(std::string name = "") {
-				static std::type_index event_id = typeid(TEvent);
 				ASSERT((std::is_base_of<task_event, TEvent>()) == true);
 				if (std::is_base_of<task_event, TEvent>()) {
-					auto it = m_EventMap.find(event_id);
-					if (it != std::end(m_EventMap))
-						it->second->second.SetName(!name.empty() ? name : event_id.name(), true);
-					else {
-						auto& v = MyAddEvent<TEvent>();
-						v.second.SetName(!name.empty() ? name : event_id.name());
-						m_EventMap[event_id] = &v;
-					}
+					auto& slot = GetSlot(event_id<TEvent>::value);
+					if (!name.empty() || slot.Name.empty())
+						slot.Name = !name.empty() ? name : typeid(TEvent).name();
 					return true;
 				}
 				return false;
@@ -119,35 +90,20 @@ namespace SCRambl
 			// Add an event handler
 			template<typename TEvent, typename Func>
 			inline void AddEventHandler(Func func) {
-				static std::type_index event_id = typeid(TEvent);
-				auto it = m_EventMap.find(event_id);
-				if (it != std::end(m_EventMap)) {
-					it->second->second.AddHandler<Func>(std::forward<Func>(std::ref(func)));
-				}
-				else {
-					auto& ev = MyAddEvent<TEvent>();
-					ev.second.AddHandler<Func>(std::forward<Func>(std::ref(func)));
-					m_EventMap[event_id] = &ev;
-				}
+				auto& slot = GetSlot(event_id<TEvent>::value);
+				if (slot.Name.empty()) slot.Name = typeid(TEvent).name();
+				Handler handler;
+				handler.Call = &CallHandler<TEvent, Func>;
+				handler.Func = std::make_shared<Func>(func);
+				slot.Handlers.emplace_back(handler);
 			}
 			// Call all handlers for an event - returns number of successful calls
 			template<typename TEvent>
 			inline size_t CallEvent(TEvent& event) {
 				// validate as derived event class
-				static std::type_index event_id = typeid(TEvent);
-				auto b = std::is_base_of<task_event, TEvent>();
-				if (event_id == typeid(task_event)) throw(task_bad_event());
-				if (!m_EventMap.empty()) {
-					for (auto id : event) {
-						auto iter = m_EventMap.find(id);
-						if (iter != std::end(m_EventMap)) {
-							// pass the message
-							return iter->second->second.CallHandler(event);
-						}
-					}
-				}
-				// nothing called, try a higher-up
-				return m_Parent ? m_Parent->CallEvent<TEvent>(event) : false;
+				static_assert(std::is_base_of<task_event, TEvent>::value, "CallEvent needs a task_event");
+				if (std::is_same<task_event, TEvent>::value) throw(task_bad_event());
+				return Dispatch(event);
 			}
 			// Gets the current state
 			inline State GetState()	const { return m_State; }
@@ -206,53 +162,74 @@ namespace SCRambl
 			inline State& TaskState() { return m_State; }
 
 		private:
-			template<typename TEvent>
-			EventPair& MyAddEvent() {
-				static std::type_index event_id = typeid(TEvent);
-				m_Events.emplace_front();
-				auto& ref = m_Events.front();
-				ref.first = event_id.name();
-				return ref;
+			template<typename TEvent, typename Func>
+			static bool CallHandler(void* func, task_event& event) {
+				return (*static_cast<Func*>(func))(static_cast<TEvent&>(event));
 			}
+			inline EventSlot& GetSlot(size_t id) {
+				if (id >= m_Slots.size()) m_Slots.resize(id + 1);
+				m_Slots[id].Added = true;
+				return m_Slots[id];
+			}
+			// The first task up the chain with anything added for the event (or one of the events it's linked to) gets it
+			size_t Dispatch(task_event& event);
 
 		private:
 			State m_State = State::init;
 			Task* m_Parent = nullptr;
 
 			// events can be handled by the implementor
-			Events m_Events;
-			std::unordered_map<std::type_index, EventPair*> m_EventMap;
+			std::vector<EventSlot> m_Slots;
 		};
 	}
 
 	struct task_event {
-		using LinkEventDeque = std::deque<const std::type_index>;
-		friend TaskSystem::TaskEvent;
+		friend TaskSystem::Task;
+
 		task_event() {
 			LinkEvent<task_event>("task_event");
 		}
 		virtual ~task_event() { }
 
-		virtual size_t Send(TaskSystem::Task& task) {
-			return task.Event(*this);
-		}
-
-		inline const std::string& Name() const { return m_Name; }
-		LinkEventDeque::const_iterator begin() const { return m_LinkEvents.begin(); }
-		LinkEventDeque::const_iterator end() const { return m_LinkEvents.end(); }
+		inline const char* Name() const { return m_Name; }
 
 	protected:
+		// Link the event to an event type it can be handled as (most derived last), naming it after it
 		template<typename TEvent>
-		void LinkEvent(std::string name) {
+		void LinkEvent(const char* name) {
+			if (m_NumLinks < max_links) m_Links[m_NumLinks++] = TaskSystem::event_id<TEvent>::value;
 			m_Name = name;
-			m_LinkEvents.emplace_front(typeid(TEvent));
 		}
 
 	private:
-		inline void SetName(std::string name, bool b = false) { if (m_Name.empty() || b) m_Name = name; }
+		enum { max_links = 8 };
 
-	private:
-		std::string m_Name;
-		LinkEventDeque m_LinkEvents;
+		const char* m_Name = "";
+		size_t m_Links[max_links];
+		size_t m_NumLinks = 0;
 	};
+
+	namespace TaskSystem {
+		inline size_t Task::Dispatch(task_event& event) {
+			for (auto task = this; task; task = task->m_Parent) {
+				auto& slots = task->m_Slots;
+				if (slots.empty()) continue;
+				for (auto i = event.m_NumLinks; i--;) {
+					auto id = event.m_Links[i];
+					if (id >= slots.size() || !slots[id].Added) continue;
+
+					// pass the message
+					auto& slot = slots[id];
+					if (!*event.m_Name) event.m_Name = slot.Name.c_str();
+					size_t calls = 0;
+					for (auto& handler : slot.Handlers) {
+						if (!handler.Call(handler.Func.get(), event)) break;
+						++calls;
+					}
+					return calls;
+				}
+			}
+			return 0;
+		}
+	}
 }
\ No newline at end of file
@@ -1,10 +1,35 @@
 #include "stdafx.h"
 #include "Tokens.h"
 #include "Scripts.h"
+#include "TokensB.h"
+#include "Preprocessor.h"
 
 using namespace SCRambl;
 using namespace SCRambl::Tokens;
 
+// Tokens::Token
+void Token::Refresh() {
+	m_Value.Integer = 0;
+	if (!m_Token) {
+		m_Type = Type::None;
+		return;
+	}
+	m_Type = m_Token->GetType<Type>();
+	switch (m_Type) {
+	case Type::Number:
+		if (Number::IsTypeFloat(*m_Token))
+			m_Value.Float = *m_Token->Get<Number::Info<Numbers::FloatType>>().GetValue<Number::NumberValue>();
+		else
+			m_Value.Integer = *m_Token->Get<Number::Info<Numbers::IntegerType>>().GetValue<Number::NumberValue>();
+		break;
+	case Type::Character:
+		m_Value.Enum = Character::GetCharacter<Preprocessing::Character>(*m_Token);
+		break;
+	case Type::Delimiter:
+		m_Value.Enum = Delimiter::GetDelimiterType<Preprocessing::Delimiter>(*m_Token);
+		break;
+	}
+}
 // Tokens::Line
 Line::Ref Line::GetToken(size_t col) {
 	return Line::Ref(m_Line, col);
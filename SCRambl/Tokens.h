@@ -7,6 +7,7 @@
 #pragma once
 #include "TokenInfo.h"
 #include "Scripts-code.h"
+#include "utils/arena.h"
 
 namespace SCRambl
 {
@@ -43,36 +44,62 @@ namespace SCRambl
 			Type m_Type;
 		};
 	
-		// Script token wrapper
+		// Script token record - kept by value in the storage
+		// The type and any small value are copied out of the info, so walking the tokens needn't chase it
 		class Token {
+		public:
+			// small value kept inline (number values, character and delimiter types)
+			union Value {
+				long long Integer;
+				float Float;
+				int Enum;
+			};
+
+		private:
 			Scripts::Position m_Position;
 			IToken*	m_Token = nullptr;
+			Type m_Type = Type::None;
+			Value m_Value;
+
+			// update the inline copies from the info
+			void Refresh();
 
 		public:
 			Token(Scripts::Position pos, IToken* tok) :
 				m_Position(pos),
 				m_Token(tok)
-			{ }
+			{ Refresh(); }
+			Token(const Token&) = default;
 			Token(const Token* ptr) : Token(*ptr)
 			{ }
-			Token(Token&& v) : m_Token(std::move(v.m_Token)), m_Position(v.m_Position)
+			Token(Token&& v) : m_Token(std::move(v.m_Token)), m_Position(v.m_Position), m_Type(v.m_Type), m_Value(v.m_Value)
 			{ }
 
 			inline Scripts::Position& GetPosition() { return m_Position; }
-			inline const Scripts::Position& GetPosition() const { return GetPosition(); }
+			inline const Scripts::Position& GetPosition() const { return m_Position; }
 
 			template<typename T>
 			inline T* GetToken() { return static_cast<T*>(m_Token); }
 			template<typename T>
 			inline const T* GetToken() const { return static_cast<T*>(m_Token); }
 
+			// the token info must be owned by the tokens storage (see Storage::Create)
 			template<typename T>
 			inline void SetToken(T tok) {
-				m_Token = tok;		// TODO: delete? but then what about copies?
+				m_Token = tok;
+				Refresh();
 			}
 			
 			inline IToken* GetToken() { return m_Token; }
-			inline const IToken* GetToken() const { return GetToken(); }
+			inline const IToken* GetToken() const { return m_Token; }
+
+			// Inline info //
+			inline Type GetType() const { return m_Type; }
+			inline bool IsType(Type type) const { return m_Type == type; }
+			inline long long GetInteger() const { return m_Value.Integer; }
+			inline float GetFloat() const { return m_Value.Float; }
+			template<typename T>
+			inline T GetEnum() const { return static_cast<T>(m_Value.Enum); }
 
 			inline operator IToken*() { return GetToken(); }
 			inline operator const IToken*() const { return GetToken(); }
@@ -80,29 +107,39 @@ namespace SCRambl
 			inline const IToken* operator->() const { return GetToken(); }
 		};
 
-		// Token container
+		// Token container - all token info lives in its arena and goes when the storage does
 		class Storage {
 		public:
 			typedef std::vector<Token> Vector;
 
 		private:
 			Vector m_Tokens;
+			Arena m_Arena;
 
 		public:
 			Storage() = default;
 			Storage(const Vector& vec) = delete;
-			~Storage() {
-				for (auto& tok : m_Tokens) {
-					if (tok.GetToken()) delete tok.GetToken();
-				}
-			}
 
 			// Manipulation //
 			template<typename TToken, typename... TArgs>
 			inline VecRef<Token> Add(Scripts::Position pos, TArgs&&... args) {
-				m_Tokens.emplace_back(pos, new TToken(args...));
+				m_Tokens.emplace_back(pos, Create<TToken>(args...));
 				return{ m_Tokens, m_Tokens.size() - 1 };
 			}
+			// Create token info owned by this storage (for Token::SetToken)
+			template<typename TToken, typename... TArgs>
+			inline TToken* Create(TArgs&&... args) {
+				return m_Arena.New<TToken>(args...);
+			}
+			// Move all tokens of another storage onto the end of this one (along with their info)
+			inline void Append(Storage& other) {
+				if (&other == this) return;
+				m_Tokens.reserve(m_Tokens.size() + other.m_Tokens.size());
+				for (auto& token : other.m_Tokens)
+					m_Tokens.emplace_back(std::move(token));
+				other.m_Tokens.clear();
+				m_Arena.Adopt(other.m_Arena);
+			}
 			// Navigation //
 			inline Iterator Begin() { return{ m_Tokens, m_Tokens.begin() }; }
 			inline Iterator End() { return{ m_Tokens, m_Tokens.end() }; }
@@ -116,6 +153,8 @@ namespace SCRambl
 			// Info //
 			inline size_t Size() const { return m_Tokens.size(); }
 			inline bool Empty() const { return m_Tokens.empty(); }
+			// Number of token infos allocated
+			inline size_t NumAllocations() const { return m_Arena.NumObjects(); }
 		};
 		// Token line vector
 		class Line {
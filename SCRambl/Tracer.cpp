@@ -0,0 +1,103 @@
+#include "stdafx.h"
+#include <iomanip>
+#include "Tracer.h"
+
+using namespace SCRambl;
+
+namespace {
+	void WriteJSONString(std::ostream& out, const std::string& str) {
+		static const char hex[] = "0123456789abcdef";
+		out << '"';
+		for (auto c : str) {
+			switch (c) {
+			case '"': out << "\\\""; break;
+			case '\\': out << "\\\\"; break;
+			case '\n': out << "\\n"; break;
+			case '\r': out << "\\r"; break;
+			case '\t': out << "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+					out << "\\u00" << hex[(c >> 4) & 0xF] << hex[c & 0xF];
+				else out << c;
+				break;
+			}
+		}
+		out << '"';
+	}
+}
+
+/* Tracer::Span */
+Tracer::Span::Span() : m_Tracer(nullptr), m_Category("")
+{ }
+Tracer::Span::Span(Tracer* tracer, const char* category, const std::string& name, const std::string& detail) : m_Tracer(nullptr) {
+	Begin(tracer, category, name, detail);
+}
+Tracer::Span::~Span() {
+	End();
+}
+void Tracer::Span::Begin(Tracer* tracer, const char* category, const std::string& name, const std::string& detail) {
+	End();
+	m_Tracer = tracer;
+	m_Category = category;
+	if (m_Tracer) {
+		m_Name = name;
+		m_Detail = detail;
+		m_Start = Clock::now();
+	}
+}
+void Tracer::Span::End() {
+	if (m_Tracer) {
+		m_Tracer->AddSpan(m_Category, std::move(m_Name), m_Start, Clock::now(), std::move(m_Detail));
+		m_Tracer = nullptr;
+	}
+}
+
+/* Tracer */
+Tracer::Tracer(std::string path) : m_Path(path), m_Start(Clock::now()) {
+	// whoever made the tracer is the build thread
+	m_Threads.emplace_back(std::this_thread::get_id());
+}
+void Tracer::AddSpan(const char* category, std::string name, Clock::time_point start, Clock::time_point end, std::string detail) {
+	Event event;
+	event.Category = category;
+	event.Name = std::move(name);
+	event.Detail = std::move(detail);
+	event.Start = std::chrono::duration<double, std::micro>(start - m_Start).count();
+	event.Duration = std::chrono::duration<double, std::micro>(end - start).count();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto id = std::this_thread::get_id();
+	auto it = std::find(m_Threads.begin(), m_Threads.end(), id);
+	if (it == m_Threads.end()) it = m_Threads.insert(m_Threads.end(), id);
+	event.Thread = (it - m_Threads.begin()) + 1;
+	m_Events.emplace_back(std::move(event));
+}
+bool Tracer::Save() const {
+	std::ofstream file(m_Path, std::ios::out | std::ios::trunc);
+	if (!file) return false;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	// name the threads - the first is the build thread, the rest are workers
+	for (size_t i = 1; i <= m_Threads.size(); ++i) {
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"name\":";
+		WriteJSONString(file, i == 1 ? "build" : "worker " + std::to_string(i - 1));
+		file << "}},\n";
+	}
+	file << std::fixed << std::setprecision(3);
+	for (auto& event : m_Events) {
+		file << "{\"name\":";
+		WriteJSONString(file, event.Name);
+		file << ",\"cat\":\"" << event.Category << "\",\"ph\":\"X\",\"ts\":" << event.Start << ",\"dur\":" << event.Duration
+			<< ",\"pid\":1,\"tid\":" << event.Thread;
+		if (!event.Detail.empty()) {
+			file << ",\"args\":{\"detail\":";
+			WriteJSONString(file, event.Detail);
+			file << "}";
+		}
+		file << "},\n";
+	}
+	// the format doesn't care for trailing commas, so finish on something
+	file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"SCRambl\"}}\n]}\n";
+	return !!file;
+}
@@ -0,0 +1,72 @@
+/**********************************************************/
+// SCRambl Advanced SCR Compiler/Assembler
+// This program is distributed freely under the MIT license
+// (See the LICENSE file provided
+//	 or copy at http://opensource.org/licenses/MIT)
+/**********************************************************/
+#pragma once
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace SCRambl
+{
+	// Records spans of time during a build and writes them out in the Chrome trace event format
+	// (open the file with chrome://tracing or ui.perfetto.dev) - spans can be added from any thread
+	class Tracer
+	{
+	public:
+		using Clock = std::chrono::high_resolution_clock;
+
+		// A span that lasts until it's ended or goes out of scope - it does nothing without a tracer
+		class Span {
+		public:
+			// A span that's yet to begin
+			Span();
+			Span(Tracer* tracer, const char* category, const std::string& name, const std::string& detail = "");
+			Span(const Span&) = delete;
+			~Span();
+
+			// Begin the span now (ending it first, if it's already begun) - the strings are only copied if there's a tracer
+			void Begin(Tracer* tracer, const char* category, const std::string& name, const std::string& detail = "");
+			// End the span now
+			void End();
+			inline bool IsActive() const { return m_Tracer != nullptr; }
+
+		private:
+			Tracer* m_Tracer;
+			const char* m_Category;
+			std::string m_Name;
+			std::string m_Detail;
+			Clock::time_point m_Start;
+		};
+
+	public:
+		Tracer(std::string path);
+
+		// Add a span that's already over
+		void AddSpan(const char* category, std::string name, Clock::time_point start, Clock::time_point end, std::string detail = "");
+
+		// Write everything recorded so far to the trace file
+		bool Save() const;
+		inline const std::string& GetPath() const { return m_Path; }
+
+	private:
+		struct Event {
+			const char* Category;
+			std::string Name;
+			std::string Detail;
+			double Start;						// microseconds since the tracer was made
+			double Duration;
+			size_t Thread;
+		};
+
+		std::string m_Path;
+		Clock::time_point m_Start;
+		mutable std::mutex m_Mutex;
+		std::vector<Event> m_Events;
+		std::vector<std::thread::id> m_Threads;	// numbered from 1, the build thread first
+	};
+}
@@ -266,6 +266,8 @@ namespace SCRambl
 		public:
 			using Vector = std::vector<std::unique_ptr<ITypeRef>>;
 			using Map = std::unordered_map<std::string, size_t>;
+			// names by hash, so they can be looked up straight from the code
+			using HashMap = std::unordered_multimap<uint_fast32_t, const Map::value_type*>;
 
 			Storage() { }
 
@@ -307,6 +309,16 @@ namespace SCRambl
 				auto it = m_Map.find(name);
 				return it != m_Map.end() ? Get<T>(it->second) : nullptr;
 			}
+			template<typename T = Type>
+			inline TypeRef<T> Get(const char* name, size_t size) {
+				auto range = m_Hashes.equal_range(GenerateHash(name, size));
+				for (auto it = range.first; it != range.second; ++it) {
+					auto& key = it->second->first;
+					if (key.size() == size && !key.compare(0, size, name, size))
+						return Get<T>(it->second->second);
+				}
+				return nullptr;
+			}
 			size_t GetSize() const {
 				return m_Vector.size();
 			}
@@ -327,12 +339,14 @@ namespace SCRambl
 			template<typename T>
 			TypeRef<T>& Add(std::string name, std::vector<T>& ref) {
 				m_Vector.emplace_back(std::make_unique<TypeRef<T>>(VecRef<T>(ref)));
-				m_Map.emplace(name, m_Vector.size() - 1);
+				auto pr = m_Map.emplace(name, m_Vector.size() - 1);
+				if (pr.second) m_Hashes.emplace(GenerateHash(name.data(), name.size()), &*pr.first);
 				return static_cast<TypeRef<T>&>(*m_Vector.back());
 			}
 
 		private:
 			Map m_Map;
+			HashMap m_Hashes;
 			Vector m_Vector;
 			std::vector<Basic> m_Basics;
 			std::vector<Extended> m_Extendeds;
@@ -759,6 +773,9 @@ namespace SCRambl
 			}
 			template<typename T = Type, typename K = std::string>
 			inline TypeRef<T> GetType(K id) { return m_Types.Get<T>(id); }
+			// Get a type by a name that's not in a string of its own (e.g. straight from the code)
+			template<typename T = Type>
+			inline TypeRef<T> GetType(const char* name, size_t size) { return m_Types.Get<T>(name, size); }
 			inline void AddValue(ValueSet valtype, Value* value) {
 				m_Values.emplace(valtype, value);
 			}
@@ -35,6 +35,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string>
+#include <string.h>
 #include <typeindex>
 #include <typeinfo>
 #include <unordered_map>
@@ -9,6 +9,12 @@
 #include <assert.h>
 #include <algorithm>
 #include <functional>
+#include <cctype>
+#include <limits.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <fstream>
+#include <initializer_list>
 #include <sys/types.h>
 #include <sys/stat.h>
 #ifdef _WIN32
@@ -334,6 +340,56 @@ namespace SCRambl {
 	inline std::string GetFilePathExtension(const std::string& path) {
 		return path.substr(GetFilePathExtensionPos(path));
 	}
+	// Modification time (as finely as the system keeps it, so saves within a second still differ) and size of a file - returns false if it can't be found
+	inline bool GetFileInfo(const std::string& path, uint64_t& time, uint64_t& size) {
+#ifdef _WIN32
+		WIN32_FILE_ATTRIBUTE_DATA fi;
+		if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &fi)) return false;
+		time = (static_cast<uint64_t>(fi.ftLastWriteTime.dwHighDateTime) << 32) | fi.ftLastWriteTime.dwLowDateTime;
+		size = (static_cast<uint64_t>(fi.nFileSizeHigh) << 32) | fi.nFileSizeLow;
+#else
+		struct stat st;
+		if (stat(path.c_str(), &st)) return false;
+#ifdef __APPLE__
+		time = static_cast<uint64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+		time = static_cast<uint64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+		size = static_cast<uint64_t>(st.st_size);
+#endif
+		return true;
+	}
+	// Full path of a file with any '.' and '..' worked out, so it's the same however it was got to - returns the path as it is if it can't be found
+	inline std::string GetCanonicalPath(const std::string& path) {
+#ifdef _WIN32
+		char buf[MAX_PATH];
+		if (!_fullpath(buf, path.c_str(), MAX_PATH)) return path;
+		// case doesn't matter here
+		std::string str = buf;
+		std::transform(str.begin(), str.end(), str.begin(), [](char c){ return c == '/' ? '\\' : static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+		return str;
+#else
+		char buf[PATH_MAX];
+		if (!realpath(path.c_str(), buf)) return path;
+		return buf;
+#endif
+	}
+	// Write the parts out as a whole file - it's written somewhere else first and moved over, so a half-written one is never picked up
+	inline bool SaveFile(const std::string& path, std::initializer_list<const std::string*> parts) {
+		auto tmp_path = path + ".tmp";
+		{
+			std::ofstream file(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!file) return false;
+			for (auto part : parts)
+				file.write(part->data(), part->size());
+			if (!file) return false;
+		}
+		remove(path.c_str());
+		return rename(tmp_path.c_str(), path.c_str()) == 0;
+	}
+	inline bool SaveFile(const std::string& path, const std::string& data) {
+		return SaveFile(path, { &data });
+	}
 
 #ifdef _WIN32
 	inline uint64_t JoinInt32(uint32_t high, uint32_t low)
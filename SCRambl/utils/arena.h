@@ -0,0 +1,128 @@
+/**********************************************************/
+// SCRambl Advanced SCR Compiler/Assembler
+// This program is distributed freely under the MIT license
+// (See the LICENSE file provided
+//	 or copy at http://opensource.org/licenses/MIT)
+/**********************************************************/
+#pragma once
+#include <stddef.h>
+#include <new>
+#include <vector>
+#include <type_traits>
+#include <utility>
+
+namespace SCRambl
+{
+	/*\
+	 - Arena - bump allocator that hands out memory from big blocks and frees it all in one go
+	 - Objects with destructors are remembered and destroyed (newest first) when the arena is cleared
+	\*/
+	class Arena {
+		// remembers an object that needs destroying
+		struct Destructor {
+			void(*destroy)(void*);
+			void* object;
+			Destructor* next;
+		};
+
+	public:
+		Arena(size_t block_size = 0x10000) : m_BlockSize(block_size)
+		{ }
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+		~Arena() {
+			Clear();
+		}
+
+		// Allocate raw memory - it's only given back when the arena is cleared
+		void* Allocate(size_t size, size_t align) {
+			auto mask = align - 1;
+			auto offset = (m_Offset + mask) & ~mask;
+			if (offset + size > m_BlockEnd) {
+				// anything too big for a block gets one to itself, leaving the current block be
+				if (size + mask > m_BlockSize) {
+					auto block = new char[size + mask];
+					m_Blocks.push_back(block);
+					m_Used += size;
+					return reinterpret_cast<void*>((reinterpret_cast<size_t>(block) + mask) & ~mask);
+				}
+				m_Blocks.push_back(new char[m_BlockSize]);
+				m_Offset = reinterpret_cast<size_t>(m_Blocks.back());
+				m_BlockEnd = m_Offset + m_BlockSize;
+				offset = (m_Offset + mask) & ~mask;
+			}
+			m_Offset = offset + size;
+			m_Used += size;
+			return reinterpret_cast<void*>(offset);
+		}
+
+		// Construct an object in the arena
+		template<typename T, typename... TArgs>
+		T* New(TArgs&&... args) {
+			++m_Objects;
+			auto ptr = new (Allocate(sizeof(T), std::alignment_of<T>::value)) T(std::forward<TArgs>(args)...);
+			if (!std::is_trivially_destructible<T>::value) {
+				auto dtor = static_cast<Destructor*>(Allocate(sizeof(Destructor), std::alignment_of<Destructor>::value));
+				dtor->destroy = &Destroy<T>;
+				dtor->object = ptr;
+				dtor->next = m_Destructors;
+				m_Destructors = dtor;
+			}
+			return ptr;
+		}
+
+		// Destroy everything and free all the blocks
+		void Clear() {
+			for (auto dtor = m_Destructors; dtor; dtor = dtor->next)
+				dtor->destroy(dtor->object);
+			m_Destructors = nullptr;
+			for (auto block : m_Blocks)
+				delete[] block;
+			m_Blocks.clear();
+			m_Offset = m_BlockEnd = 0;
+			m_Used = 0;
+			m_Objects = 0;
+		}
+
+		// Take over everything another arena has handed out - it's left empty
+		void Adopt(Arena& other) {
+			if (&other == this) return;
+			m_Blocks.insert(m_Blocks.end(), other.m_Blocks.begin(), other.m_Blocks.end());
+			if (auto dtor = other.m_Destructors) {
+				// theirs were made later, so they go first
+				while (dtor->next) dtor = dtor->next;
+				dtor->next = m_Destructors;
+				m_Destructors = other.m_Destructors;
+			}
+			m_Used += other.m_Used;
+			m_Objects += other.m_Objects;
+			other.m_Blocks.clear();
+			other.m_Destructors = nullptr;
+			other.m_Offset = other.m_BlockEnd = 0;
+			other.m_Used = 0;
+			other.m_Objects = 0;
+		}
+
+		// Bytes handed out so far
+		inline size_t Used() const { return m_Used; }
+		// Number of blocks allocated
+		inline size_t NumBlocks() const { return m_Blocks.size(); }
+		// Number of objects constructed so far
+		inline size_t NumObjects() const { return m_Objects; }
+
+	private:
+		template<typename T>
+		static void Destroy(void* ptr) {
+			static_cast<T*>(ptr)->~T();
+		}
+
+	private:
+		size_t m_BlockSize;
+		std::vector<char*> m_Blocks;
+		size_t m_Offset = 0;
+		size_t m_BlockEnd = 0;
+		size_t m_Used = 0;
+		size_t m_Objects = 0;
+		Destructor* m_Destructors = nullptr;
+	};
+}
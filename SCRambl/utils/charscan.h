@@ -0,0 +1,185 @@
+/**********************************************************/
+// SCRambl Advanced SCR Compiler/Assembler
+// This program is distributed freely under the MIT license
+// (See the LICENSE file provided
+//	 or copy at http://opensource.org/licenses/MIT)
+/**********************************************************/
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+	#define SCRAMBL_SIMD_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SCRAMBL_SIMD_SSE2
+#endif
+
+#ifdef SCRAMBL_SIMD_AVX2
+	#include <immintrin.h>
+#endif
+#ifdef SCRAMBL_SIMD_SSE2
+	#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+namespace SCRambl
+{
+	namespace CharScan
+	{
+		// Index of the lowest set bit (v must be non-zero)
+		inline unsigned LowestBit(uint32_t v) {
+#ifdef _MSC_VER
+			unsigned long idx;
+			_BitScanForward(&idx, v);
+			return idx;
+#else
+			return __builtin_ctz(v);
+#endif
+		}
+
+		/*\
+		 - CharScan::Match<...> - a set of characters to look for
+		 - Gives a byte mask for 1, 16 or 32 characters at a time
+		\*/
+		template<char... TChars>
+		struct Match;
+		template<>
+		struct Match<> {
+			static inline bool Scalar(char) { return false; }
+#ifdef SCRAMBL_SIMD_SSE2
+			static inline __m128i SSE2(__m128i) { return _mm_setzero_si128(); }
+#endif
+#ifdef SCRAMBL_SIMD_AVX2
+			static inline __m256i AVX2(__m256i) { return _mm256_setzero_si256(); }
+#endif
+		};
+		template<char TChar, char... TRest>
+		struct Match<TChar, TRest...> {
+			static inline bool Scalar(char c) {
+				return c == TChar || Match<TRest...>::Scalar(c);
+			}
+#ifdef SCRAMBL_SIMD_SSE2
+			static inline __m128i SSE2(__m128i block) {
+				return _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(TChar)), Match<TRest...>::SSE2(block));
+			}
+#endif
+#ifdef SCRAMBL_SIMD_AVX2
+			static inline __m256i AVX2(__m256i block) {
+				return _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(TChar)), Match<TRest...>::AVX2(block));
+			}
+#endif
+		};
+
+		/*\
+		 - Calls func(offset) for each character of the data in the set, in order
+		 - Stops early if func returns false
+		\*/
+		template<typename TSet, typename TFunc>
+		inline void ForEachScalar(const char* data, size_t size, TFunc func, size_t i = 0) {
+			for (; i < size; ++i) {
+				if (TSet::Scalar(data[i]) && !func(i))
+					return;
+			}
+		}
+		template<typename TSet, typename TFunc>
+		inline void ForEach(const char* data, size_t size, TFunc func) {
+			size_t i = 0;
+#ifdef SCRAMBL_SIMD_AVX2
+			for (; i + 32 <= size; i += 32) {
+				auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+				auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(TSet::AVX2(block)));
+				for (; mask; mask &= mask - 1) {
+					if (!func(i + LowestBit(mask))) return;
+				}
+			}
+#endif
+#ifdef SCRAMBL_SIMD_SSE2
+			for (; i + 16 <= size; i += 16) {
+				auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+				auto mask = static_cast<uint32_t>(_mm_movemask_epi8(TSet::SSE2(block)));
+				for (; mask; mask &= mask - 1) {
+					if (!func(i + LowestBit(mask))) return;
+				}
+			}
+#endif
+			ForEachScalar<TSet>(data, size, func, i);
+		}
+
+		/*\
+		 - ASCII case folding - only the letters a-z and A-Z change, anything else (UTF-8 included) is left be
+		 - Doesn't depend on the locale, unlike std::toupper
+		\*/
+		inline char ToUpper(char c) { return c >= 'a' && c <= 'z' ? c - ('a' - 'A') : c; }
+		inline char ToLower(char c) { return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c; }
+		// Four characters at once, upper-cased
+		inline uint32_t ToUpper4(uint32_t x) {
+			// the top bit of each byte ends up set if it's a-z (no byte carries into the next)
+			auto heptets = x & 0x7F7F7F7F;
+			auto lower = ((heptets + 0x1F1F1F1F) ^ (heptets + 0x05050505)) & ~x & 0x80808080;
+			return x ^ (lower >> 2);
+		}
+#ifdef SCRAMBL_SIMD_SSE2
+		// Sixteen characters at once, with the case of those between first and last flipped (bytes over 0x7F are negative, so never in range)
+		inline __m128i FlipCaseSSE2(__m128i block, char first, char last) {
+			auto in_range = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(first - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8(last + 1)));
+			return _mm_xor_si128(block, _mm_and_si128(in_range, _mm_set1_epi8(0x20)));
+		}
+#endif
+
+		/*\ Upper or lower-case the data in place \*/
+		inline void FoldCase(char* data, size_t size, bool upper) {
+			size_t i = 0;
+			auto first = upper ? 'a' : 'A', last = upper ? 'z' : 'Z';
+#ifdef SCRAMBL_SIMD_SSE2
+			for (; i + 16 <= size; i += 16) {
+				auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), FlipCaseSSE2(block, first, last));
+			}
+#endif
+			for (; i < size; ++i) {
+				if (data[i] >= first && data[i] <= last)
+					data[i] ^= 0x20;
+			}
+		}
+
+		/*\ Returns true if the data, upper-cased, is the same as 'upper' (which already is) \*/
+		inline bool EqualsUpper(const char* data, const char* upper, size_t size) {
+			size_t i = 0;
+#ifdef SCRAMBL_SIMD_SSE2
+			for (; i + 16 <= size; i += 16) {
+				auto block = FlipCaseSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), 'a', 'z');
+				auto other = _mm_loadu_si128(reinterpret_cast<const __m128i*>(upper + i));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi8(block, other)) != 0xFFFF) return false;
+			}
+#endif
+			for (; i + 4 <= size; i += 4) {
+				uint32_t a, b;
+				memcpy(&a, data + i, 4);
+				memcpy(&b, upper + i, 4);
+				if (ToUpper4(a) != b) return false;
+			}
+			for (; i < size; ++i) {
+				if (ToUpper(data[i]) != upper[i]) return false;
+			}
+			return true;
+		}
+
+		/*\ Returns the offset of the first character in the set, or size if there isn't one \*/
+		template<typename TSet>
+		inline size_t FindScalar(const char* data, size_t size) {
+			size_t r = size;
+			ForEachScalar<TSet>(data, size, [&r](size_t i){ r = i; return false; });
+			return r;
+		}
+		template<typename TSet>
+		inline size_t Find(const char* data, size_t size) {
+			size_t r = size;
+			ForEach<TSet>(data, size, [&r](size_t i){ r = i; return false; });
+			return r;
+		}
+	}
+}
@@ -24,4 +24,10 @@ namespace SCRambl
 		MurmurHash3_x86_32(buf, size, 0x88664422, &dw);
 		return dw;
 	}
+
+	// Are two 128-bit hashes (as the caches keep of files) the same?
+	inline bool SameHash(const uint64_t (&a)[2], const uint64_t (&b)[2])
+	{
+		return a[0] == b[0] && a[1] == b[1];
+	}
 }
\ No newline at end of file
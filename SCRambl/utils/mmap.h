@@ -0,0 +1,101 @@
+/**********************************************************/
+// SCRambl Advanced SCR Compiler/Assembler
+// This program is distributed freely under the MIT license
+// (See the LICENSE file provided
+//	 or copy at http://opensource.org/licenses/MIT)
+/**********************************************************/
+#pragma once
+#include <string>
+#ifdef _WIN32
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+namespace SCRambl
+{
+	// Read-only view of a whole file mapped into memory
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		MappedFile(const std::string& path) {
+			Open(path);
+		}
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile() {
+			Close();
+		}
+
+		bool Open(const std::string& path) {
+			Close();
+#ifdef _WIN32
+			m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (m_File == INVALID_HANDLE_VALUE) return false;
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(m_File, &size)) {
+				Close();
+				return false;
+			}
+			m_Size = static_cast<size_t>(size.QuadPart);
+			m_Open = true;
+			// can't map an empty file, but there's nothing to map anyway
+			if (!m_Size) return true;
+			m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (m_Mapping) m_Data = static_cast<const char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+			m_File = open(path.c_str(), O_RDONLY);
+			if (m_File == -1) return false;
+			struct stat st;
+			if (fstat(m_File, &st) == -1) {
+				Close();
+				return false;
+			}
+			m_Size = static_cast<size_t>(st.st_size);
+			m_Open = true;
+			if (!m_Size) return true;
+			auto data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_File, 0);
+			if (data != MAP_FAILED) {
+				m_Data = static_cast<const char*>(data);
+				madvise(data, m_Size, MADV_SEQUENTIAL);
+			}
+#endif
+			if (!m_Data) Close();
+			return m_Open;
+		}
+		void Close() {
+#ifdef _WIN32
+			if (m_Data) UnmapViewOfFile(m_Data);
+			if (m_Mapping) CloseHandle(m_Mapping);
+			if (m_File != INVALID_HANDLE_VALUE) CloseHandle(m_File);
+			m_Mapping = nullptr;
+			m_File = INVALID_HANDLE_VALUE;
+#else
+			if (m_Data) munmap(const_cast<char*>(m_Data), m_Size);
+			if (m_File != -1) close(m_File);
+			m_File = -1;
+#endif
+			m_Data = nullptr;
+			m_Size = 0;
+			m_Open = false;
+		}
+
+		inline bool IsOpen() const { return m_Open; }
+		inline const char* Data() const { return m_Data; }
+		inline size_t Size() const { return m_Size; }
+
+	private:
+#ifdef _WIN32
+		HANDLE m_File = INVALID_HANDLE_VALUE;
+		HANDLE m_Mapping = nullptr;
+#else
+		int m_File = -1;
+#endif
+		const char* m_Data = nullptr;
+		size_t m_Size = 0;
+		bool m_Open = false;
+	};
+}
@@ -0,0 +1,180 @@
+/**********************************************************/
+// SCRambl Advanced SCR Compiler/Assembler
+// This program is distributed freely under the MIT license
+// (See the LICENSE file provided
+//	 or copy at http://opensource.org/licenses/MIT)
+/**********************************************************/
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "MurmurHash3.h"
+#include "charscan.h"
+
+namespace SCRambl
+{
+	/*\
+	 - PerfectHash - minimal perfect hash over a fixed set of strings, built by 'hash and displace'
+	 - Each string hashes into a bucket, and each bucket has a displacement that puts all of its strings in free slots
+	 - A lookup is a hash, a displacement and a slot - the string is checked, so ones that weren't given are turned away
+	 - Can ignore (ASCII) case, in which case strings are hashed and checked as if upper-cased, without copying them
+	\*/
+	class PerfectHash {
+		struct Slot {
+			uint32_t Hash;
+			uint32_t Offset;					// where the string is in m_Strings
+			uint32_t Size;
+			uint32_t Index;						// where the string was given
+		};
+
+	public:
+		static const uint32_t npos = ~0u;
+
+		PerfectHash() = default;
+
+		// Build over the strings, which have to be unique (ignoring case, if it is) - each is found at the index it was given at
+		void Build(const std::vector<std::string>& keys, bool ignore_case = false) {
+			Clear();
+			m_IgnoreCase = ignore_case;
+			if (keys.empty()) return;
+
+			const auto num = static_cast<uint32_t>(keys.size());
+			std::vector<uint32_t> hashes(num);
+			std::vector<std::vector<uint32_t>> buckets((num + 3) / 4);
+			std::vector<bool> taken(num);
+			std::vector<uint32_t> slots;
+
+			// a bad seed can leave two strings unable to part ways - try another if it does
+			for (uint32_t seed = 0x5C4A3B1; ; seed = Mix(seed + 1)) {
+				m_Seed = seed;
+				m_Displace.assign(buckets.size(), 0);
+				m_Slots.assign(num, Slot());
+				for (auto& bucket : buckets) bucket.clear();
+				for (uint32_t i = 0; i < num; ++i) {
+					hashes[i] = Hash(keys[i].data(), keys[i].size());
+					buckets[hashes[i] % buckets.size()].push_back(i);
+				}
+
+				// biggest buckets first, while there's the most room
+				std::vector<uint32_t> order(buckets.size());
+				for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+				std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t a, uint32_t b){
+					return buckets[a].size() > buckets[b].size();
+				});
+
+				std::fill(taken.begin(), taken.end(), false);
+				bool ok = true;
+				for (auto b : order) {
+					auto& bucket = buckets[b];
+					if (bucket.empty()) break;
+
+					uint32_t displace = 0;
+					for (; displace < max_displace; ++displace) {
+						slots.clear();
+						for (auto i : bucket) {
+							auto slot = SlotOf(hashes[i], displace);
+							if (taken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) break;
+							slots.push_back(slot);
+						}
+						if (slots.size() == bucket.size()) break;
+					}
+					if (displace == max_displace) {
+						ok = false;
+						break;
+					}
+
+					m_Displace[b] = displace;
+					for (size_t j = 0; j < bucket.size(); ++j) {
+						taken[slots[j]] = true;
+						auto& slot = m_Slots[slots[j]];
+						slot.Hash = hashes[bucket[j]];
+						slot.Index = bucket[j];
+					}
+				}
+				if (ok) break;
+			}
+
+			// strings go in the order of their slots, so a lookup only goes near the one it wants
+			for (auto& slot : m_Slots) {
+				auto& key = keys[slot.Index];
+				slot.Offset = static_cast<uint32_t>(m_Strings.size());
+				slot.Size = static_cast<uint32_t>(key.size());
+				m_Strings += key;
+				if (m_IgnoreCase) CharScan::FoldCase(&m_Strings[slot.Offset], slot.Size, true);
+			}
+		}
+		void Clear() {
+			m_Displace.clear();
+			m_Slots.clear();
+			m_Strings.clear();
+		}
+
+		// Index the string was given at, or npos if it wasn't
+		inline uint32_t Find(const char* str, size_t size) const {
+			if (m_Slots.empty()) return npos;
+			auto hash = Hash(str, size);
+			auto& slot = m_Slots[SlotOf(hash, m_Displace[hash % m_Displace.size()])];
+			if (slot.Hash != hash || slot.Size != size) return npos;
+			if (m_IgnoreCase ? !CharScan::EqualsUpper(str, m_Strings.data() + slot.Offset, size) : memcmp(m_Strings.data() + slot.Offset, str, size) != 0)
+				return npos;
+			return slot.Index;
+		}
+		inline uint32_t Find(const std::string& str) const { return Find(str.data(), str.size()); }
+
+		inline size_t Size() const { return m_Slots.size(); }
+		inline bool Empty() const { return m_Slots.empty(); }
+		inline bool IsCaseIgnored() const { return m_IgnoreCase; }
+
+	private:
+		enum { max_displace = 1 << 16 };
+
+		// MurmurHash3 finaliser - spreads the bits of a hash
+		static inline uint32_t Mix(uint32_t h) {
+			h ^= h >> 16;
+			h *= 0x85EBCA6B;
+			h ^= h >> 13;
+			h *= 0xC2B2AE35;
+			h ^= h >> 16;
+			return h;
+		}
+		inline uint32_t Hash(const char* str, size_t size) const {
+			if (m_IgnoreCase) return HashUpper(str, size, m_Seed);
+			uint32_t hash;
+			MurmurHash3_x86_32(str, static_cast<int>(size), m_Seed, &hash);
+			return hash;
+		}
+		// MurmurHash3 (x86, 32-bit) of the string upper-cased, folding each block as it's read
+		static uint32_t HashUpper(const char* str, size_t size, uint32_t seed) {
+			const uint32_t c1 = 0xCC9E2D51, c2 = 0x1B873593;
+			auto rotl = [](uint32_t x, int r){ return (x << r) | (x >> (32 - r)); };
+			uint32_t h = seed;
+			size_t i = 0;
+			for (; i + 4 <= size; i += 4) {
+				uint32_t k;
+				memcpy(&k, str + i, 4);
+				k = CharScan::ToUpper4(k) * c1;
+				h ^= rotl(k, 15) * c2;
+				h = rotl(h, 13) * 5 + 0xE6546B64;
+			}
+			uint32_t k = 0;
+			switch (size & 3) {
+			case 3: k ^= static_cast<uint8_t>(CharScan::ToUpper(str[i + 2])) << 16;
+			case 2: k ^= static_cast<uint8_t>(CharScan::ToUpper(str[i + 1])) << 8;
+			case 1: k ^= static_cast<uint8_t>(CharScan::ToUpper(str[i]));
+				h ^= rotl(k * c1, 15) * c2;
+			}
+			return Mix(h ^ static_cast<uint32_t>(size));
+		}
+		inline uint32_t SlotOf(uint32_t hash, uint32_t displace) const {
+			return Mix(hash + displace * 0x9E3779B9) % static_cast<uint32_t>(m_Slots.size());
+		}
+
+		uint32_t m_Seed = 0;
+		bool m_IgnoreCase = false;
+		std::vector<uint32_t> m_Displace;		// by bucket
+		std::vector<Slot> m_Slots;
+		std::string m_Strings;
+	};
+}